@@ -0,0 +1,150 @@
+/*CXXR $Id$
+ *CXXR
+ *CXXR This file is part of CXXR, a project to refactor the R interpreter
+ *CXXR into C++.  It may consist in whole or in part of program code and
+ *CXXR documentation taken from the R project itself, incorporated into
+ *CXXR CXXR (and possibly MODIFIED) under the terms of the GNU General Public
+ *CXXR Licence.
+ *CXXR
+ *CXXR CXXR is Copyright (C) 2008-14 Andrew R. Runnalls, subject to such other
+ *CXXR copyrights and copyright restrictions as may be stated below.
+ *CXXR
+ *CXXR CXXR is not part of the R project, and bugs and other issues should
+ *CXXR not be reported via r-bugs or other R project channels; instead refer
+ *CXXR to the CXXR website.
+ *CXXR */
+
+/** @file AllocationProfiler.hpp
+ *
+ * @brief Class CXXR::AllocationProfiler.
+ */
+
+#ifndef ALLOCATIONPROFILER_HPP
+#define ALLOCATIONPROFILER_HPP
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+#include "CXXR/SEXPTYPE.h"
+
+namespace CXXR {
+    /** @brief Sampling profiler of memory allocation.
+     *
+     * While the profiler is running, it uses
+     * MemoryBank::setSampler() to sample the memory blocks
+     * allocated by the main thread, one for every \a interval bytes
+     * allocated.  For each sampled block it notes the block's
+     * size and size class, the R call stack at the point of
+     * allocation and, where the block turns out to hold an RObject
+     * or the data of a FixedVector, the SEXPTYPE concerned.
+     *
+     * Samples with the same call stack, size class and type are
+     * aggregated as they are taken, so the memory used by the
+     * profiler grows with the number of distinct stacks rather
+     * than with the duration of profiling.  The aggregated samples
+     * are accumulated until retrieved by takeSamples().  This
+     * class only has static members.
+     */
+    class AllocationProfiler {
+    public:
+	/** @brief Record of sampled allocations.
+	 *
+	 * Aggregates the sampled allocations with a particular call
+	 * stack, size class and type.
+	 */
+	struct Sample {
+	    std::size_t count;  // Number of allocations sampled.
+	    std::size_t bytes;  // Total size of the sampled blocks
+	      // in bytes.
+	    int size_class;  // As reported by MemoryBank::sizeClass().
+	    int type;  // SEXPTYPE of the object (or vector data)
+	      // occupying the blocks, or -1 if not known.
+	    std::size_t weight;  // Estimated number of bytes
+	      // allocated represented by these samples: the sampling
+	      // interval multiplied by the number of intervals passed
+	      // during the sampled allocations.
+	    std::string stack;  // Names of the R functions on the
+	      // call stack, outermost first, separated by semicolons.
+	};
+
+	/** @brief Sampling interval.
+	 *
+	 * @return The sampling interval in bytes, or zero if the
+	 * profiler is not running.
+	 */
+	static std::size_t interval()
+	{
+	    return s_interval;
+	}
+
+	/** @brief Note the type of a newly allocated block.
+	 *
+	 * This function should be called immediately after a block
+	 * of memory has been allocated via MemoryBank to hold an
+	 * RObject, or the data of a vector, before any further
+	 * memory is allocated.  If the block is the one most
+	 * recently sampled, the sample is attributed to \a type.
+	 *
+	 * @param block Pointer to the start of the block.
+	 *
+	 * @param type Type of the object occupying the block.
+	 */
+	static void noteType(const void* block, SEXPTYPE type)
+	{
+	    if (block == s_pending)
+		setPendingType(type);
+	}
+
+	/** @brief Start or stop profiling.
+	 *
+	 * Samples accumulated by any previous run of the profiler
+	 * that have not been retrieved by takeSamples() are retained.
+	 *
+	 * @param interval Sampling interval in bytes.  If zero, the
+	 *          profiler is stopped.
+	 */
+	static void start(std::size_t interval);
+
+	/** @brief Retrieve the accumulated samples.
+	 *
+	 * @param dest Non-null pointer to a vector into which the
+	 *          samples accumulated since the last call to this
+	 *          function are moved, ordered by call stack.  Any
+	 *          previous contents of the vector are discarded.
+	 */
+	static void takeSamples(std::vector<Sample>* dest);
+    private:
+	// Mapping from call stacks to the aggregated samples having
+	// that stack, one for each combination of size class and
+	// type encountered:
+	typedef std::map<std::string, std::vector<Sample> > Aggregate;
+
+	static std::size_t s_interval;
+	static Aggregate s_aggregate;
+	static Sample s_latest;  // The sample most recently taken,
+	  // not yet added to s_aggregate.  (Its type may yet be
+	  // noted.)  Not valid if s_latest.count is zero.
+	static const void* s_pending;  // Address of the block most
+	  // recently sampled, if its type has yet to be noted.
+	static std::size_t s_pending_bytes;  // The value of
+	  // MemoryBank::bytesAllocated() just after the pending block
+	  // was allocated.  Used to confirm that no other allocation
+	  // has intervened before the type is noted.
+
+	// Not implemented.  Declared to stop the compiler generating
+	// a constructor.
+	AllocationProfiler();
+
+	// Callback passed to MemoryBank::setSampler():
+	static void sample(void* block, std::size_t bytes,
+			   unsigned int count);
+
+	// Add s_latest, if valid, to s_aggregate:
+	static void aggregateLatest();
+
+	static void setPendingType(SEXPTYPE type);
+    };
+}  // namespace CXXR
+
+#endif  // ALLOCATIONPROFILER_HPP
@@ -62,15 +62,48 @@ namespace CXXR {
 	enum Status {
 	    RAW,       /**< Unprocessed. */
 	    PROMISED,  /**< Argument values are wrapped in Promise
-			* objects, and non-null tags have been coerced
-			* to Symbols.  This is the form expected by
-			* ArgMatcher::match().
+			* objects (except as permitted by the Elision
+			* argument of wrapInPromises()), and non-null
+			* tags have been coerced to Symbols.  This is
+			* the form expected by ArgMatcher::match().
 			*/
 	    EVALUATED  /**< Argument values have been evaluated, and
 			* ... arguments expanded.
 			*/
 	};
 
+	/** @brief Extent to which wrapInPromises() may dispense with
+	 * Promise objects.
+	 */
+	enum Elision {
+	    WRAP_ALL,         /**< Wrap every argument in a Promise. */
+	    ELIDE_CONSTANTS,  /**< Arguments which are self-evaluating
+			       * constants (such as numeric or string
+			       * literals) are bound to the PROMISED
+			       * list directly.
+			       */
+	    ELIDE_LOOKUPS     /**< As ELIDE_CONSTANTS.  In addition,
+			       * if every argument is either a
+			       * self-evaluating constant or a Symbol
+			       * whose value is available without
+			       * evaluating anything (e.g. one not
+			       * bound to an unforced Promise), and
+			       * every such value is an atomic vector
+			       * that is not an object and has no
+			       * attributes other than names, dim and
+			       * dimnames, then Symbol arguments are
+			       * replaced by their values.  This is
+			       * appropriate only if the function
+			       * called is known to force all its
+			       * arguments before doing anything
+			       * else, and neither to examine the
+			       * Promises itself, e.g. via
+			       * substitute(), nor to allow other
+			       * code to do so: see
+			       * Closure::strict().
+			       */
+	};
+
 	/** @brief Constructor.
 	 *
 	 * @param args Pointer, possibly null, to a PairList of
@@ -302,13 +335,19 @@ namespace CXXR {
 	 *          env must be identical to the \a env argument of
 	 *          that firstArg() call.
 	 *
+	 * @param elision Extent to which arguments may be placed in
+	 *          the output list without being wrapped in a
+	 *          Promise.  The default is to wrap every argument,
+	 *          because some callers of this function assume that
+	 *          every element of the resulting list is a Promise.
+	 *
 	 * @note It would be desirable to avoid producing a new
 	 * PairList, and to absorb this functionality directly into
 	 * the ArgMatcher::match() function.  But at present the
 	 * Promise-wrapped list is recorded in the context set up by
 	 * Closure::apply(), and used for other purposes.
 	 */
-	void wrapInPromises(Environment* env);
+	void wrapInPromises(Environment* env, Elision elision = WRAP_ALL);
     private:
 	const PairList* const m_orig_list;  // Pointer to the argument
 	  // list supplied to the constructor. 
@@ -63,6 +63,12 @@ namespace CXXR {
      *
      * The class also provides other services relating to the formal
      * arguments and their default values.
+     *
+     * Having matched a list of supplied arguments, match() records
+     * the outcome as a plan keyed by the sequence of tags of the
+     * supplied arguments.  Subsequent calls with the same tag
+     * sequence, which is typical of repeated calls from the same
+     * call site, then follow the plan directly.
      */
     class ArgMatcher : public GCNode {
     public:
@@ -274,6 +280,25 @@ namespace CXXR {
 
 	enum MatchStatus {UNMATCHED = 0, EXACT_TAG, PARTIAL_TAG, POSITIONAL};
 
+	// Record of how supplied arguments with a particular sequence
+	// of tags were matched to the formals:
+	struct MatchPlan {
+	    // Tags of the supplied arguments (null if untagged):
+	    std::vector<const Symbol*> tags;
+	    // Bindings to be made, in order, as pairs comprising the
+	    // index within m_formal_data of the formal and the
+	    // index of the supplied argument bound to it, or -1 if
+	    // the formal is unmatched:
+	    std::vector<std::pair<unsigned int, int> > bindings;
+	    // Indices of the supplied arguments (if any) that go into
+	    // '...', in order:
+	    std::vector<unsigned int> dots;
+	    bool partial;  // true if any tag was partially matched.
+	};
+
+	// Maximum number of plans retained by each ArgMatcher:
+	static const size_t s_max_plans = 4;
+
 	GCEdge<const PairList> m_formals;
 
 	// Data on formals (other than "...") in order of occurrence:
@@ -295,6 +320,10 @@ namespace CXXR {
 
 	bool m_has_dots;  // True if formals include "..."
 
+	mutable std::vector<MatchPlan> m_plans;
+	mutable size_t m_next_plan;  // Next plan to be replaced once
+			// s_max_plans plans have been recorded.
+
 	struct SuppliedData {
 	    const Symbol* tag;
 	    RObject* value;
@@ -314,6 +343,14 @@ namespace CXXR {
 	// identical to 'longer':
 	static bool isPrefix(const String* shorter, const String* longer);
 
+	// Carry out matching according to a previously recorded plan,
+	// if there is one for the tags of the supplied arguments.
+	// Returns false if there is no such plan.
+	bool matchByPlan(Environment* target_env, const ArgList* supplied) const;
+
+	// Record a plan for future use:
+	void recordPlan(const ArgList* supplied, MatchPlan* plan) const;
+
 	// Create a Binding in the Frame of target_env for the Symbol
 	// in fdata, setting its Origin and applying default value
 	// appropriately.  Default values are wrapped in Promises
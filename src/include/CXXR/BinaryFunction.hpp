@@ -142,6 +142,54 @@ namespace CXXR {
 			      const VectorBase* vr);
 	};
 
+	/** @brief Bulk computation of the elements of a result.
+	 *
+	 * BinaryFunction::apply() consults this traits class,
+	 * instantiated with the \a FunctorWrapper class it is using,
+	 * to determine whether the elements of the result can be
+	 * computed by a single call to a bulk function, typically
+	 * one of the kernels in namespace VectorOps::Kernels, in
+	 * place of an element-by-element loop through the
+	 * \a FunctorWrapper.  This is done only if the operands are
+	 * of equal length, or the shorter operand has length one.
+	 *
+	 * The primary template disables bulk computation.  A
+	 * specialisation enabling it must define a static const bool
+	 * member \c enabled with the value true, and a static member
+	 * function template with the signature of map() below; the
+	 * result must be identical to that which the
+	 * \a FunctorWrapper would compute, and no warnings may be
+	 * called for.
+	 *
+	 * @tparam Wrapper Class instantiating the \a FunctorWrapper
+	 *           template of a BinaryFunction.
+	 */
+	template <class Wrapper>
+	struct BulkMapper {
+	    static const bool enabled = false;
+
+	    /** @brief Compute the elements of a result.
+	     *
+	     * @param out Pointer to the start of the result's data.
+	     *
+	     * @param l Pointer to the start of the first operand's
+	     *          data.
+	     *
+	     * @param nl Number of elements in the first operand.
+	     *
+	     * @param r Pointer to the start of the second operand's
+	     *          data.
+	     *
+	     * @param nr Number of elements in the second operand.
+	     *          Either \a nl and \a nr are equal, or one of
+	     *          them is 1.
+	     */
+	    template <typename O, typename L, typename R>
+	    static void map(O* out, const L* l, std::size_t nl,
+			    const R* r, std::size_t nr)
+	    {}
+	};
+
 	/** @brief Monitor function application for binary functions.
 	 *
 	 * VectorOps::BinaryFunction takes as a template parameter a
@@ -530,7 +578,15 @@ void CXXR::VectorOps::BinaryFunction<Functor,
     typedef typename Vr::const_iterator Rit;
     typedef typename Vout::value_type Oelt;
     typedef typename Vout::iterator Oit;
-    FunctorWrapper<Lelt, Relt, Oelt, Functor> fwrapper(m_f);
+    typedef FunctorWrapper<Lelt, Relt, Oelt, Functor> Wrapper;
+    Wrapper fwrapper(m_f);
+    if (BulkMapper<Wrapper>::enabled
+	&& (flag == 0 || (flag < 0 ? vl->size() : vr->size()) == 1)) {
+	BulkMapper<Wrapper>::map(&*vout->begin(), &*vl->begin(), vl->size(),
+				 &*vr->begin(), vr->size());
+	fwrapper.warnings();
+	return;
+    }
     Lit lit = vl->begin();
     Lit lend = vl->end();
     Rit rit = vr->begin();
@@ -47,6 +47,9 @@
 #ifdef __cplusplus
 
 #include <map>
+#include <string>
+#include <utility>
+#include <vector>
 #include <boost/serialization/nvp.hpp>
 
 #include "CXXR/ArgList.hpp"
@@ -107,6 +110,37 @@ namespace CXXR {
 	    PP_REPEAT 	= 20
 	};
 
+	/** @brief Number of bins in latency histograms.
+	 *
+	 * Bin 0 counts calls taking less than 1 microsecond, bin
+	 * <em>k</em> for 0 < <em>k</em> < s_num_latency_bins - 1
+	 * counts calls taking at least 2<sup><em>k</em>-1</sup> and
+	 * less than 2<sup><em>k</em></sup> microseconds, and the
+	 * last bin counts all longer calls.
+	 */
+	static const unsigned int s_num_latency_bins = 12;
+
+	/** @brief Usage statistics of a built-in function.
+	 *
+	 * @see enableStatistics()
+	 */
+	struct Statistics {
+	    std::size_t calls;  // Number of calls.
+	    double time;  // Total elapsed time in seconds, including
+	      // time spent in nested calls of BuiltInFunction objects.
+	    double self_time;  // Total elapsed time in seconds,
+	      // excluding time spent in nested calls of BuiltInFunction
+	      // objects.
+	    double bytes;  // Net change in
+	      // MemoryBank::bytesAllocated() across the calls,
+	      // excluding nested calls of BuiltInFunction objects.
+	      // May be negative if garbage collection intervenes.
+	    std::size_t latency[s_num_latency_bins];  // Histogram of
+	      // the elapsed times of calls, including nested calls.
+
+	    Statistics();
+	};
+
 	/** @brief Precedence level of function.
 	 */
 	enum Precedence {
@@ -156,6 +190,19 @@ namespace CXXR {
 	 */
 	void checkNumArgs(const PairList* args, const Expression* call) const;
 
+	/** @brief Enable or disable collection of usage statistics.
+	 *
+	 * While collection is enabled, each call of apply() is timed,
+	 * and the Statistics of the BuiltInFunction concerned are
+	 * updated on exit from the call, whether normal or via an
+	 * exception.  When collection is disabled, the cost to apply()
+	 * is a single test.  Statistics already collected are
+	 * retained when collection is disabled.
+	 *
+	 * @param on true iff statistics are to be collected.
+	 */
+	static void enableStatistics(bool on);
+
 	/** @brief C/C++ function implementing this R function.
 	 *
 	 * @return Pointer to the C/C++ function implementing this R
@@ -166,6 +213,19 @@ namespace CXXR {
 	    return m_function;
 	}
 
+	/** @brief Retrieve usage statistics.
+	 *
+	 * @param dest Non-null pointer to a vector into which are
+	 *          placed the name and Statistics of each built-in
+	 *          function that has been called at least once while
+	 *          collection was enabled since statistics were last
+	 *          reset.  Any previous contents of the vector are
+	 *          discarded.
+	 */
+	static void
+	getStatistics(std::vector<std::pair<std::string,
+					    Statistics> >* dest);
+
 	/** @brief Kind of built-in function.
 	 *
 	 * (Used mainly in deparsing.)
@@ -240,6 +300,10 @@ namespace CXXR {
 	    return m_result_printing_mode;
 	}
 
+	/** @brief Discard all usage statistics collected so far.
+	 */
+	static void resetStatistics();
+
 	/** @brief Is a built-in function right-associative?
 	 *
 	 * @return true iff the function is right-associative.
@@ -311,6 +375,37 @@ namespace CXXR {
 	    PPinfo gram;  // 'pretty-print' information
 	};
 
+	// Objects of this class are declared within apply() to time
+	// the call, if collection of statistics is enabled:
+	class StatisticsScope {
+	public:
+	    StatisticsScope(const BuiltInFunction* function)
+		: m_function(0)
+	    {
+		if (s_collect_statistics)
+		    start(function);
+	    }
+
+	    ~StatisticsScope()
+	    {
+		if (m_function)
+		    finish();
+	    }
+	private:
+	    const BuiltInFunction* m_function;  // Null if the call is
+	      // not being timed.
+	    StatisticsScope* m_enclosing;
+	    double m_start_time;
+	    double m_nested_time;  // Time in nested timed calls.
+	    double m_nested_bytes;  // Net allocation in nested timed
+	      // calls.
+	    std::size_t m_start_bytes;
+
+	    void start(const BuiltInFunction* function);
+	    void finish();
+	};
+	friend class StatisticsScope;  // Unnecessary in C++ 0x
+
 	// SOFT_ON signifies that result printing should be enabled
 	// before calling m_function, but that if m_function disables
 	// result printing, this should not be overridden.
@@ -324,6 +419,11 @@ namespace CXXR {
 	typedef std::map<std::string, BuiltInFunction*> map;
 	static map* s_cache;
 
+	static bool s_collect_statistics;
+	static std::vector<Statistics>* s_statistics;  // Indexed by
+	  // table offset.  Created when statistics are first enabled.
+	static StatisticsScope* s_innermost_scope;
+
 	unsigned int m_offset;
 	CCODE m_function;
 	ResultPrintingMode m_result_printing_mode;
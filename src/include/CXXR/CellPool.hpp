@@ -171,11 +171,18 @@ namespace CXXR {
 
 	/** @brief Reorganise list of free cells within the CellPool.
 	 *
-	 * This is done with a view to increasing the probability that
-	 * successive allocations will lie within the same cache line
-	 * or (less importantly nowadays) memory page.
+	 * Superblocks all of whose cells are free are released to the
+	 * main heap.  The remaining free cells are reordered so that
+	 * cells are allocated first from the fullest superblocks, and
+	 * in order of increasing address within each superblock.
+	 * This is done with a view to allowing lightly-used
+	 * superblocks to empty and be released in their turn, and to
+	 * increasing the probability that successive allocations will
+	 * lie within the same cache line or memory page.
+	 *
+	 * @return The number of superblocks released.
 	 */
-	void defragment();
+	size_t defragment();
 
 	/** @brief Initialize the CellPool.
 	 *
@@ -45,6 +45,7 @@
 
 #ifdef __cplusplus
 
+#include <vector>
 #include <boost/serialization/access.hpp>
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/nvp.hpp>
@@ -53,6 +54,7 @@
 #include "CXXR/ArgMatcher.hpp"
 #include "CXXR/Environment.h"
 #include "CXXR/PairList.h"
+#include "CXXR/SlotFrame.hpp"
 
 namespace CXXR {
     class ClosureContext;
@@ -67,6 +69,22 @@ namespace CXXR {
      */
     class Closure : public FunctionBase {
     public:
+	/** @brief Primitive function called by a Closure.
+	 *
+	 * Used by strict() to record the bindings on which its
+	 * result depends.
+	 */
+	struct Callee {
+	    const Symbol* m_symbol;
+	    // Binding of m_symbol found from the Closure's environment.
+	    // Valid until Environment::lookupEpoch() changes.
+	    const Frame::Binding* m_binding;
+	    // Name of the primitive function bound.  (Used in
+	    // preference to the function's address, which could be
+	    // reused if the function were garbage-collected.)
+	    const char* m_name;
+	};
+
 	/**
 	 * @param formal_args List of formal arguments.
 	 *
@@ -88,8 +106,11 @@ namespace CXXR {
 	 */
 	Closure(const Closure& pattern)
 	    : FunctionBase(pattern), m_debug(false),
+	      m_strictness_known(false), m_strict(false),
+	      m_strictness_epoch(0),
 	      m_matcher(pattern.m_matcher), m_body(pattern.m_body),
-	      m_environment(pattern.m_environment)
+	      m_environment(pattern.m_environment),
+	      m_frame_layout(pattern.m_frame_layout)
 	{}
 
 	/** @brief Access the body of the Closure.
@@ -139,6 +160,21 @@ namespace CXXR {
 	 */
 	RObject* execute(Environment* env) const;
 
+	/** @brief Layout of working Frames.
+	 *
+	 * @return Pointer to the SlotFrame::Layout to be used for the
+	 * working Frame when this Closure is invoked.  The Layout is
+	 * computed when first required.
+	 */
+	const SlotFrame::Layout* frameLayout() const
+	{
+	    if (!m_frame_layout)
+		m_frame_layout
+		    = expose(new SlotFrame::Layout(m_matcher->formalArgs(),
+						   m_body));
+	    return m_frame_layout;
+	}
+
 	/** @brief Invoke the function.
 	 *
 	 * This differs from apply() in that it is assumed that any
@@ -163,6 +199,12 @@ namespace CXXR {
 	 *          \c .Generic and \c .Class.
 	 *
 	 * @return The result of applying the function.
+	 *
+	 * @note If the reference counts show that the working
+	 * Environment of the invocation has not escaped, it is kept
+	 * for reuse by a later invocation of this Closure, in place
+	 * of allocating a new Environment and Frame.  See
+	 * Environment::recycle().
 	 */
 	RObject* invoke(Environment* env, const ArgList* arglist,
 			const Expression* call,
@@ -196,6 +238,12 @@ namespace CXXR {
 	void setEnvironment(Environment* new_env)
 	{
 	    m_environment = new_env;
+	    // strict() depends on the functions visible from the
+	    // environment:
+	    m_strictness_known = false;
+	    m_callees.clear();
+	    // Spare working environments enclose the old environment:
+	    m_spare_envs.clear();
 	}
 
 	/** @brief The name by which this type is known in R.
@@ -207,6 +255,31 @@ namespace CXXR {
 	    return "closure";
 	}
 
+	/** @brief Does the Closure force its arguments on entry?
+	 *
+	 * @return true if analysis of the body of the Closure shows
+	 * (i) that each formal argument is either forced or
+	 * overwritten before anything is evaluated that might run
+	 * arbitrary code, (ii) that the body and the default
+	 * arguments call only primitive functions, none of which can
+	 * examine Promises or environments (so excluding for example
+	 * substitute(), missing(), UseMethod(), .Internal() and
+	 * .Call()), or turn values into objects or environments
+	 * (e.g. <tt>class<-</tt> and globalenv()), and (iii) that they
+	 * refer to no variables other than the formal arguments and
+	 * local variables that have certainly been assigned to.  The
+	 * analysis is conservative.  It is carried out when the
+	 * result is first required, and repeated if the binding of
+	 * any of the functions called changes.
+	 *
+	 * If this function returns true, an argument consisting of a
+	 * Symbol whose value is already available may be bound
+	 * directly to that value, rather than to a Promise, provided
+	 * that the value could not cause the primitives called to run
+	 * other code: see ArgList::ELIDE_LOOKUPS.
+	 */
+	bool strict() const;
+
 	/** @brief Strip formal argument bindings from a Frame.
 	 *
 	 * This function removes from \a input_frame any bindings of
@@ -282,14 +355,32 @@ namespace CXXR {
 	};
 
 	bool m_debug;
+	mutable bool m_strictness_known : 1;
+	mutable bool m_strict : 1;
+	// If m_strict is true, the Environment::lookupEpoch() value
+	// at which m_callees were last verified:
+	mutable unsigned long m_strictness_epoch;
+	mutable std::vector<Callee> m_callees;
 	GCEdge<const ArgMatcher> m_matcher;
 	GCEdge<> m_body;
 	GCEdge<Environment> m_environment;
+	mutable GCEdge<const SlotFrame::Layout> m_frame_layout;
+
+	// Working Environments of earlier invocations of this Closure
+	// which did not escape, and which have been prepared for
+	// reuse using Environment::recycle():
+	mutable std::vector<GCEdge<Environment> > m_spare_envs;
+	static const std::size_t s_max_spare_envs = 4;
 
 	// Declared private to ensure that Environment objects are
 	// created only using 'new':
 	~Closure() {}
 
+	// Are the functions called by the body, as recorded in
+	// m_callees, still bound as they were when strict() analysed
+	// the Closure?
+	bool calleesUnchanged() const;
+
 	// Not (yet) implemented.  Declared to prevent
 	// compiler-generated versions:
 	Closure& operator=(const Closure&);
@@ -346,6 +346,24 @@ namespace CXXR {
 	    return m_in_loop;
 	}
 
+	/** @brief Validity stamp for inline lookup caches.
+	 *
+	 * Code that caches the result of a Symbol lookup, having
+	 * first called watchLookup(), may reuse the result for as
+	 * long as the value returned by this function is unchanged.
+	 * The value changes whenever an Environment's enclosing
+	 * Environment is changed, the search list cache is cleared,
+	 * or a Binding of a Symbol passed to watchLookup() is created
+	 * or removed either in a Frame on the search list or in a
+	 * Frame passed to Frame::watch().
+	 *
+	 * @return The current validity stamp.
+	 */
+	static unsigned long lookupEpoch()
+	{
+	    return s_lookup_epoch;
+	}
+
 	/** @brief Disconnect the Environment from its Frame, if safe.
 	 *
 	 * Just before the application of a Closure returns, this
@@ -369,6 +387,35 @@ namespace CXXR {
 #endif
 	}
 
+	/** @brief Prepare a local Environment for reuse, if safe.
+	 *
+	 * This function may be called on the local Environment of a
+	 * Closure just after the application of the Closure has
+	 * completed, and after the caller has released its own
+	 * GCStackRoot to the Environment.  If the reference counts
+	 * show that nothing refers to the Environment, and that
+	 * nothing but the Environment refers to its Frame, the
+	 * function removes all Bindings from the Frame and restores
+	 * the Environment to the state of a newly created local
+	 * Environment with the same enclosing Environment and Frame.
+	 * The Environment can then be reused for a later application
+	 * of the same Closure.
+	 *
+	 * @return true iff the Environment has been prepared for
+	 * reuse.  If false is returned, the Environment is left
+	 * unchanged.
+	 *
+	 * @note Because GCStackRoot objects and the C pointer
+	 * protection stack do not necessarily contribute to reference
+	 * counts, the caller must ensure that no such reference to
+	 * the Environment or its Frame remains live, other than
+	 * references that the caller is about to discard.  The
+	 * function always returns false while reference counting is
+	 * being deferred (see GCManager::setDeferredRefCounting()),
+	 * because the reference counts may then be too low.
+	 */
+	bool recycle();
+
 	/** @brief Look for Environment objects that may have
 	 *  'leaked'.
 	 *
@@ -426,6 +473,25 @@ namespace CXXR {
 	 */
 	void setEnclosingEnvironment(Environment* new_enclos);
 
+	/** @brief Prepare to cache the result of a Symbol lookup.
+	 *
+	 * This function watches (see Frame::watch()) the Frame of
+	 * each Environment that is searched for \a symbol from this
+	 * Environment outwards, stopping at the first Binding found
+	 * or at the global environment, beyond which the search list
+	 * cache is in charge.
+	 *
+	 * @param symbol Non-null pointer to the Symbol sought.
+	 *
+	 * @param target Pointer to the Environment in which a
+	 *          search has found the Binding to be cached.
+	 *
+	 * @return true iff the first Binding of \a symbol in the
+	 * search is the one in \a target.  If so, the Binding may be
+	 * cached until lookupEpoch() changes.
+	 */
+	bool watchLookup(const Symbol* symbol, const Environment* target);
+
 	/** @brief Set single-stepping status
 	 *
 	 * @param on The required single-stepping status (true =
@@ -511,18 +577,37 @@ namespace CXXR {
 	};
 
 	// The class maintains a cache of Symbol Bindings found along
-	// the search path:
+	// the search path.  Each entry is stamped with the value of
+	// s_cache_epoch current when it was made, and is disregarded
+	// if the stamp is out of date.  This allows the whole cache
+	// to be invalidated in constant time.
 
 	typedef std::pair<Environment*, Frame::Binding*> EBPair;
+
+	struct CacheEntry {
+	    EBPair m_pair;
+	    unsigned int m_epoch;
+
+	    CacheEntry()
+		: m_pair(0, 0), m_epoch(0)
+	    {}
+
+	    CacheEntry(const EBPair& pr, unsigned int epoch)
+		: m_pair(pr), m_epoch(epoch)
+	    {}
+	};
+
 	typedef
-	std::tr1::unordered_map<const Symbol*, EBPair,
+	std::tr1::unordered_map<const Symbol*, CacheEntry,
 				std::tr1::hash<const Symbol*>,
 				std::equal_to<const Symbol*>,
 				CXXR::Allocator<std::pair<const Symbol*,
-							  EBPair> >
+							  CacheEntry> >
 	                        > Cache;
 
 	static Cache* s_cache;
+	static unsigned int s_cache_epoch;
+	static unsigned long s_lookup_epoch;
 
 	// Predefined environments:
 	static Environment* s_base;
@@ -554,6 +639,8 @@ namespace CXXR {
 	{
 	    if (m_cached && m_frame)
 		m_frame->decCacheCount();
+	    if (m_frame && m_frame->watched())
+		invalidateLookups();
 	}
 
 	static void cleanup();
@@ -564,8 +651,20 @@ namespace CXXR {
 	// a null pointer, clear the cache entirely.
 	static void flushFromCache(const Symbol* sym);
 
+	// Remove from the cache any mapping of a Symbol bound in
+	// 'frame'.  Used when an Environment is inserted into or
+	// removed from the search path, which can alter the lookup of
+	// only those Symbols.
+	static void flushFrameFromCache(const Frame* frame);
+
 	static void initialize();
 
+	// Invalidate all inline lookup caches:
+	static void invalidateLookups()
+	{
+	    ++s_lookup_epoch;
+	}
+
 	bool isCachePortal() const
 	{
 	    return (this == s_global);
@@ -0,0 +1,138 @@
+/*CXXR $Id$
+ *CXXR
+ *CXXR This file is part of CXXR, a project to refactor the R interpreter
+ *CXXR into C++.  It may consist in whole or in part of program code and
+ *CXXR documentation taken from the R project itself, incorporated into
+ *CXXR CXXR (and possibly MODIFIED) under the terms of the GNU General Public
+ *CXXR Licence.
+ *CXXR
+ *CXXR CXXR is Copyright (C) 2008-14 Andrew R. Runnalls, subject to such other
+ *CXXR copyrights and copyright restrictions as may be stated below.
+ *CXXR
+ *CXXR CXXR is not part of the R project, and bugs and other issues should
+ *CXXR not be reported via r-bugs or other R project channels; instead refer
+ *CXXR to the CXXR website.
+ *CXXR */
+
+/** @file EvaluationProfiler.hpp
+ *
+ * @brief Class CXXR::EvaluationProfiler.
+ */
+
+#ifndef EVALUATIONPROFILER_HPP
+#define EVALUATIONPROFILER_HPP
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+namespace CXXR {
+    /** @brief Sampling profiler of R evaluation.
+     *
+     * While the profiler is running, a timer thread counts off
+     * sampling intervals, and asks the Evaluator to bring forward
+     * its periodic checks via Evaluator::requestChecks().  When
+     * the main thread next calls Evaluator::evaluate(), it calls
+     * poll(), which records the chain of FunctionContext objects
+     * (and hence of ClosureContext objects) current at that point,
+     * optionally annotated with source references.
+     *
+     * The timer thread does nothing but increment a counter, and
+     * the samples are recorded and aggregated by the main thread
+     * alone, so the samples need no locking.  Each distinct stack is
+     * recorded once, in the collapsed form used by flame graph
+     * tools, together with the number of sampling intervals
+     * attributed to it.  When the profiler is not running, its
+     * cost to the Evaluator is the test of a flag that is never set.
+     *
+     * The stacks are accumulated until retrieved by takeStacks().
+     * This class only has static members.
+     */
+    class EvaluationProfiler {
+    public:
+	/** @brief Aggregated samples.
+	 *
+	 * Maps each distinct call stack, represented as the names of
+	 * the functions on the stack, outermost first, separated by
+	 * semicolons, to the number of sampling intervals attributed
+	 * to that stack.
+	 */
+	typedef std::map<std::string, std::size_t> Stacks;
+
+	/** @brief Sampling interval.
+	 *
+	 * @return The sampling interval in microseconds, or zero if
+	 * the profiler is not running.
+	 */
+	static unsigned int interval()
+	{
+	    return s_interval;
+	}
+
+	/** @brief Take a sample if one is due.
+	 *
+	 * This function is called by Evaluator::evaluate() when it
+	 * carries out its periodic checks.  If one or more sampling
+	 * intervals have elapsed since the last sample, the current
+	 * call stack is recorded, and all the elapsed intervals are
+	 * attributed to it.
+	 */
+	static void poll()
+	{
+	    if (s_ticks != s_ticks_sampled)
+		sample();
+	}
+
+	/** @brief Start or stop profiling.
+	 *
+	 * Stacks accumulated by any previous run of the profiler that
+	 * have not been retrieved by takeStacks() are retained.
+	 *
+	 * @param interval Sampling interval in microseconds.  If
+	 *          zero, the profiler is stopped.
+	 *
+	 * @param srcrefs If true, the name of each function on a
+	 *          recorded stack is followed, where possible, by the
+	 *          source file and line number of the call, in the
+	 *          form <tt>f [file.R#12]</tt>.
+	 *
+	 * @return true if the profiler is now in the requested state;
+	 * false if a nonzero \a interval was specified but the timer
+	 * thread could not be started, or if the profiler is not
+	 * supported on this platform.
+	 */
+	static bool start(unsigned int interval, bool srcrefs = false);
+
+	/** @brief Retrieve the accumulated stacks.
+	 *
+	 * @param dest Non-null pointer to a map into which the stacks
+	 *          accumulated since the last call to this function
+	 *          are moved.  Any previous contents of the map are
+	 *          discarded.
+	 */
+	static void takeStacks(Stacks* dest);
+    private:
+	static unsigned int s_interval;
+	static bool s_srcrefs;
+	static volatile unsigned int s_ticks;  // Number of sampling
+	  // intervals counted by the timer thread.  Written only by
+	  // the timer thread.
+	static unsigned int s_ticks_sampled;  // Value of s_ticks at
+	  // the last sample.
+	static Stacks s_stacks;
+
+	// Not implemented.  Declared to stop the compiler generating
+	// a constructor.
+	EvaluationProfiler();
+
+	static void sample();
+
+	// Stop the timer thread if it is running:
+	static void stopTimer();
+
+	// Main function of the timer thread:
+	static void* timerMain(void*);
+    };
+}  // namespace CXXR
+
+#endif  // EVALUATIONPROFILER_HPP
@@ -48,6 +48,7 @@
 #define BYTECODE
 
 #ifdef __cplusplus
+#include <csignal>
 #include <utility>
 
 extern "C" {
@@ -204,6 +205,22 @@ namespace CXXR {
 	    s_profiling = on;
 	}
 
+	/** @brief Bring forward the periodic checks.
+	 *
+	 * Evaluator::evaluate() checks for user interrupts and
+	 * pending profiler samples only once in a given number of
+	 * calls.  This function arranges for the checks to be carried
+	 * out by the next call of evaluate().
+	 *
+	 * @note This function may be called from threads other than
+	 * the main thread, and from signal handlers: it only sets a
+	 * flag, which evaluate() reads.
+	 */
+	static void requestChecks()
+	{
+	    s_checks_requested = 1;
+	}
+
 	/** @brief Specify whether the result of top-level expression
 	 * be printed.
 	 *
@@ -304,6 +321,9 @@ namespace CXXR {
 			      // check is made for user interrupts.
 	static unsigned int s_countdown_start;  // Value from which
 			      // s_countdown starts counting down
+	static volatile std::sig_atomic_t s_checks_requested;  // Set
+			      // by requestChecks() to bring the
+			      // checks forward.
 	static Evaluator* s_current;  // The current (innermost) Evaluator
 	static bool s_profiling;  // True iff profiling enabled
 
@@ -49,6 +49,8 @@
 #include <boost/serialization/nvp.hpp>
 
 namespace CXXR {
+    class FunctionBase;
+
     /** @brief Singly linked list representing an R expression.
      *
      * R expression, represented as a LISP-like singly-linked list,
@@ -57,6 +59,11 @@ namespace CXXR {
      * list.  (Any of these pointers may be null.)  A Expression
      * object is considered to 'own' its car, its tag, and all its
      * successors.
+     *
+     * If the car of an Expression is a Symbol, evaluate() keeps an
+     * inline cache of the Binding of that Symbol to a function, so
+     * that repeated calls from within the body of a Closure can
+     * usually skip the search of the enclosing Environments.
      */
     class Expression : public ConsCell {
     public:
@@ -71,7 +78,7 @@ namespace CXXR {
 	 */
 	explicit Expression(RObject* cr = 0, PairList* tl = 0,
 			    const RObject* tg = 0)
-	    : ConsCell(LANGSXP, cr, tl, tg)
+	    : ConsCell(LANGSXP, cr, tl, tg), m_function_cache(0)
 	{}
 
 	/** @brief Copy constructor.
@@ -79,7 +86,7 @@ namespace CXXR {
 	 * @param pattern Expression to be copied.
 	 */
 	Expression(const Expression& pattern)
-	    : ConsCell(pattern)
+	    : ConsCell(pattern), m_function_cache(0)
 	{}
 
 	/** @brief The name by which this type is known in R.
@@ -95,11 +102,26 @@ namespace CXXR {
 	Expression* clone() const;
 	RObject* evaluate(Environment* env);
 	const char* typeName() const;
+
+	// Virtual function of GCNode:
+	void visitReferents(const_visitor* v) const;
+    protected:
+	// Virtual function of GCNode:
+	void detachReferents();
     private:
 	friend class boost::serialization::access;
+
+	struct FunctionCache;
+
+	FunctionCache* m_function_cache;  // Created on demand.
+
 	// Declared private to ensure that Expression objects are
 	// allocated only using 'new':
-	~Expression() {}
+	~Expression();
+
+	// Look up the function designated by a Symbol in the car,
+	// consulting and maintaining m_function_cache:
+	FunctionBase* findFunction(const Symbol* symbol, Environment* env);
 
 	// Not implemented yet.  Declared to prevent
 	// compiler-generated versions:
@@ -161,9 +161,13 @@ namespace CXXR {
 	 *          zero).  No bounds checking is applied.
 	 *
 	 * @return Reference to the specified element.
+	 *
+	 * @note Any recorded properties of the elements are
+	 * discarded (see VectorBase::Property).
 	 */
 	T& operator[](size_type index)
 	{
+	    forgetProperties();
 	    return m_data[index];
 	}
 
@@ -183,9 +187,13 @@ namespace CXXR {
 	 *
 	 * @return An iterator designating the first element of the
 	 * vector.  Returns end() if the vector is empty.
+	 *
+	 * @note Any recorded properties of the elements are
+	 * discarded (see VectorBase::Property).
 	 */
 	iterator begin()
 	{
+	    forgetProperties();
 	    return m_data;
 	}
 
@@ -276,6 +284,10 @@ namespace CXXR {
 	// allocate the required memory block from CXXR::MemoryBank :
 	static T* allocData(size_type sz);
 
+	// Used by setSize() to resize the data block of a vector
+	// whose elements can be moved bitwise:
+	static T* reallocData(T* data, size_type old_sz, size_type new_sz);
+
 	static void constructElements(iterator from, iterator to);
 
 	void destructElements();
@@ -460,9 +472,28 @@ T* CXXR::FixedVector<T, ST, Initr>::allocData(size_type sz)
     void* block;
     try {
 	block = MemoryBank::allocate(blocksize);
-    } catch (std::bad_alloc) {
+    } catch (const std::bad_alloc&) {
 	tooBig(blocksize);
     }
+    AllocationProfiler::noteType(block, ST);
+    return static_cast<T*>(block);
+}
+
+template <typename T, SEXPTYPE ST, typename Initr>
+T* CXXR::FixedVector<T, ST, Initr>::reallocData(T* data, size_type old_sz,
+						 size_type new_sz)
+{
+    size_type blocksize = new_sz*sizeof(T);
+    // Check for integer overflow:
+    if (blocksize/sizeof(T) != new_sz)
+	Rf_error(_("request to create impossibly large vector."));
+    void* block;
+    try {
+	block = MemoryBank::reallocate(data, old_sz*sizeof(T), blocksize);
+    } catch (const std::bad_alloc&) {
+	tooBig(blocksize);
+    }
+    AllocationProfiler::noteType(block, ST);
     return static_cast<T*>(block);
 }
 
@@ -582,6 +613,20 @@ void CXXR::FixedVector<T, ST, Initr>::save(Archive & ar,
 template <typename T, SEXPTYPE ST, typename Initr>
 void CXXR::FixedVector<T, ST, Initr>::setSize(size_type new_size)
 {
+    // Elements that need neither construction nor destruction can
+    // be moved bitwise, so the existing block is resized in place
+    // where possible.  (For large vectors MemoryBank will then
+    // remap pages rather than copy them.)
+    if (!ElementTraits::MustConstruct<T>::value  // known at compile time
+	&& !ElementTraits::MustDestruct<T>::value
+	&& m_data != singleton() && new_size > 0) {
+	size_type oldsz = size();
+	m_data = reallocData(m_data, oldsz, new_size);
+	for (T* p = m_data + oldsz; p < m_data + new_size; ++p)
+	    new (p) T(NA<T>());
+	adjustSize(new_size);
+	return;
+    }
     size_type copysz = std::min(size(), new_size);
     T* newblock = singleton();  // Setting used only if new_size == 0
     if (new_size > 0)
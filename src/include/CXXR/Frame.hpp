@@ -414,7 +414,8 @@ namespace CXXR {
 
 	Frame()
 	    : m_cache_count(0), m_locked(false),
-	      m_read_monitored(false), m_write_monitored(false)
+	      m_read_monitored(false), m_write_monitored(false),
+	      m_watched(false)
 	{}
 
 	/** @brief Copy constructor.
@@ -428,7 +429,8 @@ namespace CXXR {
 	 */
 	Frame(const Frame& source)
 	    : m_cache_count(0), m_locked(source.m_locked),
-	      m_read_monitored(false), m_write_monitored(false)
+	      m_read_monitored(false), m_write_monitored(false),
+	      m_watched(false)
 	{}
 
 	/** @brief Get contents as a PairList.
@@ -699,6 +701,22 @@ namespace CXXR {
 	    return old;
 	}
 
+	/** @brief Shape of the Frame.
+	 *
+	 * Inline lookup caches use this function to recognise Frames
+	 * in which a Symbol cannot be bound.
+	 *
+	 * @return A null pointer, or a pointer to an object such that
+	 * any Frame with the same shape can bind only Symbols taken
+	 * from a fixed set.  The only Frames with non-null shapes are
+	 * SlotFrame objects with no overflow Bindings, whose shape is
+	 * their SlotFrame::Layout.
+	 */
+	virtual const GCNode* shape() const
+	{
+	    return 0;
+	}
+
 	/** @brief Number of Bindings in Frame.
 	 *
 	 * @return the number of Symbols for which Bindings exist in
@@ -716,6 +734,28 @@ namespace CXXR {
 	 */
         std::vector<const Symbol*> symbols(bool include_dotsymbols) const;
 
+	/** @brief Report the Frame's use by an inline lookup cache.
+	 *
+	 * Once this function has been called, the creation or
+	 * removal within the Frame of a Binding of any Symbol for
+	 * which Symbol::lookupWatched() is true (or the destruction
+	 * of the Frame) will invalidate all inline lookup caches: see
+	 * Environment::lookupEpoch().
+	 */
+	void watch() const
+	{
+	    m_watched = true;
+	}
+
+	/** @brief Is the Frame used by an inline lookup cache?
+	 *
+	 * @return true iff watch() has been called for this Frame.
+	 */
+	bool watched() const
+	{
+	    return m_watched;
+	}
+
 	// Virtual function of GCNode:
 	void visitReferents(const_visitor* v) const;
     protected:
@@ -736,7 +776,7 @@ namespace CXXR {
 	 */
 	void statusChanged(const Symbol* sym)
 	{
-	    if (m_cache_count > 0)
+	    if (m_cache_count > 0 || m_watched)
 		flush(sym);
 	}
 
@@ -754,6 +794,7 @@ namespace CXXR {
 	bool m_locked                  : 1;
 	mutable bool m_read_monitored  : 1;
 	mutable bool m_write_monitored : 1;
+	mutable bool m_watched         : 1;
 
 	// Not (yet) implemented.  Declared to prevent
 	// compiler-generated versions:
@@ -767,7 +808,9 @@ namespace CXXR {
 	    --m_cache_count;
 	}
 
-	// Flush symbol(s) from search list cache:
+	// Flush symbol(s) from search list cache, and invalidate
+	// inline lookup caches if the Frame is watched and sym may
+	// be looked up by them:
 	void flush(const Symbol* sym);
 
 	void incCacheCount()
@@ -68,6 +68,7 @@ namespace CXXR {
 	{
 	    GCNode::maybeCheckExposed(m_target);
 	    GCNode::incRefCount(m_target);
+	    GCNode::shadeIfMarking(m_target);
 	}
 
 	/** @brief Copy constructor.
@@ -78,6 +79,7 @@ namespace CXXR {
 	    : m_target(source.m_target)
 	{
 	    GCNode::incRefCount(m_target);
+	    GCNode::shadeIfMarking(m_target);
 	}
 	    
 	~GCEdgeBase()
@@ -123,6 +125,12 @@ namespace CXXR {
      * object, rather than by containing a pointer or reference
      * directly.
      *
+     * The reference counting carried out by this class also serves
+     * as the write barrier for generational garbage collection: see
+     * the description of generations in the documentation of class
+     * GCNode.  During incremental marking, this class also shades
+     * grey any white node that becomes the target of a GCEdge.
+     *
      * @tparam T GCNode or a type publicly derived from GCNode.  This
      *           may be qualified by const, so for example a const
      *           String* may be encapsulated in a GCEdge using the type
@@ -46,6 +46,7 @@
 
 #include <cstddef>
 #include <iosfwd>
+#include <string>
 
 namespace CXXR {
     /** @brief Class for managing garbage collection.
@@ -58,15 +59,164 @@ namespace CXXR {
      * supplied by GCManager::triggerLevel() This threshold value
      * varies during the run, subject to a minimum value specified in
      * the enableGC() method.
+     *
+     * Automatically initiated collections are normally minor
+     * collections, confined to the young generation of GCNode
+     * objects; a full collection is carried out only if a minor
+     * collection fails to reclaim enough memory.  If a pause budget
+     * has been set using setPauseBudget(), the mark phase of such a
+     * full collection is carried out incrementally, in slices
+     * interleaved with subsequent allocations.
+     *
+     * The decision whether a minor collection should be followed by
+     * a full collection, and the threshold set following a full
+     * collection, are delegated to a GCManager::Policy object: see
+     * setPolicy().
      */
     class GCManager {
     public:
+	/** @brief Garbage collection trigger policy.
+	 *
+	 * A Policy object decides when full collections take place,
+	 * and how far the heap may grow between them.  It may base
+	 * its decisions on the timings recorded in statistics().
+	 * Three policies are built in, and can be obtained by name
+	 * using builtInPolicy():
+	 * <dl>
+	 * <dt>"default"</dt> <dd>Following a full collection, the
+	 * threshold is set to twice the number of bytes still
+	 * allocated, but is reduced by no more than 10% from its
+	 * previous value.</dd>
+	 * <dt>"cpu"</dt> <dd>The ratio of the threshold to the number
+	 * of bytes surviving a full collection is adapted so that
+	 * the proportion of elapsed time spent in garbage collection
+	 * approaches gcFractionTarget().</dd>
+	 * <dt>"throughput"</dt> <dd>Intended for batch jobs: the
+	 * threshold is set to four times the number of bytes
+	 * surviving a full collection, is never reduced, and full
+	 * collections are deferred for as long as possible.</dd>
+	 * </dl>
+	 * Whatever the policy, the threshold is not raised above
+	 * maxHeap() unless the live data require it.
+	 */
+	class Policy {
+	public:
+	    virtual ~Policy() {}
+
+	    /** @brief Is a full collection due?
+	     *
+	     * This function is called following a minor collection.
+	     * The default implementation returns true if  bytes
+	     * exceeds three quarters of  threshold.
+	     *
+	     * @param bytes The number of bytes allocated following
+	     *          the minor collection.
+	     *
+	     * @param threshold The current collection threshold.
+	     *
+	     * @return true if a full collection should now be carried
+	     * out (or, if a pause budget is set, an incremental mark
+	     * begun).
+	     */
+	    virtual bool fullCollectionDue(size_t bytes,
+					   size_t threshold) const;
+
+	    /** @brief Margin for lightweight collections.
+	     *
+	     * @return GCNode::operator new() will reclaim nodes whose
+	     * reference counts have fallen to zero each time the
+	     * number of bytes allocated has grown by this amount.
+	     * The default implementation returns 10000.
+	     */
+	    virtual size_t gcliteMargin() const;
+
+	    /** @brief Name of the policy.
+	     *
+	     * @return The name of the policy, as reported by
+	     * gc.stats() at R level.
+	     */
+	    virtual const char* name() const = 0;
+
+	    /** @brief Threshold following a full collection.
+	     *
+	     * @param bytes The number of bytes allocated following
+	     *          the full collection.
+	     *
+	     * @param threshold The current collection threshold.
+	     *
+	     * @param min_threshold The minimum threshold set by
+	     *          setGCThreshold().
+	     *
+	     * @return The new collection threshold.  (GCManager will
+	     * reduce this if necessary to respect maxHeap().)
+	     */
+	    virtual size_t nextThreshold(size_t bytes, size_t threshold,
+					 size_t min_threshold) = 0;
+	};
+
+	/** @brief Timings and counts of garbage collections.
+	 *
+	 * Times are elapsed (not CPU) times in milliseconds.
+	 */
+	struct Statistics {
+	    unsigned int collections;  ///< All collections, including
+				       ///< minor collections.
+	    unsigned int full_collections;
+	    unsigned int preemptive_collections;  ///< Full collections
+	      ///< carried out because the heap was close to maxHeap().
+	    double gc_time;  ///< Total time spent in collections.
+	    double mutator_time;  ///< Total time spent outside collections.
+	    double cycle_gc_time;  ///< Time spent in collections since
+	      ///< the completion of the previous full collection.
+	    double cycle_mutator_time;  ///< Time spent outside
+	      ///< collections since the completion of the previous full
+	      ///< collection.
+	    double last_full_time;  ///< Duration of the most recent
+	      ///< full collection.
+	};
+
+	/** @brief Look up a built-in policy.
+	 *
+	 * @param name Name of a built-in policy: "default", "cpu"
+	 *          or "throughput".
+	 *
+	 * @return Pointer to the built-in policy of the specified
+	 * name, or a null pointer if there is no such policy.
+	 */
+	static Policy* builtInPolicy(const std::string& name);
+
 	/** @brief Initiate a mark-sweep garbage collection.
 	 *
 	 * It is currently an error to initiate a mark-sweep garbage
 	 * collection while a GCNode object is under construction.
+	 *
+	 * @param full If true, a full collection of both generations
+	 *          of GCNode objects is carried out.  If false, the
+	 *          young generation is collected first, and the old
+	 *          generation is collected as well only if this does
+	 *          not bring the number of bytes allocated comfortably
+	 *          below triggerLevel().
 	 */
-	static void gc();
+	static void gc(bool full = true);
+
+	/** @brief Is deferred reference counting in effect?
+	 *
+	 * @return true iff changes to the reference counts of GCNode
+	 * objects are currently being logged rather than applied
+	 * immediately.
+	 *
+	 * @see setDeferredRefCounting()
+	 */
+	static bool deferredRefCounting();
+
+	/** @brief Target proportion of time spent in garbage collection.
+	 *
+	 * @return The proportion of elapsed time that the "cpu"
+	 * policy aims to spend in garbage collection.
+	 *
+	 * @see setGCFractionTarget()
+	 */
+	static double gcFractionTarget() {return s_gc_fraction_target;}
 
 	/** @brief Maximum number of bytes used.
 	 *
@@ -80,6 +230,16 @@ namespace CXXR {
 	 */
 	static size_t maxBytes() {return s_max_bytes;}
 
+	/** @brief Heap size cap.
+	 *
+	 * @return The number of bytes beyond which the collection
+	 * threshold will not be raised unless the live data require
+	 * it, or zero if there is no cap.
+	 *
+	 * @see setMaxHeap()
+	 */
+	static size_t maxHeap() {return s_max_heap;}
+
 	/** @brief Maximum number of GCNode objects allocated.
 	 * 
 	 * @return the maximum number of GCNode objects allocated (up
@@ -96,6 +256,29 @@ namespace CXXR {
 	 */
 	static size_t maxNodes() {return s_max_nodes;}
 
+	/** @brief Number of threads used for marking.
+	 *
+	 * @return The number of threads among which the mark phase
+	 * of a full garbage collection is shared.
+	 *
+	 * @see setMarkThreads()
+	 */
+	static unsigned int markThreads();
+
+	/** @brief Pause budget for incremental marking.
+	 *
+	 * @return The target maximum duration, in milliseconds, of
+	 * each slice of an incremental mark, or zero if incremental
+	 * marking is disabled.
+	 */
+	static double pauseBudget() {return s_pause_budget;}
+
+	/** @brief Current garbage collection policy.
+	 *
+	 * @return Pointer to the policy currently in force.
+	 */
+	static Policy* policy() {return s_policy;}
+
 	/** @brief Reset the tallies of the maximum numbers of bytes and
 	 *  GCNode objects.
 	 *
@@ -118,6 +301,85 @@ namespace CXXR {
 	 */
 	static void setGCThreshold(size_t initial_threshold);
 
+	/** @brief Enable or disable deferred reference counting.
+	 *
+	 * @param on If true, changes to the reference counts of
+	 *          GCNode objects (made by GCEdge, GCStackRoot etc.)
+	 *          are recorded in a log, which is applied the next
+	 *          time that gclite() or garbage collection takes
+	 *          place, or when the log fills up.  The log keeps
+	 *          the net change for each node, so an increment and
+	 *          a decrement to the same node (e.g. as a variable is
+	 *          bound to successive values) cancel out without the
+	 *          node being accessed.  If false (the default),
+	 *          reference counts are updated immediately; any
+	 *          changes already logged are applied forthwith.
+	 *
+	 * @note Whilst deferral is in effect, nodes whose reference
+	 * counts fall to zero are reclaimed slightly later than they
+	 * would otherwise be.
+	 */
+	static void setDeferredRefCounting(bool on);
+
+	/** @brief Set the target proportion of time spent in garbage
+	 *  collection.
+	 *
+	 * @param fraction The proportion of elapsed time that the
+	 *          "cpu" policy is to aim to spend in garbage
+	 *          collection.  Must be strictly between 0 and 1.  The
+	 *          default is 0.05.
+	 */
+	static void setGCFractionTarget(double fraction);
+
+	/** @brief Set the number of threads used for marking.
+	 *
+	 * @param num_threads The number of threads (including the
+	 *          calling thread) among which the mark phase of a full
+	 *          garbage collection is to be shared.  A value of 1
+	 *          (the default) means that marking is carried out
+	 *          entirely by the calling thread.
+	 *
+	 * @note Parallel marking is not used for incremental marks,
+	 * nor if there are fewer than 100000 GCNode objects in
+	 * existence, nor on platforms lacking POSIX threads.  The
+	 * additional threads are those of the WorkerPool, which
+	 * persist between collections.  The sweep phase always takes
+	 * place on the calling thread.
+	 */
+	static void setMarkThreads(unsigned int num_threads);
+
+	/** @brief Enable or disable incremental marking.
+	 *
+	 * @param millisecs If positive, the mark phase of full
+	 *          garbage collections initiated automatically by
+	 *          GCNode::operator new will be carried out
+	 *          incrementally, in slices each of which aims to take
+	 *          no longer than this number of milliseconds.  (The
+	 *          completion of the mark, and the sweep phase, are
+	 *          not subject to this budget.)  If zero, incremental
+	 *          marking is disabled.
+	 *
+	 * @note If reporting is enabled (see setReporting()), the
+	 * duration of each mark slice is reported.
+	 */
+	static void setPauseBudget(double millisecs);
+
+	/** @brief Cap the size of the heap.
+	 *
+	 * @param bytes If nonzero, the collection threshold will not
+	 *          be raised above this number of bytes (unless the
+	 *          bytes still allocated after a full collection
+	 *          leave no room beneath it), and a full collection
+	 *          rather than a minor collection is carried out
+	 *          whenever a collection is initiated with the number
+	 *          of bytes allocated above 90% of the cap.  Zero (the
+	 *          default) means no cap.
+	 *
+	 * @note The cap is a soft one: allocation requests are never
+	 * refused on account of it.
+	 */
+	static void setMaxHeap(size_t bytes);
+
 	/** @brief Set/unset monitors on mark-sweep garbage collection.
 	 *
 	 * @param pre_gc If not a null pointer, this function will be
@@ -137,6 +399,18 @@ namespace CXXR {
 	    s_post_gc = post_gc;
 	}
 
+	/** @brief Set the garbage collection policy.
+	 *
+	 * @param policy Non-null pointer to the policy to be used
+	 *          henceforth.  The object pointed to must continue
+	 *          to exist until it is superseded by another call to
+	 *          this function.  Initially the "default" built-in
+	 *          policy is used.
+	 *
+	 * @see builtInPolicy()
+	 */
+	static void setPolicy(Policy* policy);
+
 	/** @brief Set the output stream for garbage collection reporting.
 	 *
 	 * @param os Pointer to the output stream to which reporting
@@ -146,6 +420,13 @@ namespace CXXR {
 	 */
 	static std::ostream* setReporting(std::ostream* os = 0);
 
+	/** @brief Garbage collection statistics.
+	 *
+	 * @return Reference to the timings and counts of garbage
+	 * collections since GCManager was initialized.
+	 */
+	static const Statistics& statistics() {return s_stats;}
+
 	/** @brief Turn garbage collection torture on or off.
 	 *
 	 * @param on The required torturing status.
@@ -174,6 +455,39 @@ namespace CXXR {
 	static size_t s_max_bytes;
 	static size_t s_max_nodes;
 
+	static const double s_full_gc_ratio;  // Following a minor
+	  // collection, a full collection is carried out if the number
+	  // of bytes still allocated exceeds this fraction of the
+	  // threshold.
+
+	static Policy* s_policy;
+	static Statistics s_stats;
+	static size_t s_max_heap;  // Zero if no cap.
+	static const double s_preempt_ratio;  // A full collection is
+	  // carried out if a collection is initiated with the number
+	  // of bytes allocated exceeding this fraction of s_max_heap.
+	static double s_gc_fraction_target;
+
+	static size_t s_defrag_peak;  // Greatest number of bytes
+	  // allocated at the start of a collection since
+	  // MemoryBank::defragment() was last called.
+	static const double s_defrag_ratio;  // Following a full
+	  // collection, MemoryBank::defragment() is called if the
+	  // number of bytes still allocated is less than this fraction
+	  // of s_defrag_peak.
+
+	static double s_pause_budget;  // In milliseconds; zero if
+	  // incremental marking is disabled.
+	static size_t s_mark_threshold;  // During an incremental mark,
+	  // the mark is completed forthwith if the number of bytes
+	  // allocated reaches this level.
+	static size_t s_slice_bytes;  // During an incremental mark, a
+	  // mark slice is carried out each time this number of bytes
+	  // has been allocated.
+	static size_t s_saved_threshold;  // During an incremental mark,
+	  // records the value of s_threshold when the mark began.
+	  // (s_threshold itself is used to trigger mark slices.)
+
 	static std::ostream* s_os;  // Pointer to output stream for GC
 				    // reporting, or NULL.
 
@@ -190,10 +504,20 @@ namespace CXXR {
 
 	// Detailed control of the garbage collection is carried out
 	// here.
-	static void gcController();
+	static void gcController(bool full);
 
 	// Initialize static data associated with garbage collection.
 	static void initialize();
+
+	// Highest threshold permitted by s_max_heap, given the number
+	// of bytes currently allocated:
+	static size_t heapLimit();
+
+	// Carry out one slice of an incremental mark.
+	static void markSlice();
+
+	// Start an incremental mark.
+	static void startIncrementalMark();
     };
 }  // namespace CXXR
 
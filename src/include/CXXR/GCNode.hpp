@@ -126,6 +126,57 @@ namespace CXXR {
      * can be further simplified using the CXXR_NEW macro to
      * CXXR_NEW(FooNode).
      *
+     * \par Generations:
+     * GCNode objects are ranked into two generations.  A node starts
+     * life in the young generation, and is promoted to the old
+     * generation if it survives a mark-sweep garbage collection.  A
+     * minor (i.e. young-generation) collection traces and sweeps
+     * only the young generation, treating all old nodes as live.
+     * No separate write barrier is needed to find references from
+     * old nodes to young nodes: every GCEdge already maintains the
+     * reference count of its target, so a young node whose
+     * reference count exceeds the number of references to it from
+     * other young nodes must be referenced from elsewhere (e.g. from
+     * an old node or a GCRoot), and is treated as a root of the
+     * minor collection.  Old nodes are reclaimed by reference
+     * counting, or by a full mark-sweep collection of both
+     * generations.
+     *
+     * \par Incremental marking:
+     * The mark phase of a full collection can alternatively be
+     * carried out incrementally, in slices interleaved with the
+     * allocation of new nodes (see GCManager::setPauseBudget()).
+     * During an incremental mark, nodes are either white (not yet
+     * found to be reachable), grey (found to be reachable, but with
+     * referents not yet visited) or black (found to be reachable,
+     * with referents visited, or created since the incremental mark
+     * began).  GCEdge maintains the invariant that no black node
+     * refers to a white node, by shading grey any white node that
+     * becomes the target of a GCEdge.  The roots are scanned again
+     * when the mark is completed.
+     *
+     * \par Deferred reference counting:
+     * Optionally (see GCManager::setDeferredRefCounting()), changes
+     * to reference counts are not applied to the nodes immediately,
+     * but are recorded in a log, which is applied by gclite(), by
+     * any other form of garbage collection, or when it fills up.
+     * The log records the net change to each node's reference
+     * count, so a reference that is made and then released (or
+     * vice versa) before the log is applied does not touch the
+     * node at all.
+     *
+     * \par Parallel marking:
+     * The mark phase of a (non-incremental) full collection may be
+     * shared among several threads (see
+     * GCManager::setMarkThreads()).  Each thread claims the nodes it
+     * marks using an atomic operation on the mark bit, so
+     * visitReferents() is invoked exactly once for each reachable
+     * node, but possibly on any of the marking threads.
+     * Implementations of visitReferents() must therefore not modify
+     * shared state.  The sweep phase is always carried out by the
+     * calling thread, because destructors are in general not
+     * thread-safe.
+     *
      * @note Because this base class is used purely for housekeeping
      * by the garbage collector, and does not contribute to the
      * 'meaning' of an object of a derived class, its data members are
@@ -213,7 +264,9 @@ namespace CXXR {
 #ifdef GCID
 	      m_id(++s_last_id),
 #endif
-	      m_rcmmu(s_mark | s_moribund_mask | 1)
+	      m_rcmmu(s_mark | s_moribund_mask | 1), m_old(false),
+	      m_young_refs(0), m_grey(false),
+	      m_moribund_index(s_moribund->size())
 	{
 	    ++s_num_nodes;
 	    ++s_inhibitor_count;
@@ -354,8 +407,12 @@ namespace CXXR {
 	}
 
 	/** @brief Initiate a garbage collection.
+	 *
+	 * @param full If true, a mark-sweep collection of both
+	 *          generations is carried out.  Otherwise only the
+	 *          young generation is collected.
 	 */
-	static void gc();
+	static void gc(bool full);
 
 	/** @brief Lightweight garbage collection.
 	 *
@@ -379,6 +436,19 @@ namespace CXXR {
 	    return (m_rcmmu & 1) == 0;
 	}
 
+	/** @brief Reference count.
+	 *
+	 * @return The number of references to this node from GCEdge,
+	 * GCRoot and GCStackRoot objects etc., not counting changes
+	 * still deferred (see GCManager::setDeferredRefCounting()).
+	 * The count saturates at 31: once it reaches this value it
+	 * stays there.
+	 */
+	unsigned int refCount() const
+	{
+	    return (m_rcmmu & s_refcount_mask) >> 1;
+	}
+
 	/** @brief Subject to configuration, check that a GCNode is exposed.
 	 *
 	 * Normally, this function is an inlined no-op.  However, if
@@ -404,6 +474,13 @@ namespace CXXR {
 	 */
 	static size_t numNodes() {return s_num_nodes;}
 
+	/** @brief Number of GCNode objects in the old generation.
+	 *
+	 * @return the number of GCNode objects currently in
+	 * existence that have been promoted to the old generation.
+	 */
+	static size_t numOldNodes() {return s_num_old_nodes;}
+
 	/** @brief Conduct a visitor to the nodes referred to by this
 	 * one.
 	 *
@@ -438,10 +515,13 @@ namespace CXXR {
 	    // Is the node still under construction?
 	    if (m_rcmmu & 1)
 		destruct_aux();
+	    if (m_old)
+		--s_num_old_nodes;
 	    --s_num_nodes;
 	}
     private:
 	friend class boost::serialization::access;
+	friend class GCManager;
 	friend class GCRootBase;
 	friend class GCStackRootBase;
 	friend class NodeStack;
@@ -473,27 +553,128 @@ namespace CXXR {
 #endif
 	};
 
+	/** Visitor class used to mark young nodes.
+	 *
+	 * This visitor class is used during the mark phase of a minor
+	 * garbage collection.  It promotes to the old generation a
+	 * young node and its young descendants, and treats old nodes
+	 * as already marked.
+	 */
+	class YoungMarker : public const_visitor {
+	public:
+	    // Virtual function of const_visitor:
+	    void operator()(const GCNode* node);
+	};
+
+	/** Visitor class used to shade nodes grey.
+	 *
+	 * This visitor class is used during incremental marking.
+	 * Unlike Marker, it does not itself visit the referents of
+	 * the nodes it marks, but instead pushes the nodes onto the
+	 * stack of grey nodes, to be dealt with by a subsequent mark
+	 * slice.
+	 */
+	class GreyMarker : public const_visitor {
+	public:
+	    // Virtual function of const_visitor:
+	    void operator()(const GCNode* node)
+	    {
+		if (!node->isMarked())
+		    node->shade();
+	    }
+	};
+
+	/** Visitor class used to tally references among young nodes.
+	 *
+	 * During a minor garbage collection, this visitor is
+	 * conducted to the referents of each young node in turn, and
+	 * increments m_young_refs in each young node it visits.
+	 */
+	class YoungRefCounter : public const_visitor {
+	public:
+	    // Virtual function of const_visitor:
+	    void operator()(const GCNode* node)
+	    {
+		if (!node->m_old && node->m_young_refs != 0xff)
+		    ++node->m_young_refs;
+	    }
+	};
+
+	// Class used to share the mark phase of garbage collection
+	// among several threads.  Defined in GCNode.cpp.
+	class ParallelMarker;
+
+	// Class whose objects apply the reference count log (if
+	// deferred reference counting is in effect), and suspend
+	// deferral for the lifetime of the object.  Defined in
+	// GCNode.cpp.
+	class ImmediateRefCounting;
+
 	typedef HeterogeneousList<GCNode> List;
 
 	static List* s_live;  // Except during mark-sweep garbage
-	  // collection, all existing nodes are threaded on this
-	  // list.
+	  // collection, all existing nodes in the young generation are
+	  // threaded on this list.
+	static List* s_old;  // Except during mark-sweep garbage
+	  // collection, all existing nodes in the old generation are
+	  // threaded on this list.
 	static std::vector<const GCNode*>* s_moribund;  // Vector of
 	  // pointers to nodes whose reference count has fallen to
-	  // zero (but may subsequently have increased again).
+	  // zero (but may subsequently have increased again).  An
+	  // entry is set to null if the node is deleted while still
+	  // under construction.
+	static List* s_condemned;  // During an incremental mark, the
+	  // nodes that existed when the mark began and are not yet
+	  // known to be reachable are threaded on this list, leaving
+	  // s_live for nodes created during the mark.
+	static bool s_marking;  // True iff an incremental mark is in
+	  // progress.
+	static std::vector<const GCNode*>* s_grey;  // Stack of grey
+	  // nodes during an incremental mark.
+	static std::vector<const GCNode*>* s_grey_moribund;  // Grey
+	  // nodes whose reference counts have fallen to zero during an
+	  // incremental mark.  Their deletion is deferred until the
+	  // mark is complete, because they are still on s_grey.
 	static List* s_reachable;  // During the mark phase of garbage
 	  // collection, if a node is found to be reachable from the
 	  // roots, it is moved to this list. Between garbage
 	  // collections, this list should be empty.
-	static const size_t s_gclite_margin;  // operator new will
+	static size_t s_gclite_margin;  // operator new will
 	  // invoke gclite() when MemoryBank::bytesAllocated() exceeds
 	  // by at least s_gclite_margin the number of bytes that were
 	  // allocated following the previous gclite().  This is a
-	  // tuning parameter.
+	  // tuning parameter, set from GCManager::Policy::gcliteMargin().
 	static size_t s_gclite_threshold;  // operator new calls
 	  // gclite() when the number of bytes allocated reaches this
 	  // level.
+	static const size_t s_min_parallel_mark_nodes;  // The mark phase
+	  // is shared among several threads only if at least this
+	  // many nodes are in existence.  This is a tuning parameter.
+	static unsigned int s_mark_threads;  // Number of threads among
+	  // which the mark phase of a full garbage collection is to be
+	  // shared.
+	static bool s_defer_refcounts;  // True iff reference count
+	  // changes are to be recorded in s_rc_log rather than being
+	  // applied immediately.
+
+	// Net deferred change to the reference count of a node:
+	struct RefCountChange {
+	    const GCNode* m_node;  // Null for an unused entry.
+	    int m_delta;
+	};
+
+	static const std::size_t s_rc_log_capacity = 4096;  // Must be
+	  // a power of 2.
+	static const std::size_t s_rc_log_max_nodes = 2048;  // The log
+	  // is applied when it holds changes for this many nodes.
+	static RefCountChange s_rc_log[];  // Log of deferred reference
+	  // count changes, as an open-addressed hash table keyed on the
+	  // node address, so that opposite changes to the reference
+	  // count of a node cancel however far apart they are made.
+	static std::size_t s_rc_log_size;  // Number of nodes in s_rc_log.
 	static unsigned int s_num_nodes;  // Number of nodes in existence
+	static unsigned int s_num_old_nodes;  // Number of nodes in the
+	  // old generation.
 	static unsigned int s_inhibitor_count;  // Number of GCInhibitor
 	  // objects in existence, plus the number of nodes currently
 	  // under construction (i.e. not yet exposed).
@@ -534,6 +715,16 @@ namespace CXXR {
 	  // significant bit is set to s_mark on construction; this
 	  // bit is then toggled in the mark phase of a mark-sweep
 	  // garbage collection to identify reachable nodes.
+	mutable bool m_old;  // True iff the node has been promoted to
+	  // the old generation.
+	mutable unsigned char m_young_refs;  // Used during minor
+	  // garbage collection to tally the references to this node
+	  // from young nodes.  Saturates at 255.
+	mutable bool m_grey;  // True iff the node is on s_grey.
+	unsigned int m_moribund_index;  // Position in s_moribund of
+	  // the entry made by the constructor.  This entry cannot be
+	  // removed or moved while the node is under construction,
+	  // because gclite() is inhibited during that time.
 
 	// Not implemented.  Declared to prevent compiler-generated
 	// versions:
@@ -553,22 +744,42 @@ namespace CXXR {
 	// to expose a node more than once.
 	static void alreadyExposedError();
 
+	/** @brief Start an incremental mark.
+	 *
+	 * This function initiates the mark phase of a full garbage
+	 * collection, which is then carried forward by calls to
+	 * markSome(), and completed by finishIncrementalMark().
+	 */
+	static void beginIncrementalMark();
+
+	// Apply and clear the reference count log.
+	static void applyRefCountLog();
+
 	// Clean up static data at end of run:
 	static void cleanup();
 
 	// Decrement the reference count (subject to the stickiness of
-	// its MSB).  If as a result the reference count falls to
-	// zero, mark the node as moribund.
+	// its MSB), or log the decrement if deferred reference
+	// counting is in effect.
 	static void decRefCount(const GCNode* node)
 	{
 	    if (node) {
-		unsigned char& rcmmu = node->m_rcmmu;
-		rcmmu ^= s_decinc_refcount[rcmmu & s_refcount_mask];
-		if ((rcmmu & (s_refcount_mask | s_moribund_mask)) == 0)
-		    node->makeMoribund();
+		if (s_defer_refcounts)
+		    logRefCountChange(node, -1);
+		else node->decRefCountNow();
 	    }
 	}
 
+	// Decrement the reference count (subject to the stickiness of
+	// its MSB).  If as a result the reference count falls to
+	// zero, mark the node as moribund.
+	void decRefCountNow() const
+	{
+	    m_rcmmu ^= s_decinc_refcount[m_rcmmu & s_refcount_mask];
+	    if ((m_rcmmu & (s_refcount_mask | s_moribund_mask)) == 0)
+		makeMoribund();
+	}
+
 	// Helper function for the destructor, handling the case where
 	// the node is still under construction.  This should happen
 	// only in the case where a derived class constructor has
@@ -578,16 +789,31 @@ namespace CXXR {
 #endif
 	void destruct_aux();
 
-	// Increment the reference count.  Overflow is handled by the
-	// stickiness of the MSB.
+	/** @brief Complete an incremental mark, and sweep.
+	 *
+	 * Scans the roots again, marks all remaining grey nodes, and
+	 * then carries out the sweep phase of garbage collection.
+	 */
+	static void finishIncrementalMark();
+
+	// Increment the reference count, or log the increment if
+	// deferred reference counting is in effect.
 	static void incRefCount(const GCNode* node)
 	{
 	    if (node) {
-		unsigned char& rcmmu = node->m_rcmmu;
-		rcmmu ^= s_decinc_refcount[(rcmmu & s_refcount_mask) + 1];
+		if (s_defer_refcounts)
+		    logRefCountChange(node, 1);
+		else node->incRefCountNow();
 	    }
 	}
 
+	// Increment the reference count.  Overflow is handled by the
+	// stickiness of the MSB.
+	void incRefCountNow() const
+	{
+	    m_rcmmu ^= s_decinc_refcount[(m_rcmmu & s_refcount_mask) + 1];
+	}
+
 	/** @brief Initialize static members.
 	 *
 	 * This method must be called before any GCNodes are created.
@@ -599,21 +825,85 @@ namespace CXXR {
 	 */
 	static void initialize();
 
+	/** @brief Is an incremental mark in progress?
+	 *
+	 * @return true iff an incremental mark has been started and
+	 * not yet finished.
+	 */
+	static bool isMarkingIncrementally()
+	{
+	    return s_marking;
+	}
+
 	bool isMarked() const
 	{
 	    return (m_rcmmu & s_mark_mask) == s_mark;
 	}
 
+	// Add delta to the net change logged for node's reference
+	// count.  Each node's net change is applied as a whole, so the
+	// counts seen when the log is applied never fall below their
+	// true values.
+	static void logRefCountChange(const GCNode* node, int delta)
+	{
+	    std::size_t i = rcLogSlot(node);
+	    while (s_rc_log[i].m_node != node) {
+		if (!s_rc_log[i].m_node) {
+		    if (s_rc_log_size == s_rc_log_max_nodes) {
+			applyRefCountLog();
+			i = rcLogSlot(node);
+		    }
+		    s_rc_log[i].m_node = node;
+		    ++s_rc_log_size;
+		    break;
+		}
+		i = (i + 1) & (s_rc_log_capacity - 1);
+	    }
+	    s_rc_log[i].m_delta += delta;
+	}
+
+	// Index of the entry in s_rc_log at which the search for node
+	// starts (Fibonacci hashing of the address):
+	static std::size_t rcLogSlot(const GCNode* node)
+	{
+	    unsigned int bits = static_cast<unsigned int>(
+		reinterpret_cast<std::size_t>(node) >> 3);
+	    return (bits*2654435769u) >> 20;
+	}
+
 	// Mark this node as moribund:
 #ifdef __GNUC__
 	__attribute__((hot,fastcall))
 #endif
 	void makeMoribund() const;
 
+	/** @brief Advance an incremental mark.
+	 *
+	 * @param max_nodes Maximum number of grey nodes whose
+	 *          referents are to be visited.
+	 *
+	 * @return The number of grey nodes whose referents were
+	 * visited.  If this is less than \a max_nodes, there are no
+	 * grey nodes left.
+	 */
+	static size_t markSome(size_t max_nodes);
+
 	/** @brief Carry out the mark phase of garbage collection.
 	 */
 	static void mark();
 
+	// Move the marked nodes on s_live to s_reachable, promoting
+	// them to the old generation.  Used after a parallel mark,
+	// during which the lists cannot safely be manipulated.
+	static void moveMarkedToReachable();
+
+	/** @brief Carry out a minor garbage collection.
+	 *
+	 * Reclaims unreachable nodes in the young generation, and
+	 * promotes the survivors to the old generation.
+	 */
+	static void minorGC();
+
 	// boost::serialization.  Version 0 is for debugging, and will
 	// be used for output if the preprocessor variable DEBUG_S11N
 	// is defined.  It writes the GCNode's address and id to the
@@ -622,6 +912,18 @@ namespace CXXR {
 	template <class Archive>
 	void serialize(Archive & ar, const unsigned int version);
 
+	// Shade a white node grey during an incremental mark:
+	void shade() const;
+
+	// Write barrier used during an incremental mark.  If 'node' is
+	// white, shade it grey: called whenever a GCEdge is set to
+	// point to 'node'.
+	static void shadeIfMarking(const GCNode* node)
+	{
+	    if (s_marking && node && !node->isMarked())
+		node->shade();
+	}
+
 	/** @brief Carry out the sweep phase of garbage collection.
 	 */
 	static void sweep();
@@ -108,6 +108,37 @@ inline int* INTEGER(SEXP x)
 }
 #endif
 
+/**
+ * @brief Read-only access to the elements of an integer or logical
+ * vector.
+ *
+ * Unlike INTEGER(), this function leaves any recorded properties
+ * of the elements intact (see CXXR::VectorBase::Property).
+ *
+ * @param x Pointer to an \c IntVector or a \c LogicalVector (i.e. an
+ *          R integer or logical vector).  An error is generated if \a
+ *          x is not a non-null pointer to an \c IntVector or a \c
+ *          LogicalVector .
+ *
+ * @return Const pointer to element 0 of \a x .
+ */
+#ifndef __cplusplus
+const int *INTEGER_RO(SEXP x);
+#else
+inline const int* INTEGER_RO(SEXP x)
+{
+    using namespace CXXR;
+#ifndef USE_TYPE_CHECKING_STRICT
+    // Quicker than dynamic_cast:
+    if (x && x->sexptype() == LGLSXP) {
+	const LogicalVector* lvec = static_cast<const LogicalVector*>(x);
+	return &(*lvec)[0];
+    }
+#endif
+    return &(*SEXP_downcast<const IntVector*>(x, false))[0];
+}
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -89,14 +89,13 @@ namespace CXXR {
 
 	// Virtual function of Bailout:
 	void throwException();
-
-	// Virtual function of GCNode:
-	void visitReferents(const_visitor* v) const;
-    protected:
-	// Virtual function of GCNode:
-	void detachReferents();
     private:
-	GCEdge<Environment> m_environment;
+	// A plain pointer suffices, because the target Environment
+	// is necessarily live while the Bailout is in transit.  (A
+	// GCEdge would moreover prevent Closure::invoke() from
+	// recycling the Environment until the spent Bailout had been
+	// garbage-collected.)
+	Environment* m_environment;
 	bool m_next;
 
 	// Declared private to ensure that LoopBailout objects are
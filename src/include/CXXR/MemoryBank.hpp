@@ -58,9 +58,24 @@ namespace CXXR {
      * deallocation of memory blocks, especially if used in conjunction
      * with the CELLFIFO preprocessor variable documented in
      * config.hpp .
+     *
+     * On platforms supporting \c mmap, blocks of at least
+     * largeObjectThreshold() bytes are obtained directly from the
+     * operating system as anonymous memory mappings.  Pages of such a
+     * block consume physical memory only once they are written to,
+     * and a block can be grown or shrunk using reallocate() without
+     * copying.
+     *
+     * By default, the class may be used only from the main
+     * (interpreter) thread.  Other threads may allocate and
+     * deallocate memory blocks via MemoryBank while they have a
+     * MemoryBank::ThreadCache object in existence.
      */
     class MemoryBank {
     public:
+	// Per-thread cache of memory cells.  Defined below.
+	class ThreadCache;
+
 	/** @brief Allocate a block of memory.
 	 *
 	 * @param bytes Required size in bytes of the block.
@@ -78,7 +93,10 @@ namespace CXXR {
 	 *
 	 * @return the number of blocks of memory currently allocated.
 	 */
-	static size_t blocksAllocated() {return s_blocks_allocated;}
+	static size_t blocksAllocated()
+	{
+	    return s_blocks_allocated + s_foreign_blocks;
+	}
 
 	/** @brief Number of bytes currently allocated.
 	 *
@@ -89,13 +107,23 @@ namespace CXXR {
 	 * deallocated.  Actual utilisation of memory in the main heap
 	 * may be greater than this, possibly by as much as a factor
 	 * of 2.
+	 *
+	 * @note Allocations made via ThreadCache objects are
+	 * included only approximately.
 	 */
-	static size_t bytesAllocated() {return s_bytes_allocated;}
+	static size_t bytesAllocated()
+	{
+	    return s_bytes_allocated + s_foreign_bytes;
+	}
 
 	/** @brief Integrity check.
 	 *
 	 * Aborts the program with an error message if the class is
 	 * found to be internally inconsistent.
+	 *
+	 * @note Once a ThreadCache has been used, cells may migrate
+	 * between the pools used by the main thread and those used by
+	 * ThreadCache objects, so the pools are then not checked.
 	 */
 	static void check();
 
@@ -116,8 +144,12 @@ namespace CXXR {
 	    // This helps to diagnose premature GC:
 	    memset(p, 0x55, bytes);
 #endif
+	    if (s_num_thread_caches != 0 && deallocateInThreadCache(p, bytes))
+		return;
 	    // Assumes sizeof(double) == 8:
-	    if (bytes >= s_new_threshold)
+	    if (bytes >= s_large_threshold)
+		deallocateLarge(p, bytes);
+	    else if (bytes >= s_new_threshold)
 		::operator delete(p);
 	    else s_pools[s_pooltab[(bytes + 7) >> 3]].deallocate(p);
 	    --s_blocks_allocated;
@@ -126,12 +158,125 @@ namespace CXXR {
 
 	/** @brief Reorganise lists of free cells.
 	 *
-	 * This is done with a view to increasing the probability that
-	 * successive allocations will lie within the same cache line
-	 * or (less importantly nowadays) memory page.
+	 * Superblocks of the cell pools that are wholly free are
+	 * released, and where possible the memory is returned to the
+	 * operating system.  The remaining free cells are reordered
+	 * so that the fullest superblocks are allocated from first:
+	 * see CellPool::defragment().
+	 *
+	 * @note The garbage collector calls this function after a
+	 * full collection if memory use has fallen well below its
+	 * recent peak.
 	 */
 	static void defragment();
 
+	/** @brief Number of bytes allocated in large objects.
+	 *
+	 * @return The number of bytes currently allocated in blocks
+	 * of at least largeObjectThreshold() bytes.  These bytes are
+	 * also included in bytesAllocated().
+	 */
+	static size_t largeBytesAllocated()
+	{
+	    return s_large_bytes;
+	}
+
+	/** @brief Minimum size of a large object.
+	 *
+	 * @return Blocks of at least this number of bytes are
+	 * obtained directly from the operating system using \c mmap.
+	 * If \c mmap is not available, the return value is the
+	 * largest value of size_t.
+	 */
+	static size_t largeObjectThreshold()
+	{
+	    return s_large_threshold;
+	}
+
+	/** @brief Change the size of a block.
+	 *
+	 * @param p Pointer to a block of memory previously allocated
+	 *          by MemoryBank::allocate() or reallocate().
+	 *
+	 * @param old_bytes The current size of the block in bytes.
+	 *
+	 * @param new_bytes The required size of the block in bytes.
+	 *
+	 * @return Pointer to a block of \a new_bytes bytes, whose
+	 * initial bytes are a bitwise copy of the first
+	 * min(\a old_bytes, \a new_bytes) bytes of the block pointed
+	 * to by \a p.  That block must not be used subsequently
+	 * (unless it is the block returned).  If the block is
+	 * enlarged, the added bytes are zero if zeroFilled(\a
+	 * new_bytes) is true, and otherwise uninitialised.
+	 *
+	 * @throws bad_alloc if the block cannot be reallocated, in
+	 * which case the original block is unaffected.
+	 *
+	 * @note This function should be used only for blocks whose
+	 * contents can safely be moved bitwise.  Where both sizes
+	 * are large objects, and \c mremap is available, the pages
+	 * are remapped rather than copied.
+	 */
+	static void* reallocate(void* p, size_t old_bytes, size_t new_bytes)
+	    throw (std::bad_alloc);
+
+	/** @brief Set a callback to sample allocations.
+	 *
+	 * Once a sampler is set, this class counts the bytes allocated
+	 * by the main thread, and every \a interval bytes calls the
+	 * sampler in respect of the allocation during which the count
+	 * passed a multiple of \a interval.  Unlike setMonitor(),
+	 * this facility is always available, and costs little when
+	 * no sampler is set.
+	 *
+	 * @param sampler This is a pointer to a function that this
+	 *          class will call with the first argument set to the
+	 *          address of the sampled block, the second to its
+	 *          size in bytes, and the third to the number of
+	 *          multiples of \a interval passed during the
+	 *          allocation (which may exceed 1 for a block larger
+	 *          than \a interval).  The sampler must not itself
+	 *          allocate memory via MemoryBank.  Alternatively,
+	 *          sampler can be set to a null pointer to discontinue
+	 *          sampling.
+	 *
+	 * @param interval Sampling interval in bytes.  Must be
+	 *          nonzero unless sampler is a null pointer.
+	 *
+	 * @note Allocations made via a ThreadCache are not sampled.
+	 */
+	static void setSampler(void (*sampler)(void*, size_t, unsigned int) = 0,
+			       size_t interval = 0);
+
+	/** @brief Size class of a block.
+	 *
+	 * @param bytes Size of a memory block in bytes.
+	 *
+	 * @return The index (counting from zero) of the cell pool
+	 * from which a block of this size is allocated, or -1 if such
+	 * a block is obtained directly from the main heap.
+	 */
+	static int sizeClass(size_t bytes)
+	{
+	    return (bytes >= s_new_threshold ? -1
+		    : s_pooltab[(bytes + 7) >> 3]);
+	}
+
+	/** @brief Are new blocks of a given size zero-filled?
+	 *
+	 * @param bytes Size of a memory block in bytes.
+	 *
+	 * @return true if the contents of a block of this size are
+	 * guaranteed to be zero when it is allocated.  This is so of
+	 * large objects, and callers can save both time and physical
+	 * memory by not zeroing such blocks themselves.
+	 */
+	static bool zeroFilled(size_t bytes)
+	{
+	    return bytes >= s_large_threshold;
+	}
+
 #ifdef R_MEMORY_PROFILING
 	/** Set a callback to monitor allocations exceeding a threshold size.
 	 *
@@ -158,10 +303,30 @@ namespace CXXR {
 	static const size_t s_num_pools = 10;
 	// We use ::operator new directly for allocations at least this big:
 	static const size_t s_new_threshold;
+	// Blocks at least this big are mapped directly from the
+	// operating system:
+	static const size_t s_large_threshold;
+	static size_t s_large_bytes;
 	static size_t s_blocks_allocated;
 	static size_t s_bytes_allocated;
 	static Pool* s_pools;
+	static Pool* s_depot;  // Pools from which ThreadCache objects
+	  // replenish their magazines.  Protected by a mutex.
+	static unsigned int s_num_thread_caches;  // Number of
+	  // ThreadCache objects in existence.
+	static bool s_thread_caches_used;  // True if any ThreadCache
+	  // has ever been created.
+	static long s_foreign_blocks;  // Net number of blocks allocated
+	  // via ThreadCache objects, as last reported by them.
+	static long s_foreign_bytes;  // Ditto for bytes.
+	static const long s_fold_bytes;  // A ThreadCache adds its
+	  // local tallies into the global ones whenever its local byte
+	  // tally reaches this magnitude.  This is a tuning parameter.
 	static const unsigned char s_pooltab[];
+	static void (*s_sampler)(void*, size_t, unsigned int);
+	static size_t s_sample_interval;
+	static long s_sample_countdown;  // Bytes remaining before the
+	  // next sample is taken.  Very large if there is no sampler.
 #ifdef R_MEMORY_PROFILING
 	static void (*s_monitor)(size_t);
 	static size_t s_monitor_threshold;
@@ -174,11 +339,108 @@ namespace CXXR {
 	// Free memory used by the static data members:
 	static void cleanup() {}
 
+	// Allocate and deallocate large objects:
+	static void* allocateLarge(size_t bytes) throw (std::bad_alloc);
+	static void deallocateLarge(void* p, size_t bytes);
+
+	// Deallocate a block via the calling thread's ThreadCache, if
+	// it has one.  Returns false if it does not.
+	static bool deallocateInThreadCache(void* p, size_t bytes);
+
 	// Initialize the static data members:
 	static void initialize();
 
+	// Called when s_sample_countdown goes negative:
+	static void sample(void* p, size_t bytes);
+
+	// Initialize an array of s_num_pools pools:
+	static void initializePools(Pool* pools);
+
 	friend class SchwarzCounter<MemoryBank>;
     };
+
+    /** @brief Per-thread cache of memory cells.
+     *
+     * A thread other than the main thread may call
+     * MemoryBank::allocate() and MemoryBank::deallocate() only
+     * while a ThreadCache object exists within that thread: the
+     * ThreadCache should normally be declared as an automatic
+     * variable at the start of the thread's code.
+     *
+     * While the ThreadCache exists, small blocks are allocated
+     * from, and released to, per-thread 'magazines' of free
+     * cells, one for each cell size.  An empty magazine is
+     * refilled from (and an overfull magazine partially emptied
+     * into) a global depot of cell pools protected by a mutex;
+     * transfers are made a superblock's worth of cells at a time.
+     * Blocks may be allocated in one thread and deallocated in
+     * another.
+     *
+     * The numbers of blocks and bytes allocated within a
+     * ThreadCache are tallied locally, and periodically added
+     * into the global totals reported by blocksAllocated() and
+     * bytesAllocated(), so these totals (and hence the triggering
+     * of garbage collection) are approximate while other threads
+     * are allocating.  The tallies are brought up to date when
+     * the ThreadCache is destroyed.
+     *
+     * @note Only memory allocation is made thread-safe in this
+     * way: GCNode objects must still be created and manipulated
+     * only within the main thread.
+     *
+     * @note ThreadCache is effective only on platforms providing
+     * POSIX threads and the gcc extensions for thread-local
+     * storage and atomic operations; on other platforms it does
+     * nothing.
+     */
+    class MemoryBank::ThreadCache {
+    public:
+	ThreadCache();
+
+	~ThreadCache();
+    private:
+	friend class MemoryBank;
+
+	// A magazine is a singly-linked list of free cells, linked
+	// through their first word:
+	struct Magazine {
+	    void* m_cells;
+	    size_t m_count;
+	};
+
+	Magazine m_magazines[s_num_pools];  // One for each pool.
+	long m_blocks;  // Blocks allocated (net) within this
+	  // ThreadCache, not yet added into s_foreign_blocks.
+	long m_bytes;  // Ditto for bytes.
+	ThreadCache* m_previous;  // ThreadCache (if any) that was
+	  // in use in this thread before this one was created.
+
+	// Not implemented:
+	ThreadCache(const ThreadCache&);
+	ThreadCache& operator=(const ThreadCache&);
+
+	void* allocate(size_t bytes);
+
+	void deallocate(void* p, size_t bytes);
+
+	// Add the local tallies into the global ones:
+	void fold();
+
+	// Return a batch of cells from a magazine to the depot:
+	void release(unsigned int pool);
+
+	// Refill an empty magazine from the depot:
+	void replenish(unsigned int pool);
+
+	// Adjust the local tallies:
+	void tally(long blocks, long bytes)
+	{
+	    m_blocks += blocks;
+	    m_bytes += bytes;
+	    if (m_bytes > s_fold_bytes || m_bytes < -s_fold_bytes)
+		fold();
+	}
+    };
 }
 
 namespace {
@@ -51,6 +51,7 @@
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/nvp.hpp>
 
+#include "CXXR/AllocationProfiler.hpp"
 #include "CXXR/GCNode_PtrS11n.hpp"
 #include "CXXR/RHandle.hpp"
 #include "CXXR/uncxxr.h"
@@ -549,8 +550,11 @@ namespace CXXR {
 	explicit RObject(SEXPTYPE stype = CXXSXP)
 	    : m_type(stype & s_sexptype_mask), m_named(0),
 	      m_memory_traced(false), m_missing(0), m_argused(0),
-	      m_active_binding(false), m_binding_locked(false)
-	{}
+	      m_active_binding(false), m_binding_locked(false),
+	      m_vector_properties(0)
+	{
+	    AllocationProfiler::noteType(this, stype);
+	}
 
 	/** @brief Copy constructor.
 	 *
@@ -616,6 +620,16 @@ namespace CXXR {
 	bool m_active_binding : 1;
 	bool m_binding_locked : 1;
     private:
+	// The following field is used only by class VectorBase, to
+	// record properties of the vector's elements that are known
+	// to hold (see VectorBase::Property), so it would more
+	// logically be placed in that class.  It is placed here,
+	// where it occupies what would otherwise be padding, so that
+	// vector objects do not grow.  Setting of this field is not
+	// preserved in CXXR-style serialization.
+	friend class VectorBase;
+	mutable unsigned char m_vector_properties;
+
 	RHandle<PairList> m_attrib;
 
 	template<class Archive>
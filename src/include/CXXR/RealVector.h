@@ -116,6 +116,28 @@ inline double *REAL(SEXP x)
 }
 #endif
 
+/**
+ * @brief Read-only access to the elements of a real vector.
+ *
+ * Unlike REAL(), this function leaves any recorded properties of
+ * the elements intact (see CXXR::VectorBase::Property).
+ *
+ * @param x Pointer to an \c RealVector (i.e. an R numeric vector).
+ *          An error is generated if \a x is not pointer to an \c
+ *          RealVector .
+ *
+ * @return Const pointer to element 0 of \a x .
+ */
+#ifndef __cplusplus
+const double *REAL_RO(SEXP x);
+#else
+inline const double *REAL_RO(SEXP x)
+{
+    using namespace CXXR;
+    return &(*SEXP_downcast<const RealVector*>(x, false))[0];
+}
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -108,7 +108,12 @@ namespace CXXR {
 	// Virtual function of GCNode:
 	void detachReferents();
     private:
-	GCEdge<Environment> m_environment;
+	// A plain pointer suffices, because the target Environment
+	// is necessarily live while the Bailout is in transit.  (A
+	// GCEdge would moreover prevent Closure::invoke() from
+	// recycling the Environment until the spent Bailout had been
+	// garbage-collected.)
+	Environment* m_environment;
 	GCEdge<> m_value;
 	bool m_print_result;
 
@@ -0,0 +1,259 @@
+/*CXXR $Id$
+ *CXXR
+ *CXXR This file is part of CXXR, a project to refactor the R interpreter
+ *CXXR into C++.  It may consist in whole or in part of program code and
+ *CXXR documentation taken from the R project itself, incorporated into
+ *CXXR CXXR (and possibly MODIFIED) under the terms of the GNU General Public
+ *CXXR Licence.
+ *CXXR
+ *CXXR CXXR is Copyright (C) 2008-14 Andrew R. Runnalls, subject to such other
+ *CXXR copyrights and copyright restrictions as may be stated below.
+ *CXXR
+ *CXXR CXXR is not part of the R project, and bugs and other issues should
+ *CXXR not be reported via r-bugs or other R project channels; instead refer
+ *CXXR to the CXXR website.
+ *CXXR */
+
+/** @file SlotFrame.hpp
+ *
+ * @brief Class CXXR::SlotFrame.
+ */
+
+#ifndef SLOTFRAME_HPP
+#define SLOTFRAME_HPP
+
+#include <tr1/unordered_map>
+#include <vector>
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/base_object.hpp>
+#include <boost/serialization/nvp.hpp>
+#include <boost/serialization/split_member.hpp>
+
+#include "CXXR/Allocator.hpp"
+#include "CXXR/Frame.hpp"
+#include "CXXR/GCStackRoot.hpp"
+
+namespace CXXR {
+    class PairList;
+
+    /** @brief Frame with Bindings at precomputed offsets.
+     *
+     * This implementation is intended for the working environments
+     * of Closure calls.  Each such Frame is created from a
+     * SlotFrame::Layout, which is computed once per Closure from its
+     * formal arguments and from a scan of its body for Symbols that
+     * are assigned to locally.  Each Symbol of the Layout has its
+     * own slot in a contiguous array of Bindings, and the Layout
+     * maps a Symbol to its slot by a short probe of a small
+     * open-addressed hash table.
+     *
+     * Symbols not anticipated by the Layout (for example those
+     * bound by assign() or by eval() within the Frame) are held in
+     * an overflow map, which is created only when first needed.
+     */
+    class SlotFrame : public Frame {
+    public:
+	/** @brief Assignment of Symbols to slots.
+	 *
+	 * A Layout is immutable once created, and may be shared by
+	 * any number of SlotFrame objects.
+	 */
+	class Layout : public GCNode {
+	public:
+	    /** @brief Layout for the working Frame of a Closure.
+	     *
+	     * @param formals List of formal arguments of the
+	     *          Closure; every element must have a Symbol as
+	     *          its tag.
+	     *
+	     * @param body The body of the Closure.  Symbols that
+	     *          appear as the targets of local assignments or
+	     *          as the variables of \c for loops are given
+	     *          slots following those of the formal
+	     *          arguments.  The bodies of any nested function
+	     *          definitions are not scanned.
+	     */
+	    Layout(const PairList* formals, const RObject* body);
+
+	    /** @brief Number of slots.
+	     *
+	     * @return The number of slots in the Layout.
+	     */
+	    std::size_t size() const
+	    {
+		return m_symbols.size();
+	    }
+
+	    /** @brief Slot allocated to a Symbol.
+	     *
+	     * @param symbol Non-null pointer to the Symbol sought.
+	     *
+	     * @return The index of the slot allocated to \a symbol,
+	     * or -1 if \a symbol has no slot in this Layout.
+	     */
+	    int slot(const Symbol* symbol) const
+	    {
+		std::size_t i = hash(symbol);
+		int s;
+		while ((s = m_table[i]) >= 0 && m_symbols[s] != symbol)
+		    i = (i + 1) & m_mask;
+		return s;
+	    }
+
+	    /** @brief Symbol allocated to a slot.
+	     *
+	     * @param slot Index of a slot within the Layout.
+	     *
+	     * @return Pointer to the Symbol allocated to slot \a slot.
+	     */
+	    const Symbol* symbol(unsigned int slot) const
+	    {
+		return m_symbols[slot];
+	    }
+	private:
+	    std::vector<const Symbol*> m_symbols;
+	    std::vector<int> m_table;  // Open-addressed hash table of
+			// indices into m_symbols; -1 denotes an empty
+			// position.  At most half full.
+	    std::size_t m_mask;  // m_table.size() - 1
+
+	    // Declared private to ensure that Layout objects are
+	    // created only using 'new':
+	    ~Layout() {}
+
+	    // Not implemented.  Declared to prevent
+	    // compiler-generated versions:
+	    Layout(const Layout&);
+	    Layout& operator=(const Layout&);
+
+	    // Give symbol a slot if it does not already have one:
+	    void addSymbol(const Symbol* symbol);
+
+	    // Scan expression for local assignments:
+	    void scan(const RObject* expression);
+
+	    std::size_t hash(const Symbol* symbol) const
+	    {
+		// Symbol objects are at least 8-byte aligned:
+		return (reinterpret_cast<std::size_t>(symbol) >> 3) & m_mask;
+	    }
+	};
+
+	/**
+	 * @param layout Non-null pointer to the Layout to be used.
+	 */
+	explicit SlotFrame(const Layout* layout);
+
+	/** @brief Layout of this Frame.
+	 *
+	 * @return Pointer to the Layout used by this Frame.
+	 */
+	const Layout* layout() const
+	{
+	    return m_layout;
+	}
+
+	// Virtual functions of Frame (qv):
+#ifdef __GNUG__
+	__attribute__((hot,fastcall))
+#endif
+	Binding* binding(const Symbol* symbol);
+
+	const Binding* binding(const Symbol* symbol) const;
+	BindingRange bindingRange() const;
+	SlotFrame* clone() const;
+	void lockBindings();
+	const GCNode* shape() const;
+	std::size_t size() const;
+
+	// Virtual function of GCNode:
+	void visitReferents(const_visitor* v) const;
+    protected:
+	// Virtual function of GCNode:
+	void detachReferents();
+    private:
+	friend class boost::serialization::access;
+
+	typedef std::vector<Binding, CXXR::Allocator<Binding> > Slots;
+	typedef
+	std::tr1::unordered_map<const Symbol*, Binding,
+				std::tr1::hash<const Symbol*>,
+				std::equal_to<const Symbol*>,
+				CXXR::Allocator<std::pair<const Symbol* const,
+							  Binding> >
+	                        > Overflow;
+
+	GCEdge<const Layout> m_layout;
+	Slots m_slots;  // A slot whose Binding has a null frame() is
+			// vacant.  Never resized, so that pointers to
+			// Bindings remain valid.
+	Overflow* m_overflow;  // Created on demand.
+
+	// Used by boost::serialization, which then places all
+	// Bindings in the overflow map:
+	SlotFrame();
+
+	SlotFrame(const SlotFrame& source);
+
+	// Declared private to ensure that SlotFrame objects are
+	// created only using 'new':
+	~SlotFrame()
+	{
+	    delete m_overflow;
+	}
+
+	// Not (yet) implemented.  Declared to prevent
+	// compiler-generated versions:
+	SlotFrame& operator=(const SlotFrame&);
+
+	// Used in place of the overflow map if there is none:
+	static const Overflow& emptyOverflow();
+
+	// Return a slot's Binding to the vacant state:
+	static void vacate(Binding* bdg);
+
+	template<class Archive>
+	void load(Archive& ar, const unsigned int version)
+	{
+	    ar >> BOOST_SERIALIZATION_BASE_OBJECT_NVP(Frame);
+	    size_t numberOfBindings;
+	    ar >> BOOST_SERIALIZATION_NVP(numberOfBindings);
+	    for (size_t i = 0; i < numberOfBindings; ++i) {
+		GCStackRoot<Symbol> symbol;
+		GCNPTR_SERIALIZE(ar, symbol);
+		Binding* binding = obtainBinding(symbol);
+		ar >> boost::serialization::make_nvp("binding", *binding);
+	    }
+	}
+
+	template<class Archive>
+	void save(Archive& ar, const unsigned int version) const
+	{
+	    ar << BOOST_SERIALIZATION_BASE_OBJECT_NVP(Frame);
+	    size_t numberOfBindings = size();
+	    ar << BOOST_SERIALIZATION_NVP(numberOfBindings);
+	    BindingRange bdgs = bindingRange();
+	    for (BindingRange::const_iterator it = bdgs.begin();
+		 it != bdgs.end(); ++it) {
+		const Binding& binding = *it;
+		const Symbol* symbol = binding.symbol();
+		GCNPTR_SERIALIZE(ar, symbol);
+		ar << BOOST_SERIALIZATION_NVP(binding);
+	    }
+	}
+
+	template<class Archive>
+	void serialize(Archive& ar, const unsigned int version) {
+	    boost::serialization::split_member(ar, *this, version);
+	}
+
+	// Virtual functions of Frame (qv):
+	void v_clear();
+	bool v_erase(const Symbol* symbol);
+	Binding* v_obtainBinding(const Symbol* symbol);
+    };
+}  // namespace CXXR
+
+BOOST_CLASS_EXPORT_KEY(CXXR::SlotFrame)
+
+#endif // SLOTFRAME_HPP
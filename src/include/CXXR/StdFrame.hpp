@@ -42,28 +42,29 @@
 #ifndef STDFRAME_HPP
 #define STDFRAME_HPP
 
-#include <tr1/unordered_map>
+#include <deque>
+#include <vector>
 #include <boost/serialization/access.hpp>
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/nvp.hpp>
 #include <boost/serialization/split_member.hpp>
-#include <boost/serialization/unordered_map.hpp>
 
 #include "CXXR/Allocator.hpp"
 #include "CXXR/Frame.hpp"
 
 namespace CXXR {
     /** @brief General-purpose implementation of CXXR::Frame.
+     *
+     * Bindings are held in a std::deque in order of creation, so
+     * that pointers to them remain valid as further Bindings are
+     * added, and so that iteration order depends only on the
+     * sequence of insertions and removals.  A slot vacated by the
+     * removal of a Binding is reused for the next Binding created.
+     *
+     * Symbols are mapped to slots by an open-addressed hash table
+     * using linear probing, which is kept at most half full.
      */
     class StdFrame : public Frame {
-    private:
-	typedef
-	std::tr1::unordered_map<const Symbol*, Binding,
-				std::tr1::hash<const Symbol*>,
-				std::equal_to<const Symbol*>,
-				CXXR::Allocator<std::pair<const Symbol* const,
-							  Binding> >
-	                        > map;
     public:
 	/**
 	 * @param initial_capacity A hint to the implementation that
@@ -75,11 +76,9 @@ namespace CXXR {
 	 *          penalty) may occur if it is exceeded.
 	 */
 	explicit StdFrame(std::size_t initial_capacity = 15);
-	// Why 15?  Because if the implementation uses a prime number
-	// hash table sizing policy, this will result in the
-	// allocation of a hash table array comprising 31 buckets.  On
-	// a 32-bit architecture, this will fit well into two 64-byte
-	// cache lines.
+	// Why 15?  Because this will result in a hash table of 32
+	// entries, which on a 64-bit architecture occupies eight
+	// 64-byte cache lines.
 
 	// Virtual functions of Frame (qv):
 #ifdef __GNUG__
@@ -95,7 +94,28 @@ namespace CXXR {
     private:
 	friend class boost::serialization::access;
 
-	map m_map;
+	// Entry in the hash table.  A null m_symbol denotes an empty
+	// entry.
+	struct Entry {
+	    const Symbol* m_symbol;
+	    unsigned int m_slot;
+
+	    Entry()
+		: m_symbol(0), m_slot(0)
+	    {}
+	};
+
+	typedef std::deque<Binding, CXXR::Allocator<Binding> > Slots;
+
+	Slots m_slots;  // A slot whose Binding has a null frame() is
+			// vacant.
+	std::vector<unsigned int> m_vacated;  // Slots available for
+			// reuse, each of which has no entry in the hash
+			// table.
+	std::vector<Entry> m_table;
+	std::size_t m_entries;  // Number of non-empty entries in m_table.
+	unsigned int m_shift;  // Number of bits in std::size_t less
+			// log2 of m_table.size().
 
 	// Declared private to ensure that StdFrame objects are
 	// created only using 'new':
@@ -105,6 +125,31 @@ namespace CXXR {
 	// compiler-generated versions:
 	StdFrame& operator=(const StdFrame&);
 
+	// Index of the entry in m_table for symbol, or of the empty
+	// entry at which symbol would be inserted:
+	std::size_t find(const Symbol* symbol) const
+	{
+	    std::size_t mask = m_table.size() - 1;
+	    std::size_t i = hash(symbol);
+	    const Symbol* sym;
+	    while ((sym = m_table[i].m_symbol) && sym != symbol)
+		i = (i + 1) & mask;
+	    return i;
+	}
+
+	// Fibonacci hashing of the Symbol's address.  The high-order
+	// bits of the product are used, because the low-order bits of
+	// Symbol addresses vary little:
+	std::size_t hash(const Symbol* symbol) const
+	{
+	    return (reinterpret_cast<std::size_t>(symbol)
+		    * std::size_t(0x9e3779b97f4a7c15ULL)) >> m_shift;
+	}
+
+	// Resize m_table to have capacity entries (which must be a
+	// power of two):
+	void rehash(std::size_t capacity);
+
 	template<class Archive>
 	void load(Archive& ar, const unsigned int version);
 	
@@ -144,10 +189,12 @@ namespace CXXR {
 	ar << BOOST_SERIALIZATION_BASE_OBJECT_NVP(Frame);
 	size_t numberOfBindings = size();
 	ar << BOOST_SERIALIZATION_NVP(numberOfBindings);
-	for (map::const_iterator it = m_map.begin();
-	     it != m_map.end(); ++it) {
-	    const Symbol* symbol = (*it).first;
-	    const Binding& binding = (*it).second;
+	for (Slots::const_iterator it = m_slots.begin();
+	     it != m_slots.end(); ++it) {
+	    const Binding& binding = *it;
+	    if (!binding.frame())
+		continue;
+	    const Symbol* symbol = binding.symbol();
 	    GCNPTR_SERIALIZE(ar, symbol);
 	    ar << BOOST_SERIALIZATION_NVP(binding);
 	}
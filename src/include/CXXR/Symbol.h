@@ -158,6 +158,30 @@ namespace CXXR {
 	    return m_dd_index != 0;
 	}
 
+	/** @brief May lookups of this Symbol be cached inline?
+	 *
+	 * @return true iff Environment::watchLookup() has been
+	 * called for this Symbol, so that the creation or removal
+	 * of a Binding of it may invalidate inline lookup caches.
+	 */
+	bool lookupWatched() const
+	{
+	    return m_lookup_watched;
+	}
+
+	/** @brief Report that lookups of this Symbol may be cached
+	 *         inline.
+	 *
+	 * Called by Environment::watchLookup().  Once this function
+	 * has been called, the creation or removal of a Binding of
+	 * this Symbol in a watched or cached Frame will invalidate
+	 * inline lookup caches.
+	 */
+	void markLookupWatched() const
+	{
+	    m_lookup_watched = true;
+	}
+
 	/** @brief Maximum length of symbol names.
 	 *
 	 * @return The maximum permitted length of symbol names.
@@ -273,6 +297,7 @@ namespace CXXR {
 	GCEdge<const String> m_name;
 
 	unsigned int m_dd_index;
+	mutable bool m_lookup_watched;
 
 	enum S11nType {NORMAL = 0, MISSINGARG, UNBOUNDVALUE};
 
@@ -74,6 +74,37 @@ namespace CXXR {
     public:
 	typedef std::size_t size_type;
 
+	/** @brief Properties of the elements of a vector.
+	 *
+	 * Code that has established, in the course of scanning a
+	 * vector, that one of these properties holds can record the
+	 * fact using noteProperty(), so that later code can consult
+	 * knownToHave() instead of scanning the vector again.  The
+	 * record is discarded whenever non-const access to the
+	 * elements is obtained (e.g. via REAL() or INTEGER(), or the
+	 * non-const <tt>operator[]</tt> and begin() of FixedVector),
+	 * or the vector is resized.
+	 *
+	 * Consequently code that wishes a vector's properties to
+	 * remain on record should read the elements via const
+	 * access, e.g. using REAL_RO() or INTEGER_RO().  Conversely
+	 * code that retains a non-const pointer or iterator into the
+	 * elements, and writes through it after a property may have
+	 * been noted, must call forgetProperties().
+	 */
+	enum Property {
+	    NO_NA = 1,  /**< No element is NA; for vectors of
+			 * doubles, no element is NaN either.
+			 */
+	    SORTED_INCREASING = 2,  /**< No element compares greater
+				     * than its successor (cf.
+				     * isUnsorted()).
+				     */
+	    SORTED_DECREASING = 4  /**< No element compares less than
+				    * its successor.
+				    */
+	};
+
 	/**
 	 * @param stype The required ::SEXPTYPE.
 	 * @param sz The required number of elements in the vector.
@@ -89,7 +120,9 @@ namespace CXXR {
 	VectorBase(const VectorBase& pattern)
 	    : RObject(pattern), m_xtruelength(pattern.m_xtruelength),
 	      m_size(pattern.m_size)
-	{}
+	{
+	    m_vector_properties = pattern.m_vector_properties;
+	}
 
 	/** @brief Names associated with the rows, columns or other
 	 *  dimensions of an R matrix or array.
@@ -140,6 +173,28 @@ namespace CXXR {
 	 */
 	const IntVector* dimensions() const;
 
+	/** @brief Discard any recorded properties of the elements.
+	 *
+	 * @see Property
+	 */
+	void forgetProperties() const
+	{
+	    m_vector_properties = 0;
+	}
+
+	/** @brief Is a property of the elements known to hold?
+	 *
+	 * @param property The property of interest.
+	 *
+	 * @return true if \a property has been recorded by
+	 * noteProperty() and not since discarded.  A false return
+	 * value does not imply that the property fails.
+	 */
+	bool knownToHave(Property property) const
+	{
+	    return (m_vector_properties & property) != 0;
+	}
+
 	/** @brief Names of vector elements.
 	 *
 	 * @return either a null pointer (if the elements do not have
@@ -148,6 +203,17 @@ namespace CXXR {
 	 */
 	const StringVector* names() const;
 
+	/** @brief Record that a property of the elements holds.
+	 *
+	 * @param property A property which the caller has
+	 *          established that the elements of \a *this
+	 *          currently possess.
+	 */
+	void noteProperty(Property property) const
+	{
+	    m_vector_properties |= property;
+	}
+
 	/** @brief Create an extended or shrunken copy of an R vector.
 	 *
 	 * @tparam V A type inheriting from VectorBase.
@@ -317,6 +383,7 @@ namespace CXXR {
 	 */
 	void adjustSize(size_type new_size)
 	{
+	    forgetProperties();
 	    m_size = new_size;
 	    setAttributes(resizeAttributes(attributes(), new_size));
 	}
@@ -0,0 +1,209 @@
+/*CXXR $Id$
+ *CXXR
+ *CXXR This file is part of CXXR, a project to refactor the R interpreter
+ *CXXR into C++.  It may consist in whole or in part of program code and
+ *CXXR documentation taken from the R project itself, incorporated into
+ *CXXR CXXR (and possibly MODIFIED) under the terms of the GNU General Public
+ *CXXR Licence.
+ *CXXR
+ *CXXR CXXR is Copyright (C) 2008-14 Andrew R. Runnalls, subject to such other
+ *CXXR copyrights and copyright restrictions as may be stated below.
+ *CXXR
+ *CXXR CXXR is not part of the R project, and bugs and other issues should
+ *CXXR not be reported via r-bugs or other R project channels; instead refer
+ *CXXR to the CXXR website.
+ *CXXR */
+
+/** @file VectorKernels.hpp
+ *
+ * @brief Namespace VectorOps::Kernels.
+ */
+
+#ifndef VECTORKERNELS_HPP
+#define VECTORKERNELS_HPP 1
+
+#include <climits>
+#include <cstddef>
+
+// Runtime selection of AVX2 code uses gcc's function-specific target
+// options and CPU detection, which are available from gcc 4.8:
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+    && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 8))
+#define CXXR_AVX2_KERNELS
+#endif
+
+// At -O2, gcc does not vectorise loops whose trip count is unknown, so
+// the kernels (and other loops written to be vectorised, such as the
+// reductions in summary.cpp) request more aggressive optimisation:
+#if defined(__GNUC__) && !defined(__clang__)
+#define CXXR_KERNEL_OPTIMIZE __attribute__((optimize("O3")))
+#else
+#define CXXR_KERNEL_OPTIMIZE
+#endif
+
+namespace CXXR {
+    namespace VectorOps {
+	/** @brief Branch-free element-wise kernels.
+	 *
+	 * This namespace provides loops applying a binary operation
+	 * to arrays of double or int data, for use where both
+	 * operands have the same length, or one of them has length
+	 * one.  The operations are written without branches, NA
+	 * propagation being carried out by selection between the
+	 * computed value and NA, so that the compiler can vectorise
+	 * the loops.  On x86 processors built with a suitable gcc,
+	 * each loop is compiled both for the baseline instruction
+	 * set (SSE2 on x86-64) and for AVX2, and the AVX2 version is
+	 * used if the processor supports it.
+	 *
+	 * An operation is a class with a (preferably inline)
+	 * function call operator taking two operand elements and
+	 * returning the result element.  Objects of the class are
+	 * default-constructed once per call of map().
+	 */
+	namespace Kernels {
+	    /** @brief Comparison of doubles yielding an R logical.
+	     *
+	     * @tparam Relop Comparison function object class template,
+	     *           e.g. std::less.
+	     *
+	     * The result is NA if either operand is NA or NaN.
+	     */
+	    template <template <typename> class Relop>
+	    struct RealComparison {
+		int operator()(double l, double r) const
+		{
+		    bool nan = (l != l) | (r != r);
+		    return nan ? int(INT_MIN) : int(Relop<double>()(l, r));
+		}
+	    };
+
+	    /** @brief Comparison of ints yielding an R logical.
+	     *
+	     * @tparam Relop Comparison function object class template,
+	     *           e.g. std::less.
+	     *
+	     * The result is NA if either operand is NA.  This is
+	     * applicable both to integer and to logical operands.
+	     */
+	    template <template <typename> class Relop>
+	    struct IntComparison {
+		int operator()(int l, int r) const
+		{
+		    // R's NA for integers and logicals is INT_MIN:
+		    bool na = (l == INT_MIN) | (r == INT_MIN);
+		    return na ? int(INT_MIN) : int(Relop<int>()(l, r));
+		}
+	    };
+
+	    /** @brief Arithmetic on doubles.
+	     *
+	     * @tparam Op Arithmetic function object class, e.g.
+	     *           std::plus<double>.
+	     *
+	     * NA and NaN are propagated by IEEE 754 arithmetic, as
+	     * elsewhere in R's real arithmetic.
+	     */
+	    template <class Op>
+	    struct RealArithmetic {
+		double operator()(double l, double r) const
+		{
+		    return Op()(l, r);
+		}
+	    };
+
+	    // Loop of map(), with lstep and rstep (each 0 or 1)
+	    // indicating whether the operand is an array or a scalar:
+	    template <class Op, int lstep, int rstep,
+		      typename O, typename L, typename R>
+	    CXXR_KERNEL_OPTIMIZE
+	    void mapLoop(O* out, const L* l, const R* r,
+				std::size_t n)
+	    {
+		Op op;
+		if (lstep == 0) {
+		    const L lval = *l;
+		    for (std::size_t i = 0; i < n; ++i)
+			out[i] = op(lval, r[i]);
+		} else if (rstep == 0) {
+		    const R rval = *r;
+		    for (std::size_t i = 0; i < n; ++i)
+			out[i] = op(l[i], rval);
+		} else {
+		    for (std::size_t i = 0; i < n; ++i)
+			out[i] = op(l[i], r[i]);
+		}
+	    }
+
+#ifdef CXXR_AVX2_KERNELS
+	    template <class Op, int lstep, int rstep,
+		      typename O, typename L, typename R>
+	    __attribute__((target("avx2"))) CXXR_KERNEL_OPTIMIZE
+	    void mapLoopAVX2(O* out, const L* l, const R* r, std::size_t n)
+	    {
+		mapLoop<Op, lstep, rstep>(out, l, r, n);
+	    }
+
+	    /** @brief Can AVX2 kernels be used?
+	     *
+	     * @return true iff the processor supports the AVX2
+	     * instruction set.
+	     */
+	    inline bool avx2Available()
+	    {
+		static const bool ans = __builtin_cpu_supports("avx2");
+		return ans;
+	    }
+#endif
+
+	    // Select the version of mapLoop() suited to the processor:
+	    template <class Op, int lstep, int rstep,
+		      typename O, typename L, typename R>
+	    inline void dispatch(O* out, const L* l, const R* r,
+				 std::size_t n)
+	    {
+#ifdef CXXR_AVX2_KERNELS
+		if (avx2Available()) {
+		    mapLoopAVX2<Op, lstep, rstep>(out, l, r, n);
+		    return;
+		}
+#endif
+		mapLoop<Op, lstep, rstep>(out, l, r, n);
+	    }
+
+	    /** @brief Apply an operation element by element.
+	     *
+	     * @tparam Op Class of the operation to be applied.
+	     *
+	     * @param out Pointer to the start of the array to which
+	     *          the results are to be written, which must have
+	     *          room for the larger of \a nl and \a nr
+	     *          elements.  It may coincide with an operand of
+	     *          the same length, but must not otherwise overlap
+	     *          either operand.
+	     *
+	     * @param l Pointer to the start of the first operand.
+	     *
+	     * @param nl Number of elements in the first operand.
+	     *          Must be equal to \a nr, or equal to 1.
+	     *
+	     * @param r Pointer to the start of the second operand.
+	     *
+	     * @param nr Number of elements in the second operand.
+	     *          Must be equal to \a nl, or equal to 1.
+	     */
+	    template <class Op, typename O, typename L, typename R>
+	    void map(O* out, const L* l, std::size_t nl,
+		     const R* r, std::size_t nr)
+	    {
+		if (nl == nr)
+		    dispatch<Op, 1, 1>(out, l, r, nl);
+		else if (nl == 1)
+		    dispatch<Op, 0, 1>(out, l, r, nr);
+		else dispatch<Op, 1, 0>(out, l, r, nl);
+	    }
+	}  // namespace Kernels
+    }  // namespace VectorOps
+}  // namespace CXXR
+
+#endif  // VECTORKERNELS_HPP
@@ -0,0 +1,140 @@
+/*CXXR $Id$
+ *CXXR
+ *CXXR This file is part of CXXR, a project to refactor the R interpreter
+ *CXXR into C++.  It may consist in whole or in part of program code and
+ *CXXR documentation taken from the R project itself, incorporated into
+ *CXXR CXXR (and possibly MODIFIED) under the terms of the GNU General Public
+ *CXXR Licence.
+ *CXXR
+ *CXXR CXXR is Copyright (C) 2008-14 Andrew R. Runnalls, subject to such other
+ *CXXR copyrights and copyright restrictions as may be stated below.
+ *CXXR
+ *CXXR CXXR is not part of the R project, and bugs and other issues should
+ *CXXR not be reported via r-bugs or other R project channels; instead refer
+ *CXXR to the CXXR website.
+ *CXXR */
+
+/** @file WorkerPool.hpp
+ *
+ * @brief Class CXXR::WorkerPool.
+ */
+
+#ifndef WORKERPOOL_HPP
+#define WORKERPOOL_HPP
+
+#include <cstddef>
+
+namespace CXXR {
+    /** @brief Persistent threads for data-parallel loops.
+     *
+     * WorkerPool divides a range of indices into contiguous chunks,
+     * and processes the chunks concurrently: the calling thread
+     * works on chunks alongside threads of a pool which are created
+     * when first needed, and thereafter wait for further work
+     * rather than exiting.  run() returns only when all the chunks
+     * have been processed.
+     *
+     * A range is divided only if it is long enough for the
+     * division to repay the cost of waking the pool threads, so
+     * short vectors are processed by the calling thread alone, as
+     * before.  If POSIX threads are not available, the calling
+     * thread always processes the whole range.
+     *
+     * runEach() uses the same threads to run a fixed number of
+     * tasks side by side, e.g. to share the mark phase of a garbage
+     * collection.
+     *
+     * Tasks run on the pool threads in parallel with one another,
+     * and must not call into the interpreter: they must not
+     * allocate GCNode objects, raise R errors or warnings, check
+     * for user interrupts or throw exceptions.  Any conditions
+     * that call for a warning should instead be recorded on a
+     * per-chunk basis, and the warning raised by the caller once
+     * run() has returned.
+     *
+     * This class only has static members.
+     */
+    class WorkerPool {
+    public:
+	/** @brief Function processing one chunk.
+	 *
+	 * @param data The pointer supplied to run().
+	 *
+	 * @param begin Index of the first element of the chunk.
+	 *
+	 * @param end One past the index of the last element of the
+	 *          chunk.
+	 *
+	 * @param chunk Number of the chunk, in the range from 0 to
+	 *          one less than the value returned by numChunks().
+	 *          Chunks are numbered in increasing order of \a
+	 *          begin.
+	 */
+	typedef void (*Task)(void* data, std::size_t begin,
+			     std::size_t end, unsigned int chunk);
+
+	/** @brief Number of chunks into which a range is divided.
+	 *
+	 * @param n Number of elements in the range.
+	 *
+	 * @param max_threads Maximum number of threads (including
+	 *          the calling thread) to be used.
+	 *
+	 * @return The number of chunks into which run() will divide
+	 * a range of \a n elements, given \a max_threads.  This is
+	 * always at least 1.
+	 */
+	static unsigned int numChunks(std::size_t n,
+				      unsigned int max_threads);
+
+	/** @brief Process a range in parallel.
+	 *
+	 * @param task Function to be applied to each chunk.
+	 *
+	 * @param data Pointer passed as the first argument to each
+	 *          invocation of \a task .
+	 *
+	 * @param n Number of elements in the range, which is
+	 *          divided into numChunks(n, max_threads) chunks.
+	 *
+	 * @param max_threads Maximum number of threads (including
+	 *          the calling thread) to be used.
+	 *
+	 * @param granularity Chunk boundaries are placed at
+	 *          multiples of this number of elements.  The default
+	 *          ensures that chunks of doubles or ints do not share
+	 *          cache lines.
+	 */
+	static void run(Task task, void* data, std::size_t n,
+			unsigned int max_threads,
+			std::size_t granularity = 64);
+
+	/** @brief Run a number of tasks concurrently.
+	 *
+	 * Invokes <tt>task(data, i, i + 1, i)</tt> for each \a i
+	 * from 0 to <tt>num_tasks - 1</tt>, sharing the invocations
+	 * between the calling thread and up to <tt>num_tasks -
+	 * 1</tt> threads of the pool, however short the task.
+	 * Invocations are started in increasing order of \a i, but
+	 * if a thread is slow to wake (or POSIX threads are not
+	 * available) one thread may carry out several invocations in
+	 * turn.  So no invocation may wait for a later one to start.
+	 *
+	 * @param task Function to be invoked.
+	 *
+	 * @param data Pointer passed as the first argument to each
+	 *          invocation of \a task .
+	 *
+	 * @param num_tasks Number of invocations required.
+	 */
+	static void runEach(Task task, void* data, unsigned int num_tasks);
+    private:
+	static const std::size_t s_min_chunk;  // Minimum number of
+	  // elements in a chunk.
+
+	// Not implemented:
+	WorkerPool();
+    };
+}  // namespace CXXR
+
+#endif  // WORKERPOOL_HPP
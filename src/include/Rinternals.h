@@ -228,8 +228,10 @@ int  (SETLEVELS)(SEXP x, int v);
 
 int  *(LOGICAL)(SEXP x);
 int  *(INTEGER)(SEXP x);
+const int *(INTEGER_RO)(SEXP x);
 Rbyte *(RAW)(SEXP x);
 double *(REAL)(SEXP x);
+const double *(REAL_RO)(SEXP x);
 Rcomplex *(COMPLEX)(SEXP x);
 SEXP (STRING_ELT)(SEXP x, R_xlen_t i);
 SEXP (VECTOR_ELT)(SEXP x, R_xlen_t i);
@@ -76,6 +76,9 @@ static const R_ExternalMethodDef ExtEntries[] = {
     EXTDEF(unzip, 7),
     EXTDEF(Rprof, 8),
     EXTDEF(Rprofmem, 3),
+    EXTDEF(Rprofalloc, 1),
+    EXTDEF(Rprofstack, 2),
+    EXTDEF(Rprofbuiltin, 2),
 
     EXTDEF(countfields, 6),
     EXTDEF(readtablehead, 6),
@@ -41,6 +41,24 @@ SEXP Rprofmem(SEXP args)
     return do_Rprofmem(CDR(args));
 }
 
+SEXP do_Rprofalloc(SEXP args);
+SEXP Rprofalloc(SEXP args)
+{
+    return do_Rprofalloc(CDR(args));
+}
+
+SEXP do_Rprofstack(SEXP args);
+SEXP Rprofstack(SEXP args)
+{
+    return do_Rprofstack(CDR(args));
+}
+
+SEXP do_Rprofbuiltin(SEXP args);
+SEXP Rprofbuiltin(SEXP args)
+{
+    return do_Rprofbuiltin(CDR(args));
+}
+
 /* from src/main/dounzip.c */
 SEXP Runzip(SEXP args);
 
@@ -28,6 +28,9 @@ SEXP objectSize(SEXP s);
 SEXP unzip(SEXP args);
 SEXP Rprof(SEXP args);
 SEXP Rprofmem(SEXP args);
+SEXP Rprofalloc(SEXP args);
+SEXP Rprofstack(SEXP args);
+SEXP Rprofbuiltin(SEXP args);
 
 SEXP countfields(SEXP args);
 SEXP flushconsole(void);
@@ -0,0 +1,128 @@
+/*CXXR $Id$
+ *CXXR
+ *CXXR This file is part of CXXR, a project to refactor the R interpreter
+ *CXXR into C++.  It may consist in whole or in part of program code and
+ *CXXR documentation taken from the R project itself, incorporated into
+ *CXXR CXXR (and possibly MODIFIED) under the terms of the GNU General Public
+ *CXXR Licence.
+ *CXXR
+ *CXXR CXXR is Copyright (C) 2008-14 Andrew R. Runnalls, subject to such other
+ *CXXR copyrights and copyright restrictions as may be stated below.
+ *CXXR
+ *CXXR CXXR is not part of the R project, and bugs and other issues should
+ *CXXR not be reported via r-bugs or other R project channels; instead refer
+ *CXXR to the CXXR website.
+ *CXXR */
+
+/** @file AllocationProfiler.cpp
+ *
+ * Implementation of class AllocationProfiler.
+ */
+
+#include "CXXR/AllocationProfiler.hpp"
+
+#include <cstring>
+#include "CXXR/Expression.h"
+#include "CXXR/FunctionContext.hpp"
+#include "CXXR/MemoryBank.hpp"
+#include "CXXR/Symbol.h"
+
+using namespace std;
+using namespace CXXR;
+
+size_t AllocationProfiler::s_interval = 0;
+AllocationProfiler::Aggregate AllocationProfiler::s_aggregate;
+AllocationProfiler::Sample AllocationProfiler::s_latest;
+const void* AllocationProfiler::s_pending = 0;
+size_t AllocationProfiler::s_pending_bytes = 0;
+
+void AllocationProfiler::aggregateLatest()
+{
+    if (s_latest.count == 0)
+	return;
+    vector<Sample>& samples = s_aggregate[s_latest.stack];
+    vector<Sample>::iterator it = samples.begin();
+    while (it != samples.end()
+	   && (it->size_class != s_latest.size_class
+	       || it->type != s_latest.type))
+	++it;
+    if (it == samples.end())
+	samples.push_back(s_latest);
+    else {
+	it->count += s_latest.count;
+	it->bytes += s_latest.bytes;
+	it->weight += s_latest.weight;
+    }
+    s_latest.count = 0;
+}
+
+// Note that this function is called from within
+// MemoryBank::allocate(), so must not itself allocate memory via
+// MemoryBank, e.g. by creating GCNode objects.  Allocations made by
+// the standard library containers are OK.
+void AllocationProfiler::sample(void* block, size_t bytes,
+				unsigned int count)
+{
+    aggregateLatest();
+    // Gather the function names innermost first, then build the
+    // stack string from the far end:
+    static vector<const char*> names;
+    names.clear();
+    size_t length = 0;
+    for (FunctionContext* fctxt = FunctionContext::innermost();
+	 fctxt; fctxt = FunctionContext::innermost(fctxt->nextOut())) {
+	const RObject* fun = (fctxt->call() ? fctxt->call()->car() : 0);
+	const char* name = "<Anonymous>";
+	if (fun && fun->sexptype() == SYMSXP)
+	    name = static_cast<const Symbol*>(fun)->name()->c_str();
+	names.push_back(name);
+	length += strlen(name) + 1;
+    }
+    Sample& smp = s_latest;
+    smp.count = 1;
+    smp.bytes = bytes;
+    smp.size_class = MemoryBank::sizeClass(bytes);
+    smp.type = -1;
+    smp.weight = count*s_interval;
+    smp.stack.clear();
+    smp.stack.reserve(length);
+    for (vector<const char*>::reverse_iterator it = names.rbegin();
+	 it != names.rend(); ++it) {
+	if (!smp.stack.empty())
+	    smp.stack += ';';
+	smp.stack += *it;
+    }
+    s_pending = block;
+    s_pending_bytes = MemoryBank::bytesAllocated();
+}
+
+void AllocationProfiler::setPendingType(SEXPTYPE type)
+{
+    if (s_latest.count != 0
+	&& MemoryBank::bytesAllocated() == s_pending_bytes)
+	s_latest.type = type;
+    s_pending = 0;
+    aggregateLatest();
+}
+
+void AllocationProfiler::start(size_t interval)
+{
+    s_interval = interval;
+    s_pending = 0;
+    if (interval)
+	MemoryBank::setSampler(sample, interval);
+    else MemoryBank::setSampler(0);
+}
+
+void AllocationProfiler::takeSamples(vector<Sample>* dest)
+{
+    aggregateLatest();
+    s_pending = 0;
+    dest->clear();
+    for (Aggregate::const_iterator it = s_aggregate.begin();
+	 it != s_aggregate.end(); ++it) {
+	const vector<Sample>& samples = (*it).second;
+	dest->insert(dest->end(), samples.begin(), samples.end());
+    }
+    s_aggregate.clear();
+}
@@ -22,9 +22,11 @@
 #include "CXXR/ArgList.hpp"
 
 #include <list>
+#include <vector>
 #include "CXXR/DottedArgs.hpp"
 #include "CXXR/Environment.h"
 #include "CXXR/Evaluator.h"
+#include "CXXR/ListVector.h"
 #include "CXXR/Promise.h"
 #include "CXXR/errors.h"
 
@@ -33,6 +35,100 @@ using namespace CXXR;
 
 // Implementation of ArgList::coerceTag() is in coerce.cpp
 
+namespace {
+    // Mark an argument value bound without a Promise as shared, as
+    // forcing a Promise would:
+    RObject* shared(RObject* value)
+    {
+	if (value && NAMED(value) != 2)
+	    SET_NAMED(value, 2);
+	return value;
+    }
+
+    // Is x a constant that evaluates to itself, and so needs no
+    // Promise?
+    bool selfEvaluating(const RObject* x)
+    {
+	if (!x)
+	    return true;
+	switch (x->sexptype()) {
+	case LGLSXP:
+	case INTSXP:
+	case REALSXP:
+	case CPLXSXP:
+	case STRSXP:
+	case RAWSXP:
+	    return true;
+	default:
+	    return false;
+	}
+    }
+
+    // Value of symbol within env if this can be determined without
+    // evaluating anything (in particular without forcing a Promise
+    // or calling an active binding function); otherwise
+    // Symbol::unboundValue().
+    RObject* availableValue(const Symbol* symbol, Environment* env)
+    {
+	RObject* unbound = Symbol::unboundValue();
+	if (symbol == DotsSymbol || symbol->isDotDotSymbol())
+	    return unbound;
+	const Frame::Binding* bdg = env->findBinding(symbol).second;
+	if (!bdg || bdg->isActive())
+	    return unbound;
+	RObject* val = bdg->rawValue();
+	if (val && val->sexptype() == PROMSXP) {
+	    Promise* prom = static_cast<Promise*>(val);
+	    if (prom->environment())  // i.e. not yet forced
+		return unbound;
+	    val = prom->value();
+	}
+	if (val == Symbol::missingArgument()
+	    || (val && val->sexptype() == PROMSXP))
+	    return unbound;
+	return val;
+    }
+
+    bool plainValue(const RObject* value);
+
+    // Are the attributes of value limited to names, dim and
+    // dimnames, with values that are themselves plain?  The
+    // dimnames must be a list of plain values.
+    bool plainAttributes(const RObject* value)
+    {
+	for (const PairList* pl = value->attributes(); pl; pl = pl->tail()) {
+	    const RObject* tag = pl->tag();
+	    const RObject* attr = pl->car();
+	    if (tag == NamesSymbol || tag == DimSymbol) {
+		if (!plainValue(attr))
+		    return false;
+	    } else if (tag == DimNamesSymbol) {
+		if (!attr || attr->sexptype() != VECSXP
+		    || !plainAttributes(attr))
+		    return false;
+		const ListVector* lv = static_cast<const ListVector*>(attr);
+		for (unsigned int i = 0; i < lv->size(); ++i)
+		    if (!plainValue((*lv)[i]))
+			return false;
+	    } else return false;
+	}
+	return true;
+    }
+
+    // May value be bound directly to an argument of a Closure for
+    // which Closure::strict() is true?  This requires that
+    // primitives applied to the value cannot dispatch to methods or
+    // run active binding functions, so the value must be an atomic
+    // vector that is not an object.  Moreover, since attr() could
+    // extract its attributes, these must be plain too.
+    bool plainValue(const RObject* value)
+    {
+	if (!value || value == Symbol::missingArgument())
+	    return true;
+	return selfEvaluating(value) && plainAttributes(value);
+    }
+}
+
 void ArgList::evaluate(Environment* env, bool allow_missing)
 {
     if (m_status == EVALUATED)
@@ -159,6 +255,13 @@ pair<bool, RObject*> ArgList::firstArg(Environment* env)
 		if (val->sexptype() != DOTSXP)
 		    Rf_error(_("'...' used in an incorrect context"));
 		RObject* dots1 = static_cast<DottedArgs*>(val)->car();
+		// Self-evaluating constants may be bound without a
+		// Promise (see wrapInPromises()):
+		if (selfEvaluating(dots1)) {
+		    m_first_arg = dots1;
+		    m_first_arg_env = env;
+		    return make_pair(true, m_first_arg);
+		}
 		if (dots1->sexptype() != PROMSXP)
 		    Rf_error(_("value in '...' is not a promise"));
 		m_first_arg = dots1->evaluate(env);
@@ -188,7 +291,7 @@ void ArgList::stripTags()
     }
 }
 	    
-void ArgList::wrapInPromises(Environment* env)
+void ArgList::wrapInPromises(Environment* env, Elision elision)
 {
     if (m_status == PROMISED)
 	Rf_error("Internal error:"
@@ -198,12 +301,49 @@ void ArgList::wrapInPromises(Environment* env)
     else if (m_first_arg_env && env != m_first_arg_env)
 	Rf_error("Internal error: first arg of ArgList"
 		 " previously evaluated in different environment");
+    // If looked-up values are to replace Symbol arguments, first
+    // check that every argument is eligible:
+    vector<RObject*> lookups;
+    if (elision == ELIDE_LOOKUPS && m_status == RAW) {
+	bool eligible = true;
+	for (const PairList* inp = list(); eligible && inp; inp = inp->tail()) {
+	    RObject* rawvalue = inp->car();
+	    if (rawvalue == DotsSymbol)
+		eligible = false;
+	    else if (inp == list() && m_first_arg_env) {
+		eligible = plainValue(m_first_arg);
+		lookups.push_back(m_first_arg);
+	    } else if (rawvalue == Symbol::missingArgument()
+		     || selfEvaluating(rawvalue)) {
+		eligible = plainValue(rawvalue);
+		lookups.push_back(rawvalue);
+	    } else if (rawvalue->sexptype() == SYMSXP) {
+		RObject* val
+		    = availableValue(static_cast<Symbol*>(rawvalue), env);
+		eligible = (val != Symbol::unboundValue() && plainValue(val));
+		lookups.push_back(val);
+	    } else eligible = false;
+	}
+	if (!eligible)
+	    lookups.clear();
+    }
     GCStackRoot<PairList> oldargs(m_list->tail());
     m_list->setTail(0);
     PairList* lastout = m_list;
+    vector<RObject*>::const_iterator lookup = lookups.begin();
     for (const PairList* inp = oldargs; inp; inp = inp->tail()) {
 	RObject* rawvalue = inp->car();
-	if (rawvalue == DotsSymbol) {
+	if (!lookups.empty()) {
+	    // Every argument has a known value:
+	    const Symbol* tag = tag2Symbol(inp->tag());
+	    RObject* value = *lookup++;
+	    if (value != Symbol::missingArgument())
+		shared(value);
+	    lastout->setTail(PairList::cons(value, 0, tag));
+	    lastout = lastout->tail();
+	    m_first_arg = 0;
+	    m_first_arg_env = 0;
+	} else if (rawvalue == DotsSymbol) {
 	    pair<Environment*, Frame::Binding*> pr
 		= env->findBinding(DotsSymbol);
 	    if (pr.first) {
@@ -211,17 +351,19 @@ void ArgList::wrapInPromises(Environment* env)
 		if (!dval || dval->sexptype() == DOTSXP) {
 		    ConsCell* dotlist = static_cast<ConsCell*>(dval);
 		    while (dotlist) {
-			Promise* prom;
-			if (!m_first_arg_env)
-			    prom = new Promise(dotlist->car(), env);
-			else {
-			    prom = new Promise(m_first_arg, 0);
+			RObject* value;
+			if (!m_first_arg_env) {
+			    RObject* dotcar = dotlist->car();
+			    if (elision != WRAP_ALL && selfEvaluating(dotcar))
+				value = shared(dotcar);
+			    else value = CXXR_NEW(Promise(dotcar, env));
+			} else {
+			    value = CXXR_NEW(Promise(m_first_arg, 0));
 			    m_first_arg = 0;
 			    m_first_arg_env = 0;
 			}
-			prom->expose();
 			const Symbol* tag = tag2Symbol(dotlist->tag());
-			lastout->setTail(PairList::cons(prom, 0, tag));
+			lastout->setTail(PairList::cons(value, 0, tag));
 			lastout = lastout->tail();
 			dotlist = dotlist->tail();
 		    }
@@ -232,11 +374,16 @@ void ArgList::wrapInPromises(Environment* env)
 	    const Symbol* tag = tag2Symbol(inp->tag());
 	    RObject* value = Symbol::missingArgument();
 	    if (m_first_arg_env) {
-		value = CXXR_NEW(Promise(m_first_arg, 0));
+		if (elision != WRAP_ALL && selfEvaluating(m_first_arg))
+		    value = shared(m_first_arg);
+		else value = CXXR_NEW(Promise(m_first_arg, 0));
 		m_first_arg = 0;
 		m_first_arg_env = 0;
-	    } else if (rawvalue != Symbol::missingArgument())
-		value = CXXR_NEW(Promise(rawvalue, env));
+	    } else if (rawvalue != Symbol::missingArgument()) {
+		if (elision != WRAP_ALL && selfEvaluating(rawvalue))
+		    value = shared(rawvalue);
+		else value = CXXR_NEW(Promise(rawvalue, env));
+	    }
 	    lastout->setTail(PairList::cons(value, 0, tag));
 	    lastout = lastout->tail();
 	}
@@ -36,7 +36,7 @@ using namespace CXXR;
 bool ArgMatcher::s_warn_on_partial_match = false;
 
 ArgMatcher::ArgMatcher(const PairList* formals)
-    : m_formals(formals), m_has_dots(false)
+    : m_formals(formals), m_has_dots(false), m_next_plan(0)
 {
     for (const PairList* f = formals; f; f = f->tail()) {
 	const Symbol* sym = dynamic_cast<const Symbol*>(f->tag());
@@ -65,6 +65,7 @@ void ArgMatcher::detachReferents()
     m_formals.detach();
     m_formal_data.clear();
     m_formal_index.clear();
+    m_plans.clear();
 }
 
 void ArgMatcher::handleDots(Frame* frame, SuppliedList* supplied_list)
@@ -129,7 +130,11 @@ void ArgMatcher::makeBinding(Environment* target_env, const FormalData& fdata,
     
 void ArgMatcher::match(Environment* target_env, const ArgList* supplied) const
 {
+    if (matchByPlan(target_env, supplied))
+	return;
     Frame* frame = target_env->frame();
+    MatchPlan plan;
+    plan.partial = false;
     vector<MatchStatus, Allocator<MatchStatus> >
 	formals_status(m_formal_data.size(), UNMATCHED);
     SuppliedList supplied_list;
@@ -150,6 +155,7 @@ void ArgMatcher::match(Environment* target_env, const ArgList* supplied) const
 		const FormalData& fdata = m_formal_data[findex];
 		formals_status[findex] = EXACT_TAG;
 		makeBinding(target_env, fdata, value);
+		plan.bindings.push_back(make_pair(findex, int(sindex - 1)));
 	    } else {
 		// No exact tag match, so place supplied arg on list:
 		SuppliedData supplied_data
@@ -200,6 +206,9 @@ void ArgMatcher::match(Environment* target_env, const ArgList* supplied) const
 		const FormalData& fdata = m_formal_data[findex];
 		formals_status[findex] = PARTIAL_TAG;
 		makeBinding(target_env, fdata, supplied_data.value);
+		plan.bindings.push_back(make_pair(findex,
+						  int(supplied_data.index - 1)));
+		plan.partial = true;
 		supplied_list.erase(slit);
 	    }
 	    slit = next;
@@ -213,6 +222,7 @@ void ArgMatcher::match(Environment* target_env, const ArgList* supplied) const
 	    if (formals_status[findex] == UNMATCHED) {
 		const FormalData& fdata = m_formal_data[findex];
 		RObject* value = Symbol::missingArgument();
+		int sindex = -1;
 		// Skip supplied arguments with tags:
 		while (slit != supplied_list.end() && (*slit).tag)
 		    ++slit;
@@ -221,19 +231,76 @@ void ArgMatcher::match(Environment* target_env, const ArgList* supplied) const
 		    // Handle positional match:
 		    const SuppliedData& supplied_data = *slit;
 		    value = supplied_data.value;
+		    sindex = int(supplied_data.index - 1);
 		    formals_status[findex] = POSITIONAL;
 		    supplied_list.erase(slit++);
 		}
 		makeBinding(target_env, fdata, value);
+		plan.bindings.push_back(make_pair(findex, sindex));
 	    }
 	}
     }
     // Any remaining supplied args are either rolled into ... or
     // there's an error:
-    if (m_has_dots)
+    if (m_has_dots) {
+	for (SuppliedList::const_iterator it = supplied_list.begin();
+	     it != supplied_list.end(); ++it)
+	    plan.dots.push_back((*it).index - 1);
 	handleDots(frame, &supplied_list);
+    }
     else if (!supplied_list.empty())
 	unusedArgsError(supplied_list);
+    recordPlan(supplied, &plan);
+}
+
+bool ArgMatcher::matchByPlan(Environment* target_env,
+			     const ArgList* supplied) const
+{
+    // Look for a plan whose tags match those supplied:
+    const MatchPlan* plan = 0;
+    for (vector<MatchPlan>::const_iterator it = m_plans.begin();
+	 !plan && it != m_plans.end(); ++it) {
+	const vector<const Symbol*>& tags = (*it).tags;
+	vector<const Symbol*>::const_iterator tit = tags.begin();
+	const PairList* s = supplied->list();
+	while (s && tit != tags.end() && s->tag() == *tit) {
+	    s = s->tail();
+	    ++tit;
+	}
+	if (!s && tit == tags.end())
+	    plan = &(*it);
+    }
+    // Partial matches must go through match() if they are to be
+    // warned about:
+    if (!plan || (plan->partial && s_warn_on_partial_match))
+	return false;
+    // Index the supplied values:
+    vector<RObject*, Allocator<RObject*> > values;
+    values.reserve(plan->tags.size());
+    for (const PairList* s = supplied->list(); s; s = s->tail())
+	values.push_back(s->car());
+    for (vector<pair<unsigned int, int> >::const_iterator it
+	     = plan->bindings.begin(); it != plan->bindings.end(); ++it) {
+	int sindex = (*it).second;
+	makeBinding(target_env, m_formal_data[(*it).first],
+		    (sindex < 0 ? Symbol::missingArgument() : values[sindex]));
+    }
+    if (m_has_dots) {
+	Frame::Binding* bdg = target_env->frame()->obtainBinding(DotsSymbol);
+	const vector<unsigned int>& dots = plan->dots;
+	if (!dots.empty()) {
+	    unsigned int first = dots.front();
+	    DottedArgs* dotted_args
+		= expose(new DottedArgs(values[first], 0, plan->tags[first]));
+	    bdg->setValue(dotted_args, Frame::Binding::EXPLICIT);
+	    GCStackRoot<PairList> tail;
+	    for (vector<unsigned int>::const_reverse_iterator rit
+		     = dots.rbegin(); rit + 1 != dots.rend(); ++rit)
+		tail = PairList::cons(values[*rit], tail, plan->tags[*rit]);
+	    dotted_args->setTail(tail);
+	}
+    }
+    return true;
 }
 
 void ArgMatcher::propagateFormalBindings(const Environment* fromenv,
@@ -263,6 +330,26 @@ void ArgMatcher::propagateFormalBindings(const Environment* fromenv,
     }
 }
 	    
+void ArgMatcher::recordPlan(const ArgList* supplied, MatchPlan* plan) const
+{
+    for (const PairList* s = supplied->list(); s; s = s->tail())
+	plan->tags.push_back(static_cast<const Symbol*>(s->tag()));
+    size_t index;
+    if (m_plans.size() < s_max_plans) {
+	index = m_plans.size();
+	m_plans.push_back(MatchPlan());
+    } else {
+	index = m_next_plan;
+	m_next_plan = (m_next_plan + 1)%s_max_plans;
+    }
+    // Swap rather than copy the vectors within the plan:
+    MatchPlan& slot = m_plans[index];
+    slot.tags.swap(plan->tags);
+    slot.bindings.swap(plan->bindings);
+    slot.dots.swap(plan->dots);
+    slot.partial = plan->partial;
+}
+
 void ArgMatcher::stripFormals(Frame* input_frame) const
 {
     const PairList* fcell = m_formals;
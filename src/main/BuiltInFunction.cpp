@@ -38,13 +38,23 @@
  * C interface.
  */
 
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
 #include "CXXR/BuiltInFunction.h"
 
+#include <algorithm>
 #include <cstdarg>
+#include <ctime>
+#ifndef HAVE_CLOCK_GETTIME
+#include <sys/time.h>
+#endif
 #include "Internal.h"
 #include "CXXR/ArgList.hpp"
 #include "CXXR/DotInternal.h"
 #include "CXXR/FunctionContext.hpp"
+#include "CXXR/MemoryBank.hpp"
 #include "CXXR/PlainContext.hpp"
 #include "CXXR/ProtectStack.h"
 #include "CXXR/GCStackRoot.hpp"
@@ -65,6 +75,73 @@ namespace CXXR {
 
 BuiltInFunction::TableEntry* BuiltInFunction::s_function_table = 0;
 BuiltInFunction::map* BuiltInFunction::s_cache = 0;
+bool BuiltInFunction::s_collect_statistics = false;
+std::vector<BuiltInFunction::Statistics>*
+BuiltInFunction::s_statistics = 0;
+BuiltInFunction::StatisticsScope* BuiltInFunction::s_innermost_scope = 0;
+
+namespace {
+    // Elapsed time in seconds, measured from an arbitrary origin:
+    double seconds()
+    {
+#ifdef HAVE_CLOCK_GETTIME
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return double(ts.tv_sec) + 1.0e-9*double(ts.tv_nsec);
+#else
+	timeval tv;
+	gettimeofday(&tv, 0);
+	return double(tv.tv_sec) + 1.0e-6*double(tv.tv_usec);
+#endif
+    }
+}
+
+// ***** Class BuiltInFunction::Statistics *****
+
+BuiltInFunction::Statistics::Statistics()
+    : calls(0), time(0.0), self_time(0.0), bytes(0.0)
+{
+    for (unsigned int i = 0; i < s_num_latency_bins; ++i)
+	latency[i] = 0;
+}
+
+// ***** Class BuiltInFunction::StatisticsScope *****
+
+void BuiltInFunction::StatisticsScope::start(const BuiltInFunction* function)
+{
+    m_function = function;
+    m_enclosing = s_innermost_scope;
+    s_innermost_scope = this;
+    m_nested_time = 0.0;
+    m_nested_bytes = 0.0;
+    m_start_bytes = MemoryBank::bytesAllocated();
+    m_start_time = seconds();
+}
+
+void BuiltInFunction::StatisticsScope::finish()
+{
+    double elapsed = seconds() - m_start_time;
+    double bytes = double(MemoryBank::bytesAllocated())
+	- double(m_start_bytes);
+    s_innermost_scope = m_enclosing;
+    if (m_enclosing) {
+	m_enclosing->m_nested_time += elapsed;
+	m_enclosing->m_nested_bytes += bytes;
+    }
+    Statistics& stats = (*s_statistics)[m_function->offset()];
+    ++stats.calls;
+    stats.time += elapsed;
+    stats.self_time += elapsed - m_nested_time;
+    stats.bytes += bytes - m_nested_bytes;
+    unsigned int bin = 0;
+    for (double usecs = 1.0e6*elapsed;
+	 usecs >= 1.0 && bin < s_num_latency_bins - 1; usecs /= 2.0)
+	++bin;
+    ++stats.latency[bin];
+}
+
+// ***** Class BuiltInFunction *****
+
 
 // BuiltInFunction::apply() creates a FunctionContext only if
 // m_transparent is false.  This affects the location at which
@@ -125,6 +202,7 @@ RObject* BuiltInFunction::apply(ArgList* arglist, Environment* env,
 #endif
     Evaluator::enableResultPrinting(m_result_printing_mode != FORCE_OFF);
     GCStackRoot<> ans;
+    StatisticsScope stats_scope(this);
     if (m_transparent) {
 	PlainContext cntxt;
 	if (arglist->status() != ArgList::EVALUATED && sexptype() == BUILTINSXP)
@@ -170,6 +248,31 @@ void BuiltInFunction::cleanup()
     s_cache = 0;
 }
 
+void BuiltInFunction::enableStatistics(bool on)
+{
+    if (on && !s_statistics) {
+	unsigned int n = 0;
+	while (s_function_table[n].name)
+	    ++n;
+	s_statistics = new std::vector<Statistics>(n);
+    }
+    s_collect_statistics = on;
+}
+
+void BuiltInFunction::
+getStatistics(std::vector<std::pair<std::string, Statistics> >* dest)
+{
+    dest->clear();
+    if (!s_statistics)
+	return;
+    for (unsigned int i = 0; i < s_statistics->size(); ++i) {
+	const Statistics& stats = (*s_statistics)[i];
+	if (stats.calls > 0)
+	    dest->push_back(std::make_pair(std::string(s_function_table[i].name),
+					   stats));
+    }
+}
+
 int BuiltInFunction::indexInTable(const char* name)
 {
     for (int i = 0; s_function_table[i].name; ++i)
@@ -203,6 +306,12 @@ BuiltInFunction* BuiltInFunction::obtain(const std::string& name)
     return (*it).second;
 }
 
+void BuiltInFunction::resetStatistics()
+{
+    if (s_statistics)
+	std::fill(s_statistics->begin(), s_statistics->end(), Statistics());
+}
+
 const char* BuiltInFunction::typeName() const
 {
     return sexptype() == SPECIALSXP ? "special" : "builtin";
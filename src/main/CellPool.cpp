@@ -123,34 +123,98 @@ void CellPool::checkCell(const void* p) const
     }
 }
 
-void CellPool::defragment()
+size_t CellPool::defragment()
 {
-    vector<Cell*> vf(cellsFree());
-    // Assemble vector of pointers to free cells:
+    vector<void*>& superblocks = m_admin->m_superblocks;
+    const size_t sbsize = m_admin->m_superblocksize;
+    const size_t num_superblocks = superblocks.size();
+    vector<Cell*> vf;
+    vf.reserve(cellsFree());
+    for (Cell* c = m_free_cells; c; c = c->m_next)
+	vf.push_back(c);
+    // Sort free cells and superblocks by increasing address:
+    sort(vf.begin(), vf.end());
+    sort(superblocks.begin(), superblocks.end());
+    // Note the range of vf occupied by the free cells of each
+    // superblock.  Cells on the free list that do not lie within any
+    // of this pool's superblocks (as can happen if they have migrated
+    // from another pool via a MemoryBank::ThreadCache) are put aside
+    // in foreign.
+    vector<size_t> first(num_superblocks, 0), nfree(num_superblocks, 0);
+    vector<Cell*> foreign;
     {
-	Cell* c = m_free_cells;
-	for (vector<Cell*>::iterator it = vf.begin(); it != vf.end(); ++it) {
-	    *it = c;
-	    c = c->m_next;
+	size_t sb = 0;
+	for (size_t i = 0; i < vf.size(); ++i) {
+	    const char* pc = reinterpret_cast<const char*>(vf[i]);
+	    while (sb < num_superblocks
+		   && pc >= static_cast<const char*>(superblocks[sb]) + sbsize)
+		++sb;
+	    if (sb < num_superblocks
+		&& pc >= static_cast<const char*>(superblocks[sb])) {
+		if (nfree[sb]++ == 0)
+		    first[sb] = i;
+	    }
+	    else foreign.push_back(vf[i]);
 	}
     }
-    // Sort by increasing address:
-    sort(vf.begin(), vf.end());
-    // Restring the pearls:
+    // Release wholly free superblocks, and order the remainder so
+    // that the fullest come first:
+    size_t released = 0;
+    vector<pair<size_t, size_t> > order;  // (nfree, index)
+    {
+	vector<void*> kept;
+	kept.reserve(num_superblocks);
+	for (size_t sb = 0; sb < num_superblocks; ++sb) {
+	    if (nfree[sb] == m_admin->m_cells_per_superblock) {
+#if _POSIX_C_SOURCE >= 200112L || _XOPEN_SOURCE >= 600
+		free(superblocks[sb]);
+#else
+		::operator delete(superblocks[sb]);
+#endif
+		++released;
+	    }
+	    else {
+		if (nfree[sb] > 0)
+		    order.push_back(make_pair(nfree[sb], first[sb]));
+		kept.push_back(superblocks[sb]);
+	    }
+	}
+	superblocks.swap(kept);
+    }
+    sort(order.begin(), order.end());
+    // Restring the pearls, starting at the tail of the list:
     {
 	Cell* next = 0;
-	vector<Cell*>::reverse_iterator rit = vf.rbegin();
 #ifdef CELLFIFO
-	m_last_free_cell = (rit == vf.rend() ? 0 : *rit);
+	m_last_free_cell = 0;
 #endif
-	for ( ; rit != vf.rend(); ++rit) {
+	for (vector<Cell*>::reverse_iterator rit = foreign.rbegin();
+	     rit != foreign.rend(); ++rit) {
 	    Cell* c = *rit;
+#ifdef CELLFIFO
+	    if (!m_last_free_cell)
+		m_last_free_cell = c;
+#endif
 	    c->m_next = next;
 	    next = c;
 	}
+	for (vector<pair<size_t, size_t> >::reverse_iterator rit
+		 = order.rbegin(); rit != order.rend(); ++rit) {
+	    // Cells within a superblock are strung in address order:
+	    for (size_t i = rit->second + rit->first; i > rit->second; --i) {
+		Cell* c = vf[i - 1];
+#ifdef CELLFIFO
+		if (!m_last_free_cell)
+		    m_last_free_cell = c;
+#endif
+		c->m_next = next;
+		next = c;
+	    }
+	}
 	m_free_cells = next;
     }
     // check();
+    return released;
 }
 
 void CellPool::initialize(size_t dbls_per_cell, size_t cells_per_superblock)
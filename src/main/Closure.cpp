@@ -40,14 +40,16 @@
 
 #include "CXXR/Closure.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include "CXXR/ArgList.hpp"
 #include "CXXR/ArgMatcher.hpp"
 #include "CXXR/BailoutContext.hpp"
+#include "CXXR/BuiltInFunction.h"
 #include "CXXR/ClosureContext.hpp"
 #include "CXXR/Expression.h"
 #include "CXXR/GCStackRoot.hpp"
-#include "CXXR/ListFrame.hpp"
 #include "CXXR/ReturnBailout.hpp"
 #include "CXXR/ReturnException.hpp"
 #include "CXXR/errors.h"
@@ -71,7 +73,8 @@ namespace CXXR {
 }
 
 Closure::Closure(const PairList* formal_args, RObject* body, Environment* env)
-    : FunctionBase(CLOSXP), m_debug(false),
+    : FunctionBase(CLOSXP), m_debug(false), m_strictness_known(false),
+      m_strict(false), m_strictness_epoch(0),
       m_matcher(expose(new ArgMatcher(formal_args))),
       m_body(body), m_environment(env)
 {
@@ -80,7 +83,9 @@ Closure::Closure(const PairList* formal_args, RObject* body, Environment* env)
 RObject* Closure::apply(ArgList* arglist, Environment* env,
 			const Expression* call) const
 {
-    arglist->wrapInPromises(env);
+    arglist->wrapInPromises(env, (!m_debug && strict()
+				  ? ArgList::ELIDE_LOOKUPS
+				  : ArgList::ELIDE_CONSTANTS));
     return invoke(env, arglist, call);
 }
 
@@ -97,6 +102,8 @@ void Closure::detachReferents()
     m_matcher.detach();
     m_body.detach();
     m_environment.detach();
+    m_frame_layout.detach();
+    m_spare_envs.clear();
     RObject::detachReferents();
 }
 
@@ -136,9 +143,15 @@ RObject* Closure::invoke(Environment* env, const ArgList* arglist,
     if (arglist->status() != ArgList::PROMISED)
 	Rf_error("Internal error: unwrapped arguments to Closure::invoke");
 #endif
-    GCStackRoot<Frame> newframe(CXXR_NEW(ListFrame));
-    GCStackRoot<Environment>
-	newenv(CXXR_NEW(Environment(environment(), newframe)));
+    GCStackRoot<Environment> newenv;
+    if (!m_spare_envs.empty()) {
+	newenv = m_spare_envs.back();
+	m_spare_envs.pop_back();
+    } else {
+	GCStackRoot<Frame> newframe(CXXR_NEW(SlotFrame(frameLayout())));
+	newenv = CXXR_NEW(Environment(environment(), newframe));
+    }
+    Frame* newframe = newenv->frame();
     // Perform argument matching:
     {
         ClosureContext cntxt(const_cast<Expression*>(call), env, this,
@@ -174,9 +187,365 @@ RObject* Closure::invoke(Environment* env, const ArgList* arglist,
 			     syspar, this, newenv, arglist->list());
 	ans = execute(newenv);
     }
+    // Any on.exit code has now been run.  Release the stack root to
+    // the working environment, so that its reference count reflects
+    // only references from the heap; if there are none, and it is
+    // not itself the result, it can be kept for reuse:
+    Environment* oldenv = newenv;
+    newenv = 0;
+    if (m_spare_envs.size() < s_max_spare_envs
+	&& oldenv != ans && oldenv->recycle())
+	m_spare_envs.push_back(GCEdge<Environment>(oldenv));
     return ans;
 }
 
+namespace {
+    // Name of the primitive function bound by bdg, or a null
+    // pointer if bdg is null or active, or is bound to anything
+    // other than a primitive.
+    const char* primitiveName(const Frame::Binding* bdg)
+    {
+	if (!bdg || bdg->isActive())
+	    return 0;
+	const RObject* fun = bdg->rawValue();
+	if (!fun
+	    || (fun->sexptype() != BUILTINSXP
+		&& fun->sexptype() != SPECIALSXP))
+	    return 0;
+	return static_cast<const BuiltInFunction*>(fun)->name();
+    }
+
+    // Class used to determine whether evaluating the body and the
+    // default arguments of a Closure can run nothing other than a
+    // restricted set of primitive functions, and so cannot give
+    // other code the opportunity to examine the Closure's working
+    // environment.  Free variables are not allowed, since their
+    // values might be objects, whose methods could be dispatched to,
+    // or environments with active bindings; nor are local variables
+    // that may be referenced before they are assigned to, since
+    // these too would be looked up in enclosing environments.  The
+    // primitives called are recorded, so that the analysis can be
+    // invalidated if they are rebound.
+    class CalleeScan {
+    public:
+	typedef vector<Closure::Callee> CalleeVector;
+
+	CalleeScan(const Closure* closure, CalleeVector* callees)
+	    : m_closure(closure), m_callees(callees)
+	{}
+
+	// Returns true if the Closure passes muster:
+	bool run();
+    private:
+	typedef vector<const Symbol*> SymbolVector;
+
+	const Closure* m_closure;
+	CalleeVector* m_callees;
+
+	// Is symbol, used as a function name, bound to a permitted
+	// primitive?  If so, the binding is recorded in *m_callees.
+	bool callable(const Symbol* symbol);
+
+	// Does evaluating expression satisfy the restrictions?
+	// *assigned lists the Symbols certainly bound locally
+	// before expression is evaluated, and is augmented with
+	// those that will certainly be bound locally afterwards.
+	bool scan(const RObject* expression, SymbolVector* assigned);
+
+	// As scan(), but any local assignments within expression
+	// are not taken into account thereafter, e.g. because
+	// expression may not be evaluated:
+	bool scanConditional(const RObject* expression,
+			     const SymbolVector& assigned)
+	{
+	    SymbolVector scratch(assigned);
+	    return scan(expression, &scratch);
+	}
+    };
+
+    bool CalleeScan::run()
+    {
+	SymbolVector formals;
+	for (const PairList* pl = m_closure->matcher()->formalArgs();
+	     pl; pl = pl->tail())
+	    formals.push_back(static_cast<const Symbol*>(pl->tag()));
+	for (const PairList* pl = m_closure->matcher()->formalArgs();
+	     pl; pl = pl->tail())
+	    if (!scanConditional(pl->car(), formals))
+		return false;
+	return scanConditional(m_closure->body(), formals);
+    }
+
+    bool CalleeScan::callable(const Symbol* symbol)
+    {
+	// Primitives which examine Promises or the context stack,
+	// which may run arbitrary code, or which can yield objects
+	// (to which methods may be dispatched) or environments:
+	static const char* excluded[]
+	    = {".C", ".Call", ".Call.graphics", ".External",
+	       ".External.graphics", ".External2", ".Fortran",
+	       ".Internal", ".Primitive", "<<-", "@<-", "UseMethod",
+	       "as.environment", "attr<-", "attributes<-", "baseenv",
+	       "browser", "class<-", "emptyenv", "environment<-",
+	       "function", "globalenv", "lazyLoadDBfetch", "missing",
+	       "oldClass<-", "pos.to.env", "standardGeneric",
+	       "substitute", 0};
+	// A local binding could be anything:
+	if (m_closure->frameLayout()->slot(symbol) >= 0)
+	    return false;
+	Environment* env = m_closure->environment();
+	pair<Environment*, Frame::Binding*> pr = env->findBinding(symbol);
+	const char* name = primitiveName(pr.second);
+	if (!name)
+	    return false;
+	for (const char** p = excluded; *p; ++p)
+	    if (strcmp(name, *p) == 0)
+		return false;
+	if (!env->watchLookup(symbol, pr.first))
+	    return false;
+	Closure::Callee callee = {symbol, pr.second, name};
+	m_callees->push_back(callee);
+	return true;
+    }
+
+    bool CalleeScan::scan(const RObject* expression, SymbolVector* assigned)
+    {
+	static const Symbol* assign_sym = Symbol::obtain("<-");
+	static const Symbol* brace_sym = Symbol::obtain("{");
+	static const Symbol* dollar_sym = Symbol::obtain("$");
+	static const Symbol* equals_sym = Symbol::obtain("=");
+	static const Symbol* for_sym = Symbol::obtain("for");
+	static const Symbol* quote_sym = Symbol::obtain("quote");
+	if (!expression)
+	    return true;
+	switch (expression->sexptype()) {
+	case SYMSXP:
+	    return (expression == Symbol::missingArgument()
+		    || find(assigned->begin(), assigned->end(), expression)
+		    != assigned->end());
+	case LGLSXP:
+	case INTSXP:
+	case REALSXP:
+	case CPLXSXP:
+	case STRSXP:
+	case RAWSXP:
+	    return !expression->hasAttributes();
+	case LANGSXP:
+	    break;
+	default:
+	    return false;
+	}
+	const Expression* call = static_cast<const Expression*>(expression);
+	const Symbol* fun = dynamic_cast<const Symbol*>(call->car());
+	const PairList* args = call->tail();
+	if (!fun || !callable(fun))
+	    return false;
+	if (fun == quote_sym)
+	    return true;
+	if (fun == brace_sym) {
+	    // Arguments are evaluated in sequence:
+	    for (const PairList* pl = args; pl; pl = pl->tail())
+		if (!scan(pl->car(), assigned))
+		    return false;
+	    return true;
+	}
+	if (fun == assign_sym || fun == equals_sym) {
+	    if (!args || !args->tail() || args->tail()->tail())
+		return false;
+	    const RObject* target = args->car();
+	    if (!target || target->sexptype() != SYMSXP
+		|| target == DotsSymbol
+		|| !scan(args->tail()->car(), assigned))
+		return false;
+	    assigned->push_back(static_cast<const Symbol*>(target));
+	    return true;
+	}
+	if (fun == for_sym) {
+	    if (!args || !args->tail() || !args->tail()->tail())
+		return false;
+	    const RObject* var = args->car();
+	    if (!var || var->sexptype() != SYMSXP
+		|| !scan(args->tail()->car(), assigned))
+		return false;
+	    SymbolVector inloop(*assigned);
+	    inloop.push_back(static_cast<const Symbol*>(var));
+	    return scan(args->tail()->tail()->car(), &inloop);
+	}
+	if (fun == dollar_sym) {
+	    // The second argument is a name, not evaluated:
+	    return (args && args->tail()
+		    && scanConditional(args->car(), *assigned));
+	}
+	// Whether and in what order the arguments of other
+	// primitives (e.g. 'if', '&&' and 'switch') are evaluated is
+	// not analysed:
+	for (const PairList* pl = args; pl; pl = pl->tail())
+	    if (!scanConditional(pl->car(), *assigned))
+		return false;
+	return true;
+    }
+
+    // Class used to determine whether each formal argument of a
+    // Closure is forced (or overwritten) before anything is
+    // evaluated that might run arbitrary code.  The scan proceeds
+    // through the body in order of evaluation, and stops at the
+    // first point beyond which the order of evaluation cannot be
+    // predicted, e.g. at a call to a Closure.
+    class ForcingScan {
+    public:
+	ForcingScan(const Closure* closure)
+	    : m_closure(closure), m_blocked(false)
+	{
+	    for (const PairList* pl = closure->matcher()->formalArgs();
+		 pl; pl = pl->tail())
+		m_pending.push_back(pl);
+	}
+
+	// Returns true if every formal argument is accounted for:
+	bool run()
+	{
+	    scan(m_closure->body());
+	    return m_pending.empty();
+	}
+    private:
+	const Closure* m_closure;
+	vector<const PairList*> m_pending;  // Elements of the formals
+			// list not yet forced or overwritten.
+	bool m_blocked;  // Set once the scan can go no further.
+
+	// Remove symbol from m_pending if present, returning the
+	// removed element or a null pointer:
+	const PairList* account(const Symbol* symbol);
+
+	// Is symbol bound to a BUILTINSXP function, which therefore
+	// evaluates its arguments in order before doing anything
+	// else?
+	bool isBuiltIn(const Symbol* symbol) const;
+
+	void scan(const RObject* expression);
+    };
+
+    const PairList* ForcingScan::account(const Symbol* symbol)
+    {
+	for (vector<const PairList*>::iterator it = m_pending.begin();
+	     it != m_pending.end(); ++it) {
+	    const PairList* formal = *it;
+	    if (formal->tag() == symbol) {
+		m_pending.erase(it);
+		return formal;
+	    }
+	}
+	return 0;
+    }
+
+    bool ForcingScan::isBuiltIn(const Symbol* symbol) const
+    {
+	// A local binding could be anything:
+	if (m_closure->frameLayout()->slot(symbol) >= 0)
+	    return false;
+	const Frame::Binding* bdg
+	    = m_closure->environment()->findBinding(symbol).second;
+	if (!bdg || bdg->isActive())
+	    return false;
+	const RObject* fun = bdg->rawValue();
+	return fun && fun->sexptype() == BUILTINSXP;
+    }
+
+    void ForcingScan::scan(const RObject* expression)
+    {
+	static const Symbol* assign_sym = Symbol::obtain("<-");
+	static const Symbol* brace_sym = Symbol::obtain("{");
+	static const Symbol* equals_sym = Symbol::obtain("=");
+	static const Symbol* function_sym = Symbol::obtain("function");
+	static const Symbol* paren_sym = Symbol::obtain("(");
+	static const Symbol* quote_sym = Symbol::obtain("quote");
+	if (m_blocked || !expression)
+	    return;
+	if (expression->sexptype() == SYMSXP) {
+	    const PairList* formal
+		= account(static_cast<const Symbol*>(expression));
+	    // Evaluating a default value that is a call might run
+	    // arbitrary code:
+	    if (formal && formal->car() && formal->car()->sexptype() == LANGSXP)
+		m_blocked = true;
+	    return;
+	}
+	if (expression->sexptype() != LANGSXP)
+	    return;
+	const Expression* call = static_cast<const Expression*>(expression);
+	const Symbol* fun = dynamic_cast<const Symbol*>(call->car());
+	const PairList* args = call->tail();
+	if (fun && m_closure->frameLayout()->slot(fun) < 0) {
+	    if (fun == function_sym || fun == quote_sym)
+		return;
+	    if (fun == brace_sym || fun == paren_sym) {
+		for (const PairList* pl = args; pl; pl = pl->tail())
+		    scan(pl->car());
+		return;
+	    }
+	    if ((fun == assign_sym || fun == equals_sym)
+		&& args && args->tail()
+		&& args->car() && args->car()->sexptype() == SYMSXP) {
+		scan(args->tail()->car());
+		// A formal argument that is overwritten before it is
+		// used is never forced:
+		if (!m_blocked)
+		    account(static_cast<const Symbol*>(args->car()));
+		return;
+	    }
+	    if (isBuiltIn(fun)) {
+		for (const PairList* pl = args; pl; pl = pl->tail())
+		    scan(pl->car());
+		// The function may dispatch to arbitrary code once the
+		// arguments are evaluated:
+		m_blocked = true;
+		return;
+	    }
+	}
+	m_blocked = true;
+    }
+}
+
+bool Closure::calleesUnchanged() const
+{
+    bool current = (m_strictness_epoch == Environment::lookupEpoch());
+    for (vector<Callee>::iterator it = m_callees.begin();
+	 it != m_callees.end(); ++it) {
+	Callee& callee = *it;
+	if (!current) {
+	    // The recorded Binding may no longer be the first one
+	    // found, or may no longer exist:
+	    pair<Environment*, Frame::Binding*> pr
+		= environment()->findBinding(callee.m_symbol);
+	    if (!pr.first
+		|| !environment()->watchLookup(callee.m_symbol, pr.first))
+		return false;
+	    callee.m_binding = pr.second;
+	}
+	if (primitiveName(callee.m_binding) != callee.m_name)
+	    return false;
+    }
+    m_strictness_epoch = Environment::lookupEpoch();
+    return true;
+}
+
+bool Closure::strict() const
+{
+    if (m_strictness_known && m_strict && !calleesUnchanged())
+	m_strictness_known = false;
+    if (!m_strictness_known) {
+	m_callees.clear();
+	m_strict = (!m_matcher->has3Dots()
+		    && CalleeScan(this, &m_callees).run()
+		    && ForcingScan(this).run());
+	if (m_strict)
+	    m_strictness_epoch = Environment::lookupEpoch();
+	else m_callees.clear();
+	m_strictness_known = true;
+    }
+    return m_strict;
+}
+
 const char* Closure::typeName() const
 {
     return staticTypeName();
@@ -187,6 +556,7 @@ void Closure::visitReferents(const_visitor* v) const
     const ArgMatcher* matcher = m_matcher;
     const GCNode* body = m_body;
     const GCNode* environment = m_environment;
+    const GCNode* frame_layout = m_frame_layout;
     RObject::visitReferents(v);
     if (matcher)
 	(*v)(matcher);
@@ -194,6 +564,13 @@ void Closure::visitReferents(const_visitor* v) const
 	(*v)(body);
     if (environment)
 	(*v)(environment);
+    if (frame_layout)
+	(*v)(frame_layout);
+    for (std::vector<GCEdge<Environment> >::const_iterator it
+	     = m_spare_envs.begin(); it != m_spare_envs.end(); ++it) {
+	const GCNode* spare = *it;
+	(*v)(spare);
+    }
 }
 
 BOOST_CLASS_EXPORT_IMPLEMENT(CXXR::Closure)
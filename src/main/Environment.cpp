@@ -47,6 +47,7 @@
 #include "R_ext/Error.h"
 #include "localization.h"
 #include "CXXR/FunctionBase.h"
+#include "CXXR/GCManager.hpp"
 #include "CXXR/ListFrame.hpp"
 #include "CXXR/StdFrame.hpp"
 #include "CXXR/Symbol.h"
@@ -75,6 +76,8 @@ namespace {
 }
 
 Environment::Cache* Environment::s_cache;
+unsigned int Environment::s_cache_epoch = 0;
+unsigned long Environment::s_lookup_epoch = 0;
 Environment* Environment::s_base;
 Environment* Environment::s_base_namespace;
 Environment* Environment::s_empty;
@@ -107,6 +110,8 @@ void Environment::detachFrame()
 {
     if (m_cached && m_frame)
 	m_frame->decCacheCount();
+    if (m_frame && m_frame->watched())
+	invalidateLookups();
     m_frame = 0;
 }
 
@@ -115,6 +120,8 @@ void Environment::detachReferents()
     m_enclosing.detach();
     if (m_cached && m_frame)
 	m_frame->decCacheCount();
+    if (m_frame && m_frame->watched())
+	invalidateLookups();
     m_frame.detach();
     RObject::detachReferents();
 }
@@ -133,12 +140,12 @@ Environment::findBinding(const Symbol* symbol)
     while (env) {
 	if (env->isCachePortal()) {
 	    Cache::iterator it = s_cache->find(symbol);
-	    if (it == s_cache->end())
+	    if (it == s_cache->end() || (*it).second.m_epoch != s_cache_epoch)
 		cache_miss = true;
 #ifdef CHECK_CACHE
-	    else cachepr = (*it).second;
+	    else cachepr = (*it).second.m_pair;
 #else
-	    else return (*it).second;
+	    else return (*it).second.m_pair;
 #endif
 	}
 	Frame::Binding* bdg = env->frame()->binding(symbol);
@@ -149,7 +156,7 @@ Environment::findBinding(const Symbol* symbol)
 		abort();
 #endif
 	    if (cache_miss)
-		(*s_cache)[symbol] = ans;
+		(*s_cache)[symbol] = CacheEntry(ans, s_cache_epoch);
 	    return ans;
 	}
 	env = env->enclosingEnvironment();
@@ -163,16 +170,33 @@ Environment::findBinding(const Symbol* symbol)
 
 void Environment::flushFromCache(const Symbol* sym)
 {
+    // Only lookups of sym are affected, and inline caches need be
+    // invalidated only if they may hold such a lookup:
+    if (!sym || sym->lookupWatched())
+	invalidateLookups();
     if (sym)
 	s_cache->erase(sym);
-    else {
-	// Clear the cache, but retain the current number of buckets:
+    else if (++s_cache_epoch == 0) {
+	// The epoch has wrapped round, so entries with stale stamps
+	// could appear current.  Clear the cache, but retain the
+	// current number of buckets:
 	size_t buckets = s_cache->bucket_count();
 	s_cache->clear();
 	s_cache->rehash(buckets);
     }
 }
 
+void Environment::flushFrameFromCache(const Frame* frame)
+{
+    if (!frame)
+	return;
+    invalidateLookups();
+    Frame::BindingRange bdgs = frame->bindingRange();
+    for (Frame::BindingRange::const_iterator it = bdgs.begin();
+	 it != bdgs.end(); ++it)
+	s_cache->erase((*it).symbol());
+}
+
 void Environment::initialize()
 {
     // 509 is largest prime <= 512.  This will have capacity for 254
@@ -227,8 +251,31 @@ unsigned int Environment::packGPBits() const
 
 // Environment::packageName() in in envir.cpp
 
+bool Environment::recycle()
+{
+    Frame* frame = m_frame;
+    if (GCManager::deferredRefCounting()
+	|| !frame || m_cached || m_locked
+	|| attributes() || isS4Object()
+	|| refCount() != 0 || frame->refCount() != 1)
+	return false;
+    // Frame::clear() will invalidate any inline lookup caches that
+    // rely on the Frame:
+    frame->clear();
+    frame->m_locked = false;
+    frame->m_read_monitored = false;
+    frame->m_write_monitored = false;
+    frame->m_watched = false;
+    m_single_stepping = false;
+    m_leaked = false;
+    m_in_loop = false;
+    m_can_return = false;
+    return true;
+}
+
 void  Environment::setEnclosingEnvironment(Environment* new_enclos)
 {
+    invalidateLookups();
     m_enclosing = new_enclos;
     // Recursively propagate participation in search list cache:
     if (m_cached) {
@@ -245,8 +292,11 @@ void Environment::skipEnclosing()
 {
     if (!m_enclosing)
 	Rf_error(_("this Environment has no enclosing Environment."));
+    invalidateLookups();
+    // Only lookups of Symbols bound in the Environment being
+    // skipped can be affected:
     if (m_enclosing->m_cached)
-	flushFromCache(0);
+	flushFrameFromCache(m_enclosing->frame());
     m_enclosing = m_enclosing->m_enclosing;
 }
 
@@ -254,15 +304,33 @@ void Environment::slotBehind(Environment* anchor)
 {
     if (!anchor || anchor == this)
 	Rf_error("internal error in Environment::slotBehind()");
-    // Propagate participation in search list cache:
+    invalidateLookups();
+    // Propagate participation in search list cache.  Only lookups
+    // of Symbols bound in this Environment can be affected:
     if (anchor->m_cached) {
 	makeCached();
-	flushFromCache(0);
+	flushFrameFromCache(frame());
     }
     m_enclosing = anchor->m_enclosing;
     anchor->m_enclosing = this;
 }
 
+bool Environment::watchLookup(const Symbol* symbol, const Environment* target)
+{
+    symbol->markLookupWatched();
+    for (Environment* env = this; env; env = env->enclosingEnvironment()) {
+	// Changes from the global environment outwards are signalled
+	// via flushFromCache():
+	if (env->isCachePortal())
+	    return env->findBinding(symbol).first == target;
+	const Frame* frame = env->frame();
+	frame->watch();
+	if (frame->binding(symbol))
+	    return env == target;
+    }
+    return false;
+}
+
 const char* Environment::typeName() const
 {
     return staticTypeName();
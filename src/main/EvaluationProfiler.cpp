@@ -0,0 +1,208 @@
+/*CXXR $Id$
+ *CXXR
+ *CXXR This file is part of CXXR, a project to refactor the R interpreter
+ *CXXR into C++.  It may consist in whole or in part of program code and
+ *CXXR documentation taken from the R project itself, incorporated into
+ *CXXR CXXR (and possibly MODIFIED) under the terms of the GNU General Public
+ *CXXR Licence.
+ *CXXR
+ *CXXR CXXR is Copyright (C) 2008-14 Andrew R. Runnalls, subject to such other
+ *CXXR copyrights and copyright restrictions as may be stated below.
+ *CXXR
+ *CXXR CXXR is not part of the R project, and bugs and other issues should
+ *CXXR not be reported via r-bugs or other R project channels; instead refer
+ *CXXR to the CXXR website.
+ *CXXR */
+
+/** @file EvaluationProfiler.cpp
+ *
+ * Implementation of class EvaluationProfiler.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "CXXR/EvaluationProfiler.hpp"
+
+#include <sstream>
+#include <vector>
+#include "CXXR/Environment.h"
+#include "CXXR/Evaluator.h"
+#include "CXXR/Expression.h"
+#include "CXXR/FunctionContext.hpp"
+#include "CXXR/IntVector.h"
+#include "CXXR/StringVector.h"
+#include "CXXR/Symbol.h"
+
+#if !defined(Win32) && !defined(HAVE_PTHREAD) \
+    && (defined(__APPLE__) || defined(_REENTRANT) || defined(HAVE_OPENMP))
+#define HAVE_PTHREAD
+#endif
+#ifdef HAVE_PTHREAD
+#include <cerrno>
+#include <ctime>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/time.h>
+#endif
+
+using namespace std;
+using namespace CXXR;
+
+unsigned int EvaluationProfiler::s_interval = 0;
+bool EvaluationProfiler::s_srcrefs = false;
+volatile unsigned int EvaluationProfiler::s_ticks = 0;
+unsigned int EvaluationProfiler::s_ticks_sampled = 0;
+EvaluationProfiler::Stacks EvaluationProfiler::s_stacks;
+
+namespace {
+#ifdef HAVE_PTHREAD
+    pthread_t timer_thread;
+    // timer_mutex protects timer_running.  timer_cond is signalled
+    // when timer_running is cleared, so that stopTimer() need not
+    // wait for the current sampling interval to run out:
+    pthread_mutex_t timer_mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t timer_cond = PTHREAD_COND_INITIALIZER;
+#endif
+    bool timer_running = false;
+
+    // Return the source location designated by srcref in the form
+    // " [file#line]", or an empty string if it cannot be
+    // determined:
+    string location(const RObject* srcref)
+    {
+	static const Symbol* filename_sym = Symbol::obtain("filename");
+	const IntVector* lines = dynamic_cast<const IntVector*>(srcref);
+	if (!lines || lines->size() == 0)
+	    return string();
+	const Environment* srcfile = dynamic_cast<const Environment*>(
+	    lines->getAttribute(SrcfileSymbol));
+	if (!srcfile)
+	    return string();
+	const Frame::Binding* bdg = srcfile->frame()->binding(filename_sym);
+	const StringVector* filename
+	    = (bdg ? dynamic_cast<const StringVector*>(bdg->rawValue()) : 0);
+	if (!filename || filename->size() == 0 || !(*filename)[0])
+	    return string();
+	ostringstream os;
+	os << " [" << (*filename)[0]->c_str() << '#' << (*lines)[0] << ']';
+	return os.str();
+    }
+}
+
+// Called from Evaluator::evaluate() on the main thread, so it is
+// safe to examine the context stack and to allocate memory.
+void EvaluationProfiler::sample()
+{
+    unsigned int ticks = s_ticks;
+    size_t weight = ticks - s_ticks_sampled;
+    s_ticks_sampled = ticks;
+    if (!s_interval)
+	return;
+    // The stack is recorded outermost first, so first gather the
+    // contexts (innermost first) and then build the string from the
+    // far end:
+    static vector<const FunctionContext*> contexts;
+    contexts.clear();
+    for (FunctionContext* fctxt = FunctionContext::innermost();
+	 fctxt; fctxt = FunctionContext::innermost(fctxt->nextOut()))
+	contexts.push_back(fctxt);
+    if (contexts.empty()) {
+	s_stacks["<TopLevel>"] += weight;
+	return;
+    }
+    string stack;
+    stack.reserve(32*contexts.size());
+    for (vector<const FunctionContext*>::reverse_iterator it
+	     = contexts.rbegin(); it != contexts.rend(); ++it) {
+	const FunctionContext* fctxt = *it;
+	const RObject* fun = (fctxt->call() ? fctxt->call()->car() : 0);
+	if (!stack.empty())
+	    stack += ';';
+	if (fun && fun->sexptype() == SYMSXP)
+	    stack += static_cast<const Symbol*>(fun)->name()->c_str();
+	else stack += "<Anonymous>";
+	if (s_srcrefs)
+	    stack += location(fctxt->sourceLocation());
+    }
+    s_stacks[stack] += weight;
+}
+
+bool EvaluationProfiler::start(unsigned int interval, bool srcrefs)
+{
+    stopTimer();
+    s_interval = 0;
+    s_srcrefs = srcrefs;
+    s_ticks_sampled = s_ticks;
+    if (!interval)
+	return true;
+#ifdef HAVE_PTHREAD
+    s_interval = interval;
+    timer_running = true;
+    // Start the timer thread with all signals blocked, so that
+    // signals continue to be handled by the main thread:
+    sigset_t all, saved;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &saved);
+    bool ok = (pthread_create(&timer_thread, 0, timerMain, 0) == 0);
+    pthread_sigmask(SIG_SETMASK, &saved, 0);
+    if (!ok) {
+	timer_running = false;
+	s_interval = 0;
+    }
+    return ok;
+#else
+    return false;
+#endif
+}
+
+void EvaluationProfiler::stopTimer()
+{
+#ifdef HAVE_PTHREAD
+    if (s_interval) {
+	pthread_mutex_lock(&timer_mutex);
+	timer_running = false;
+	pthread_cond_signal(&timer_cond);
+	pthread_mutex_unlock(&timer_mutex);
+	pthread_join(timer_thread, 0);
+    }
+#endif
+}
+
+void EvaluationProfiler::takeStacks(Stacks* dest)
+{
+    dest->clear();
+    dest->swap(s_stacks);
+}
+
+void* EvaluationProfiler::timerMain(void*)
+{
+#ifdef HAVE_PTHREAD
+    // Sampling intervals are counted off against absolute
+    // deadlines, so that time spent by this thread does not
+    // accumulate as drift:
+    struct timeval now;
+    gettimeofday(&now, 0);
+    struct timespec deadline;
+    deadline.tv_sec = now.tv_sec;
+    deadline.tv_nsec = long(now.tv_usec)*1000;
+    pthread_mutex_lock(&timer_mutex);
+    while (timer_running) {
+	deadline.tv_nsec += long(s_interval%1000000)*1000;
+	deadline.tv_sec += s_interval/1000000 + deadline.tv_nsec/1000000000;
+	deadline.tv_nsec %= 1000000000;
+	// Wait out the interval, unless stopTimer() intervenes:
+	int status = 0;
+	while (timer_running && status != ETIMEDOUT)
+	    status = pthread_cond_timedwait(&timer_cond, &timer_mutex,
+					    &deadline);
+	if (status == ETIMEDOUT) {
+	    s_ticks = s_ticks + 1;
+	    Evaluator::requestChecks();
+	}
+    }
+    pthread_mutex_unlock(&timer_mutex);
+#endif
+    return 0;
+}
@@ -23,6 +23,7 @@
 
 #include "CXXR/DottedArgs.hpp"
 #include "CXXR/Environment.h"
+#include "CXXR/EvaluationProfiler.hpp"
 #include "CXXR/Expression.h"
 #include "CXXR/GCStackRoot.hpp"
 #include "CXXR/Symbol.h"
@@ -40,6 +41,7 @@ unsigned int Evaluator::s_depth_threshold = 5000;
 unsigned int Evaluator::s_depth_limit = 5000;
 unsigned int Evaluator::s_countdown = 1000;
 unsigned int Evaluator::s_countdown_start = 1000;
+volatile sig_atomic_t Evaluator::s_checks_requested = 0;
 Evaluator* Evaluator::s_current = 0;
 bool Evaluator::s_profiling = false;
 
@@ -59,9 +61,11 @@ RObject* Evaluator::evaluate(RObject* object, Environment* env)
 	Rf_errorcall(0, _("evaluation nested too deeply: "
 			  "infinite recursion / options(expressions=)?"));
     }
-    if (--s_countdown == 0) {
+    if (--s_countdown == 0 || s_checks_requested) {
+	s_checks_requested = 0;
 	R_CheckUserInterrupt();
 	s_countdown = s_countdown_start;
+	EvaluationProfiler::poll();
     }
 #ifdef Win32
     // This is an inlined version of Rwin_fpreset (src/gnuwin/extra.c)
@@ -47,6 +47,7 @@
 #include "CXXR/Evaluator.h"
 #include "CXXR/FunctionBase.h"
 #include "CXXR/GCStackRoot.hpp"
+#include "CXXR/SlotFrame.hpp"
 #include "CXXR/Symbol.h"
 
 using namespace std;
@@ -62,23 +63,47 @@ namespace CXXR {
 
 GCRoot<> R_CurrentExpr;
 
+// The cache is keyed by the shape of the Frame in which the search
+// starts (see Frame::shape()) and by the Environment enclosing it.
+// This will be the same for successive calls from a given point in
+// the body of a Closure, provided the Closure's environment is
+// unchanged.
+struct Expression::FunctionCache {
+    GCEdge<const GCNode> m_shape;
+    const Symbol* m_symbol;
+    const Environment* m_enclosing;
+    Frame::Binding* m_binding;
+    unsigned long m_epoch;
+
+    FunctionCache()
+	: m_symbol(0), m_enclosing(0), m_binding(0), m_epoch(0)
+    {}
+};
+
+Expression::~Expression()
+{
+    delete m_function_cache;
+}
+
 Expression* Expression::clone() const
 {
     return expose(new Expression(*this));
 }
 
+void Expression::detachReferents()
+{
+    if (m_function_cache)
+	m_function_cache->m_shape.detach();
+    ConsCell::detachReferents();
+}
+
 RObject* Expression::evaluate(Environment* env)
 {
     GCStackRoot<FunctionBase> func;
     RObject* head = car();
-    if (head->sexptype() == SYMSXP) {
-	Symbol* symbol = static_cast<Symbol*>(head);
-	pair<Environment*, FunctionBase*> pr = findFunction(symbol, env);
-	if (!pr.first)
-	    error(_("could not find function \"%s\""),
-		  symbol->name()->c_str());
-	func = pr.second;
-    } else {
+    if (head->sexptype() == SYMSXP)
+	func = findFunction(static_cast<Symbol*>(head), env);
+    else {
 	RObject* val = Evaluator::evaluate(head, env);
 	if (!FunctionBase::isA(val))
 	    error(_("attempt to apply non-function"));
@@ -89,11 +114,57 @@ RObject* Expression::evaluate(Environment* env)
     return func->apply(&arglist, env, this);
 }
 
+FunctionBase* Expression::findFunction(const Symbol* symbol,
+				       Environment* env)
+{
+    const GCNode* shape = env->frame()->shape();
+    FunctionCache* fc = m_function_cache;
+    if (fc && shape && fc->m_shape == shape && fc->m_symbol == symbol
+	&& fc->m_enclosing == env->enclosingEnvironment()
+	&& fc->m_epoch == Environment::lookupEpoch()) {
+	Frame::Binding* bdg = fc->m_binding;
+	pair<RObject*, bool> fpr = bdg->forcedValue();
+	if (FunctionBase::isA(fpr.first)) {
+	    // Invoke read monitor as in findTestedValue():
+	    if (!fpr.second)
+		bdg->rawValue();
+	    return static_cast<FunctionBase*>(fpr.first);
+	}
+    }
+    pair<Environment*, FunctionBase*> pr = CXXR::findFunction(symbol, env);
+    if (!pr.first)
+	error(_("could not find function \"%s\""), symbol->name()->c_str());
+    // Only SlotFrame objects have shapes.  Cache the result if the
+    // Symbol cannot be bound locally, and the Binding found is the
+    // first in the enclosing Environments:
+    if (shape
+	&& static_cast<const SlotFrame::Layout*>(shape)->slot(symbol) < 0) {
+	Environment* enclosing = env->enclosingEnvironment();
+	if (enclosing && enclosing->watchLookup(symbol, pr.first)) {
+	    if (!fc)
+		fc = m_function_cache = new FunctionCache;
+	    fc->m_shape = shape;
+	    fc->m_symbol = symbol;
+	    fc->m_enclosing = enclosing;
+	    fc->m_binding = pr.first->frame()->binding(symbol);
+	    fc->m_epoch = Environment::lookupEpoch();
+	}
+    }
+    return pr.second;
+}
+
 const char* Expression::typeName() const
 {
     return staticTypeName();
 }
 
+void Expression::visitReferents(const_visitor* v) const
+{
+    ConsCell::visitReferents(v);
+    if (m_function_cache && m_function_cache->m_shape)
+	(*v)(m_function_cache->m_shape);
+}
+
 BOOST_CLASS_EXPORT_IMPLEMENT(CXXR::Expression)
 
 // ***** C interface *****
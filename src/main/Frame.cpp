@@ -211,7 +211,10 @@ void Frame::enableWriteMonitoring(bool on) const
 
 void Frame::flush(const Symbol* sym)
 {
-    Environment::flushFromCache(sym);
+    if (m_watched && (!sym || sym->lookupWatched()))
+	Environment::invalidateLookups();
+    if (m_cache_count > 0)
+	Environment::flushFromCache(sym);
 }
 
 Frame::Binding* Frame::obtainBinding(const Symbol* symbol)
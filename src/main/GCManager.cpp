@@ -43,9 +43,13 @@
 
 #include <cmath>
 #include <cstdarg>
+#include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#ifndef HAVE_CLOCK_GETTIME
+#include <sys/time.h>
+#endif
 #include "R_ext/Print.h"
 #include "CXXR/GCNode.hpp"
 #include "CXXR/WeakRef.h"
@@ -56,13 +60,139 @@ size_t GCManager::s_threshold;
 size_t GCManager::s_min_threshold;
 size_t GCManager::s_max_bytes = 0;
 size_t GCManager::s_max_nodes = 0;
+const double GCManager::s_full_gc_ratio = 0.75;
+GCManager::Statistics GCManager::s_stats;
+size_t GCManager::s_max_heap = 0;
+const double GCManager::s_preempt_ratio = 0.9;
+double GCManager::s_gc_fraction_target = 0.05;
+size_t GCManager::s_defrag_peak = 0;
+const double GCManager::s_defrag_ratio = 0.25;
+double GCManager::s_pause_budget = 0.0;
+size_t GCManager::s_mark_threshold;
+size_t GCManager::s_slice_bytes;
+size_t GCManager::s_saved_threshold;
 std::ostream* GCManager::s_os = 0;
 
 void (*GCManager::s_pre_gc)() = 0;
 void (*GCManager::s_post_gc)() = 0;
 
 namespace {
-    unsigned int gc_count;
+    // Time at which the most recent collection (or incremental mark
+    // slice) finished:
+    double last_gc_end;
+
+    // Elapsed time in milliseconds, measured from an arbitrary
+    // origin:
+    double milliseconds()
+    {
+#ifdef HAVE_CLOCK_GETTIME
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return 1000.0*double(ts.tv_sec) + 1.0e-6*double(ts.tv_nsec);
+#else
+	timeval tv;
+	gettimeofday(&tv, 0);
+	return 1000.0*double(tv.tv_sec) + 0.001*double(tv.tv_usec);
+#endif
+    }
+
+    // Record the time since the last collection as mutator time, and
+    // return the current time:
+    double startTiming(GCManager::Statistics* stats)
+    {
+	double now = milliseconds();
+	stats->mutator_time += now - last_gc_end;
+	stats->cycle_mutator_time += now - last_gc_end;
+	return now;
+    }
+
+    // Record the time since start as collection time:
+    void endTiming(GCManager::Statistics* stats, double start)
+    {
+	last_gc_end = milliseconds();
+	stats->gc_time += last_gc_end - start;
+	stats->cycle_gc_time += last_gc_end - start;
+    }
+
+    class DefaultPolicy : public GCManager::Policy {
+    public:
+	const char* name() const
+	{
+	    return "default";
+	}
+
+	size_t nextThreshold(size_t bytes, size_t threshold,
+			     size_t min_threshold)
+	{
+	    return std::max(size_t(0.9*double(threshold)),
+			    std::max(min_threshold, 2*bytes));
+	}
+    };
+
+    class CPUFractionPolicy : public GCManager::Policy {
+    public:
+	CPUFractionPolicy()
+	    : m_growth(2.0)
+	{}
+
+	const char* name() const
+	{
+	    return "cpu";
+	}
+
+	size_t nextThreshold(size_t bytes, size_t threshold,
+			     size_t min_threshold);
+    private:
+	double m_growth;  // Ratio of the threshold to the number of
+			  // bytes surviving a full collection.
+    };
+
+    size_t CPUFractionPolicy::nextThreshold(size_t bytes, size_t,
+					    size_t min_threshold)
+    {
+	const GCManager::Statistics& stats = GCManager::statistics();
+	double elapsed = stats.cycle_gc_time + stats.cycle_mutator_time;
+	if (stats.cycle_gc_time > 0.0 && elapsed > 0.0) {
+	    // The time spent collecting over a cycle is taken to be
+	    // roughly inversely proportional to the headroom above the
+	    // live data, i.e. to m_growth - 1.  Move halfway (on a
+	    // logarithmic scale) towards the headroom that would have
+	    // met the target:
+	    double ratio = (stats.cycle_gc_time/elapsed)
+		/GCManager::gcFractionTarget();
+	    m_growth = 1.0 + (m_growth - 1.0)*std::sqrt(ratio);
+	    m_growth = std::min(std::max(m_growth, 1.25), 16.0);
+	}
+	return std::max(min_threshold, size_t(m_growth*double(bytes)));
+    }
+
+    class ThroughputPolicy : public GCManager::Policy {
+    public:
+	bool fullCollectionDue(size_t bytes, size_t threshold) const
+	{
+	    return bytes > 0.9*double(threshold);
+	}
+
+	size_t gcliteMargin() const
+	{
+	    return 100000;
+	}
+
+	const char* name() const
+	{
+	    return "throughput";
+	}
+
+	size_t nextThreshold(size_t bytes, size_t threshold,
+			     size_t min_threshold)
+	{
+	    return std::max(threshold, std::max(min_threshold, 4*bytes));
+	}
+    };
+
+    DefaultPolicy default_policy;
+    CPUFractionPolicy cpu_policy;
+    ThroughputPolicy throughput_policy;
 
 
 #ifdef DEBUG_GC
@@ -81,37 +211,183 @@ namespace {
 #endif /* DEBUG_GC */
 }
 
-void GCManager::gc()
+GCManager::Policy* GCManager::s_policy = &default_policy;
+
+bool GCManager::Policy::fullCollectionDue(size_t bytes,
+					  size_t threshold) const
+{
+    return bytes > s_full_gc_ratio*double(threshold);
+}
+
+size_t GCManager::Policy::gcliteMargin() const
+{
+    return 10000;
+}
+
+GCManager::Policy* GCManager::builtInPolicy(const std::string& name)
+{
+    if (name == default_policy.name())
+	return &default_policy;
+    if (name == cpu_policy.name())
+	return &cpu_policy;
+    if (name == throughput_policy.name())
+	return &throughput_policy;
+    return 0;
+}
+
+bool GCManager::deferredRefCounting()
+{
+    return GCNode::s_defer_refcounts;
+}
+
+void GCManager::gc(bool full)
 {
     // Prevent recursion:
     static bool in_progress = false;
     if (in_progress)
 	return;
     in_progress = true;
-    gcController();
-    WeakRef::runFinalizers();
+    if (!full && GCNode::isMarkingIncrementally()
+	&& MemoryBank::bytesAllocated() < s_mark_threshold)
+	markSlice();
+    else {
+	gcController(full);
+	WeakRef::runFinalizers();
+    }
     in_progress = false;
 }
 
-void GCManager::gcController()
+void GCManager::gcController(bool full)
 {
-    ++gc_count;
+    double start = startTiming(&s_stats);
+    ++s_stats.collections;
 
     s_max_bytes = std::max(s_max_bytes, MemoryBank::bytesAllocated());
     s_max_nodes = std::max(s_max_nodes, GCNode::numNodes());
+    s_defrag_peak = std::max(s_defrag_peak, MemoryBank::bytesAllocated());
 
     if (s_pre_gc) (*s_pre_gc)();
-    GCNode::gc();
-    s_threshold = std::max(size_t(0.9*double(s_threshold)),
-			   std::max(s_min_threshold,
-				    2*MemoryBank::bytesAllocated()));
+    bool collected = false;  // Set true if a full collection is done.
+    if (GCNode::isMarkingIncrementally()) {
+	// Either allocation has outrun the incremental mark, or a full
+	// collection has been requested: complete the mark now.
+	GCNode::finishIncrementalMark();
+	s_threshold = s_saved_threshold;
+	// Nodes created during the incremental mark will have
+	// survived it, so if a full collection has been requested, do
+	// another one:
+	if (full)
+	    GCNode::gc(true);
+	collected = true;
+    }
+    else if (full) {
+	GCNode::gc(true);
+	collected = true;
+    }
+    else if (s_max_heap != 0 && MemoryBank::bytesAllocated()
+	     > s_preempt_ratio*double(s_max_heap)) {
+	// Close to the cap: skip the minor collection.
+	GCNode::gc(true);
+	collected = true;
+	++s_stats.preemptive_collections;
+    }
+    else {
+	GCNode::gc(false);
+	if (s_policy->fullCollectionDue(MemoryBank::bytesAllocated(),
+					s_threshold)) {
+	    if (s_pause_budget > 0.0)
+		startIncrementalMark();
+	    else {
+		GCNode::gc(true);
+		collected = true;
+	    }
+	}
+    }
+    if (collected) {
+	++s_stats.full_collections;
+	// If memory use has fallen well below its recent peak, return
+	// wholly unused superblocks to the operating system.  (This
+	// isn't done after every full collection, because sorting the
+	// free lists would add appreciably to the cost of a
+	// collection.)
+	if (MemoryBank::bytesAllocated()
+	    < s_defrag_ratio*double(s_defrag_peak)) {
+	    MemoryBank::defragment();
+	    s_defrag_peak = MemoryBank::bytesAllocated();
+	}
+    }
+    endTiming(&s_stats, start);
+    if (collected) {
+	s_stats.last_full_time = last_gc_end - start;
+	s_threshold = s_policy->nextThreshold(MemoryBank::bytesAllocated(),
+					      s_threshold, s_min_threshold);
+	s_threshold = std::min(s_threshold, heapLimit());
+	s_stats.cycle_gc_time = s_stats.cycle_mutator_time = 0.0;
+    }
+    full = collected;
+    if (s_os) {
+	*s_os << "Garbage collection " << s_stats.collections << " = "
+	      << s_stats.collections - s_stats.full_collections << '+'
+	      << s_stats.full_collections
+	      << " (level " << (full ? 1 : 0) << ") ... \n"
+	      << 0.1*std::ceil(10.0*double(MemoryBank::bytesAllocated())
+			       /1048576.0)
+	      << " Mbytes used (" << GCNode::numOldNodes() << " of "
+	      << GCNode::numNodes() << " nodes in old generation)"
+	      << std::endl;
+    }
     if (s_post_gc) (*s_post_gc)();
 }
 
+size_t GCManager::heapLimit()
+{
+    if (s_max_heap == 0)
+	return std::numeric_limits<size_t>::max();
+    // If the live data leave no room beneath the cap, allow the heap
+    // to grow by an eighth before the next collection:
+    size_t bytes = MemoryBank::bytesAllocated();
+    return std::max(s_max_heap, bytes + bytes/8);
+}
+
 void GCManager::initialize()
 {
     setGCThreshold(std::numeric_limits<size_t>::max());
-    gc_count = 0;
+    Statistics zero = {0, 0, 0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    s_stats = zero;
+    last_gc_end = milliseconds();
+}
+
+void GCManager::markSlice()
+{
+    const size_t batch = 256;
+    if (s_pre_gc) (*s_pre_gc)();
+    double start = startTiming(&s_stats);
+    double elapsed;
+    size_t marked = 0;
+    bool done = false;
+    do {
+	size_t n = GCNode::markSome(batch);
+	marked += n;
+	done = (n < batch);
+	elapsed = milliseconds() - start;
+    } while (!done && elapsed < s_pause_budget);
+    endTiming(&s_stats, start);
+    if (s_post_gc) (*s_post_gc)();
+    if (s_os)
+	*s_os << "Incremental mark slice: " << marked << " nodes marked in "
+	      << elapsed << " ms" << std::endl;
+    if (done) {
+	// Complete the mark and sweep:
+	gcController(false);
+	WeakRef::runFinalizers();
+    }
+    else s_threshold = std::min(s_mark_threshold,
+				MemoryBank::bytesAllocated() + s_slice_bytes);
+}
+
+unsigned int GCManager::markThreads()
+{
+    return GCNode::s_mark_threads;
 }
 
 void GCManager::resetMaxTallies()
@@ -120,11 +396,61 @@ void GCManager::resetMaxTallies()
     s_max_nodes = GCNode::numNodes();
 }
 
+void GCManager::startIncrementalMark()
+{
+    GCNode::beginIncrementalMark();
+    size_t bytes = MemoryBank::bytesAllocated();
+    // Allow allocation to grow by half as much again while the mark
+    // proceeds, with the mark divided into (at least) 32 slices:
+    s_saved_threshold = s_threshold;
+    s_mark_threshold = std::min(std::max(s_threshold, bytes + bytes/2),
+				std::max(s_threshold, heapLimit()));
+    s_slice_bytes = std::max(size_t(65536), (s_mark_threshold - bytes)/32);
+    s_threshold = std::min(s_mark_threshold, bytes + s_slice_bytes);
+    if (s_os)
+	*s_os << "Incremental mark started" << std::endl;
+}
+
 void GCManager::setGCThreshold(size_t initial_threshold)
 {
     s_min_threshold = s_threshold = initial_threshold;
 }
 
+void GCManager::setDeferredRefCounting(bool on)
+{
+    if (!on)
+	GCNode::applyRefCountLog();
+    GCNode::s_defer_refcounts = on;
+}
+
+void GCManager::setGCFractionTarget(double fraction)
+{
+    s_gc_fraction_target = std::min(std::max(fraction, 0.001), 0.999);
+}
+
+void GCManager::setMarkThreads(unsigned int num_threads)
+{
+    GCNode::s_mark_threads = std::max(num_threads, 1u);
+}
+
+void GCManager::setPauseBudget(double millisecs)
+{
+    s_pause_budget = std::max(millisecs, 0.0);
+}
+
+void GCManager::setMaxHeap(size_t bytes)
+{
+    s_max_heap = bytes;
+    if (!GCNode::isMarkingIncrementally())
+	s_threshold = std::min(s_threshold, heapLimit());
+}
+
+void GCManager::setPolicy(Policy* policy)
+{
+    s_policy = policy;
+    GCNode::s_gclite_margin = policy->gcliteMargin();
+}
+
 std::ostream* GCManager::setReporting(std::ostream* os)
 {
     std::ostream* ans = s_os;
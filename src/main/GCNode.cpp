@@ -39,6 +39,10 @@
  * Class GCNode and associated C-callable functions.
  */
 
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
 #include "CXXR/GCNode.hpp"
 
 #include <algorithm>
@@ -56,13 +60,32 @@
 #include <typeinfo>
 #endif
 
+#if !defined(Win32) && !defined(HAVE_PTHREAD) \
+    && (defined(__APPLE__) || defined(_REENTRANT) || defined(HAVE_OPENMP))
+#define HAVE_PTHREAD
+#endif
+// Parallel marking uses POSIX threads and gcc's atomic builtins:
+#if defined(HAVE_PTHREAD) && defined(__GNUC__) && !defined(GC_FIND_LOOPS)
+#define PARALLEL_MARK
+#include <deque>
+#include <sched.h>
+#include "CXXR/WorkerPool.hpp"
+#endif
+
 using namespace std;
 using namespace CXXR;
 
 GCNode::List* GCNode::s_live;
+GCNode::List* GCNode::s_old;
 vector<const GCNode*>* GCNode::s_moribund;
+GCNode::List* GCNode::s_condemned;
+bool GCNode::s_marking = false;
+vector<const GCNode*>* GCNode::s_grey;
+vector<const GCNode*>* GCNode::s_grey_moribund;
 GCNode::List* GCNode::s_reachable;
+unsigned int GCNode::s_mark_threads = 1;
 unsigned int GCNode::s_num_nodes = 0;
+unsigned int GCNode::s_num_old_nodes = 0;
 unsigned int GCNode::s_inhibitor_count = 0;
 #ifdef GCID
 unsigned int GCNode::s_last_id = 0;
@@ -74,8 +97,12 @@ const unsigned char GCNode::s_decinc_refcount[]
    0x1e, 2, 2, 6, 6, 2, 2, 0xe, 0xe, 2, 2, 6, 6, 2, 2, 0x3e,
    0x3e, 2, 2, 6, 6, 2, 2, 0xe, 0xe, 2, 2, 6, 6, 2, 2, 0x1e,
    0x1e, 2, 2, 6, 6, 2, 2, 0xe, 0xe, 2, 2, 6, 6, 2, 0,    0};
-const size_t GCNode::s_gclite_margin = 10000;
+size_t GCNode::s_gclite_margin = 10000;
+bool GCNode::s_defer_refcounts = false;
+GCNode::RefCountChange GCNode::s_rc_log[GCNode::s_rc_log_capacity];
+size_t GCNode::s_rc_log_size = 0;
 size_t GCNode::s_gclite_threshold;
+const size_t GCNode::s_min_parallel_mark_nodes = 100000;
 unsigned char GCNode::s_mark = 0;
 
 // Some versions of gcc (e.g. 4.2.1) give a spurious "throws different
@@ -100,11 +127,28 @@ void* GCNode::operator new(size_t bytes)
 #ifdef RARE_GC
 	gclite();
 #endif
-	GCManager::gc();
+	GCManager::gc(false);
     }
     return MemoryBank::allocate(bytes);
 }
 
+class GCNode::ImmediateRefCounting {
+public:
+    ImmediateRefCounting()
+	: m_deferring(s_defer_refcounts)
+    {
+	applyRefCountLog();
+	s_defer_refcounts = false;
+    }
+
+    ~ImmediateRefCounting()
+    {
+	s_defer_refcounts = m_deferring;
+    }
+private:
+    bool m_deferring;
+};
+
 void GCNode::abortIfNotExposed(const GCNode* node)
 {
     if (node && (node->m_rcmmu & 1)) {
@@ -119,13 +163,33 @@ void GCNode::alreadyExposedError()
     abort();
 }
 
+void GCNode::applyRefCountLog()
+{
+    if (s_rc_log_size == 0)
+	return;
+    for (size_t i = 0; i < s_rc_log_capacity; ++i) {
+	RefCountChange& change = s_rc_log[i];
+	if (change.m_node) {
+	    // Nodes whose changes have cancelled out are not touched:
+	    for (; change.m_delta > 0; --change.m_delta)
+		change.m_node->incRefCountNow();
+	    for (; change.m_delta < 0; ++change.m_delta)
+		change.m_node->decRefCountNow();
+	    change.m_node = 0;
+	}
+    }
+    s_rc_log_size = 0;
+}
+
 bool GCNode::check()
 {
     if (s_live == 0) {
 	cerr << "GCNode::check() : class not initialised.\n";
 	abort();
     }
+    ImmediateRefCounting immediate;
     unsigned int numnodes = 0;
+    unsigned int numold = 0;
     unsigned int virgins = 0;
     // Check live list:
     {
@@ -134,6 +198,54 @@ bool GCNode::check()
 	     it != end; ++it) {
 	    const GCNode* node = *it;
 	    ++numnodes;
+	    if (node->m_old) {
+		cerr << "GCNode::check() : "
+		    "old node on young generation list.\n";
+		abort();
+	    }
+	    if ((node->m_rcmmu & s_refcount_mask) == 0)
+		++virgins;
+	}
+    }
+    // Check old generation list:
+    {
+	List::const_iterator end = s_old->end();
+	for (List::const_iterator it = s_old->begin();
+	     it != end; ++it) {
+	    const GCNode* node = *it;
+	    ++numnodes;
+	    ++numold;
+	    if (!node->m_old) {
+		cerr << "GCNode::check() : "
+		    "young node on old generation list.\n";
+		abort();
+	    }
+	    if ((node->m_rcmmu & s_refcount_mask) == 0)
+		++virgins;
+	}
+    }
+    // Check nodes awaiting incremental marking:
+    {
+	List::const_iterator end = s_condemned->end();
+	for (List::const_iterator it = s_condemned->begin();
+	     it != end; ++it) {
+	    const GCNode* node = *it;
+	    ++numnodes;
+	    if (node->m_old)
+		++numold;
+	    if ((node->m_rcmmu & s_refcount_mask) == 0)
+		++virgins;
+	}
+    }
+    // Check nodes already found to be reachable:
+    {
+	List::const_iterator end = s_reachable->end();
+	for (List::const_iterator it = s_reachable->begin();
+	     it != end; ++it) {
+	    const GCNode* node = *it;
+	    ++numnodes;
+	    if (node->m_old)
+		++numold;
 	    if ((node->m_rcmmu & s_refcount_mask) == 0)
 		++virgins;
 	}
@@ -144,7 +256,7 @@ bool GCNode::check()
 	for (vector<const GCNode*>::const_iterator it = s_moribund->begin();
 	     it != end; ++it) {
 	    const GCNode* node = *it;
-	    if (!(node->m_rcmmu & s_moribund_mask)) {
+	    if (node && !(node->m_rcmmu & s_moribund_mask)) {
 		cerr << "GCNode::check() : "
 		    "Node on moribund list without moribund bit set.\n";
 		abort();
@@ -157,6 +269,11 @@ bool GCNode::check()
 	    "recorded number of nodes inconsistent with nodes found.\n";
 	abort();
     }
+    if (numold != s_num_old_nodes) {
+	cerr << "GCNode::check() :"
+	    "recorded number of old nodes inconsistent with nodes found.\n";
+	abort();
+    }
     // Report number of 'virgins', if any:
     if (virgins > 0)
 	cerr << "GCNode::check() : " << virgins
@@ -166,25 +283,72 @@ bool GCNode::check()
 
 void GCNode::cleanup()
 {
+    ImmediateRefCounting immediate;
     ProtectStack::restoreSize(0);
+    s_marking = false;
+    s_live->splice_back(s_condemned);
+    s_live->splice_back(s_reachable);
+    s_live->splice_back(s_old);
     sweep();
     GCManager::cleanup();
     ProtectStack::cleanup();
     GCRootBase::cleanup();
 }
 
+void GCNode::beginIncrementalMark()
+{
+    s_mark ^= s_mark_mask;
+    s_condemned->splice_back(s_live);
+    s_condemned->splice_back(s_old);
+    s_marking = true;
+    GreyMarker marker;
+    GCRootBase::visitRoots(&marker);
+    GCStackRootBase::visitRoots(&marker);
+    ProtectStack::visitRoots(&marker);
+    ByteCode::visitRoots(&marker);
+}
+
 void GCNode::destruct_aux()
 {
-    // Erase this node from the moribund list:
-    typedef std::vector<const GCNode*>::iterator Iter;
-    Iter it = std::find(s_moribund->begin(), s_moribund->end(), this);
-    if (it == s_moribund->end())
+    // Null out this node's entry in the moribund list:
+    if (m_moribund_index >= s_moribund->size()
+	|| (*s_moribund)[m_moribund_index] != this)
 	abort();  // Should never happen!
-    s_moribund->erase(it);
+    (*s_moribund)[m_moribund_index] = 0;
     --s_inhibitor_count;
 }
     
-void GCNode::gc()
+void GCNode::finishIncrementalMark()
+{
+    // Sweeping relies on decrements being applied immediately, so
+    // that no log entry can outlive its node:
+    ImmediateRefCounting immediate;
+    // Stack-based roots are not covered by the write barrier, so
+    // visit the roots again:
+    {
+	GreyMarker marker;
+	GCRootBase::visitRoots(&marker);
+	GCStackRootBase::visitRoots(&marker);
+	ProtectStack::visitRoots(&marker);
+	ByteCode::visitRoots(&marker);
+    }
+    while (markSome(numeric_limits<size_t>::max()) > 0)
+	;
+    WeakRef::markThru();
+    s_marking = false;
+    s_moribund->insert(s_moribund->end(), s_grey_moribund->begin(),
+		       s_grey_moribund->end());
+    s_grey_moribund->clear();
+    // Nodes created during the mark are black, but are not on the
+    // s_reachable list, so we park them while sweeping:
+    List newborn;
+    newborn.splice_back(s_live);
+    s_live->splice_back(s_condemned);
+    sweep();
+    s_live->splice_back(&newborn);
+}
+
+void GCNode::gc(bool full)
 {
     // Note that recursion prevention is applied in GCManager::gc(),
     // not here.
@@ -199,9 +363,14 @@ void GCNode::gc()
 	    " collection is inhibited.\n";
 	abort();
     }
-    mark();
-    sweep();
-    // MemoryBank::defragment();
+    // Minor collections rely on accurate reference counts, and
+    // sweeping on decrements being applied immediately:
+    ImmediateRefCounting immediate;
+    if (full) {
+	mark();
+	sweep();
+    }
+    else minorGC();
 
     // cout << "Finishing garbage collection\n";
     // GCNode::check();
@@ -213,6 +382,7 @@ void GCNode::gclite()
     if (s_inhibitor_count != 0)
 	return;
     GCInhibitor inhibitor;
+    ImmediateRefCounting immediate;
     GCStackRootBase::protectAll();
     ProtectStack::protectAll();
     ByteCode::protectAll();
@@ -220,9 +390,14 @@ void GCNode::gclite()
 	// Last in, first out, for cache efficiency:
 	const GCNode* node = s_moribund->back();
 	s_moribund->pop_back();
+	if (!node)
+	    continue;
 	unsigned char& rcmmu = node->m_rcmmu;
-	if ((rcmmu & s_refcount_mask) == 0)
-	    delete node;
+	if ((rcmmu & s_refcount_mask) == 0) {
+	    if (node->m_grey)
+		s_grey_moribund->push_back(node);
+	    else delete node;
+	}
 	// Clear moribund bit.  Beware ~ promotes to unsigned int.
 	else rcmmu &= static_cast<unsigned char>(~s_moribund_mask);
     }
@@ -231,9 +406,14 @@ void GCNode::gclite()
 
 void GCNode::initialize()
 {
-    static List live, reachable;
+    static List live, old, condemned, reachable;
     s_live = &live;
+    s_old = &old;
+    s_condemned = &condemned;
     s_reachable = &reachable;
+    static vector<const GCNode*> grey, grey_moribund;
+    s_grey = &grey;
+    s_grey_moribund = &grey_moribund;
     static vector<const GCNode*> moribund;
     s_moribund = &moribund;
     s_gclite_threshold = s_gclite_margin;
@@ -261,6 +441,240 @@ void GCNode::makeMoribund() const
     s_moribund->push_back(this);
 }
     
+size_t GCNode::markSome(size_t max_nodes)
+{
+    GreyMarker marker;
+    size_t count = 0;
+    while (count < max_nodes && !s_grey->empty()) {
+	const GCNode* node = s_grey->back();
+	s_grey->pop_back();
+	node->m_grey = false;
+	node->visitReferents(&marker);
+	++count;
+    }
+    return count;
+}
+
+#ifdef PARALLEL_MARK
+// The mark phase of a full garbage collection can be shared among the
+// calling thread and (n - 1) threads of the WorkerPool, which persist
+// from one collection to the next.  Each thread claims the nodes it
+// marks by an atomic compare-and-swap on m_rcmmu, and keeps a private
+// stack of claimed nodes whose referents are still to be visited.
+// While any thread is idle, a thread with more than a few nodes on
+// its stack moves the older half of them to its own deque, from
+// which idle threads steal.  Each deque has its own lock, so threads
+// contend only when one steals from another.
+//
+// A thread counts as busy while it may hold nodes still to be
+// visited.  A thread empties its own deque before ceasing to be
+// busy, and becomes busy again before it tries to steal, so once no
+// thread is busy no work remains anywhere, and the mark is complete.
+//
+// The threads do not themselves move the nodes they mark to
+// s_reachable, because list manipulation is not thread-safe: this is
+// done afterwards by moveMarkedToReachable().
+class GCNode::ParallelMarker {
+public:
+    explicit ParallelMarker(unsigned int num_threads);
+
+    // Mark all nodes reachable from the roots.  (Weak references are
+    // not processed.)
+    void markFromRoots();
+private:
+    // Each marking thread conducts one of these visitors around the
+    // graph:
+    class Worker : public const_visitor {
+    public:
+	Worker()
+	    : m_marker(0), m_lock(0), m_deque_size(0)
+	{}
+
+	// Visit the referents of nodes until no work remains.
+	void run();
+
+	// Virtual function of const_visitor:
+	void operator()(const GCNode* node)
+	{
+	    if (claim(node))
+		m_stack.push_back(node);
+	}
+
+	ParallelMarker* m_marker;
+	std::vector<const GCNode*> m_stack;  // Claimed nodes whose
+	  // referents are still to be visited.
+	std::deque<const GCNode*> m_deque;  // Further such nodes,
+	  // which other workers may steal.  Protected by m_lock.
+	volatile int m_lock;
+	volatile size_t m_deque_size;  // Size of m_deque, also read
+	  // without locking.
+    private:
+	// Called when m_stack is empty to find more work, stealing
+	// it if necessary.  Returns false if the mark is complete.
+	bool findWork();
+
+	void lock()
+	{
+	    while (__sync_lock_test_and_set(&m_lock, 1))
+		while (m_lock)
+		    ;
+	}
+
+	// Move the older half of m_stack to m_deque.
+	void share();
+
+	// Move nodes from the deque of 'victim' (which may be this
+	// Worker) to m_stack.  Returns false if there were none.
+	bool take(Worker* victim);
+
+	void unlock()
+	{
+	    __sync_lock_release(&m_lock);
+	}
+    };
+
+    static const size_t s_share_threshold;  // A busy worker shares
+      // work only if it has more than this number of nodes on its
+      // stack.
+    static const size_t s_take_max;  // Maximum number of nodes a
+      // worker takes from a deque at a time.
+
+    std::vector<Worker> m_workers;
+    volatile unsigned int m_num_busy;  // Number of busy workers.
+      // Changed atomically.
+
+    // Mark 'node' atomically, unless it is already marked.  Returns
+    // true iff this call marked it.
+    static bool claim(const GCNode* node);
+
+    // WorkerPool::Task running Worker number 'chunk':
+    static void runWorker(void* marker, size_t, size_t, unsigned int chunk);
+
+    // Not implemented:
+    ParallelMarker(const ParallelMarker&);
+    ParallelMarker& operator=(const ParallelMarker&);
+};
+
+const size_t GCNode::ParallelMarker::s_share_threshold = 16;
+const size_t GCNode::ParallelMarker::s_take_max = 256;
+
+GCNode::ParallelMarker::ParallelMarker(unsigned int num_threads)
+    : m_workers(num_threads), m_num_busy(0)
+{
+    for (unsigned int i = 0; i < num_threads; ++i)
+	m_workers[i].m_marker = this;
+}
+
+bool GCNode::ParallelMarker::claim(const GCNode* node)
+{
+    unsigned char rcmmu = node->m_rcmmu;
+    while ((rcmmu & s_mark_mask) != s_mark) {
+	// Beware ~ promotes to unsigned int.
+	unsigned char marked
+	    = static_cast<unsigned char>((rcmmu & ~s_mark_mask) | s_mark);
+	unsigned char prev
+	    = __sync_val_compare_and_swap(&node->m_rcmmu, rcmmu, marked);
+	if (prev == rcmmu)
+	    return true;
+	rcmmu = prev;
+    }
+    return false;
+}
+
+void GCNode::ParallelMarker::markFromRoots()
+{
+    Worker& first = m_workers[0];
+    GCRootBase::visitRoots(&first);
+    GCStackRootBase::visitRoots(&first);
+    ProtectStack::visitRoots(&first);
+    ByteCode::visitRoots(&first);
+    // The first worker, which holds the nodes referenced by the
+    // roots, is busy from the outset:
+    m_num_busy = 1;
+    WorkerPool::runEach(runWorker, this, m_workers.size());
+}
+
+void GCNode::ParallelMarker::runWorker(void* marker, size_t, size_t,
+				       unsigned int chunk)
+{
+    ParallelMarker* pm = static_cast<ParallelMarker*>(marker);
+    if (chunk != 0)
+	__sync_fetch_and_add(&pm->m_num_busy, 1);
+    pm->m_workers[chunk].run();
+}
+
+bool GCNode::ParallelMarker::Worker::findWork()
+{
+    // Reclaim any nodes that no other worker has stolen:
+    if (take(this))
+	return true;
+    vector<Worker>& workers = m_marker->m_workers;
+    size_t num_workers = workers.size();
+    size_t self = this - &workers[0];
+    __sync_fetch_and_sub(&m_marker->m_num_busy, 1);
+    while (m_marker->m_num_busy != 0) {
+	for (size_t i = 1; i < num_workers; ++i) {
+	    Worker* victim = &workers[(self + i)%num_workers];
+	    if (victim->m_deque_size != 0) {
+		__sync_fetch_and_add(&m_marker->m_num_busy, 1);
+		if (take(victim))
+		    return true;
+		__sync_fetch_and_sub(&m_marker->m_num_busy, 1);
+	    }
+	}
+	sched_yield();
+    }
+    return false;
+}
+
+void GCNode::ParallelMarker::Worker::run()
+{
+    do {
+	while (!m_stack.empty()) {
+	    const GCNode* node = m_stack.back();
+	    m_stack.pop_back();
+	    node->visitReferents(this);
+	    if (m_stack.size() > s_share_threshold && m_deque_size == 0
+		&& m_marker->m_num_busy < m_marker->m_workers.size())
+		share();
+	}
+    } while (findWork());
+}
+
+void GCNode::ParallelMarker::Worker::share()
+{
+    vector<const GCNode*>::iterator mid = m_stack.begin() + m_stack.size()/2;
+    lock();
+    m_deque.insert(m_deque.end(), m_stack.begin(), mid);
+    m_deque_size = m_deque.size();
+    unlock();
+    m_stack.erase(m_stack.begin(), mid);
+}
+
+bool GCNode::ParallelMarker::Worker::take(Worker* victim)
+{
+    if (victim->m_deque_size == 0)
+	return false;
+    victim->lock();
+    deque<const GCNode*>& dq = victim->m_deque;
+    size_t n;
+    if (victim == this) {
+	// Take the newest nodes:
+	n = min(dq.size(), s_take_max);
+	m_stack.insert(m_stack.end(), dq.end() - n, dq.end());
+	dq.erase(dq.end() - n, dq.end());
+    } else {
+	// Steal (up to) half, oldest first:
+	n = min((dq.size() + 1)/2, s_take_max);
+	m_stack.insert(m_stack.end(), dq.begin(), dq.begin() + n);
+	dq.erase(dq.begin(), dq.begin() + n);
+    }
+    victim->m_deque_size = dq.size();
+    victim->unlock();
+    return n > 0;
+}
+#endif  // PARALLEL_MARK
+
 void GCNode::mark()
 {
     // In the first mark-sweep collection, the marking of a node is
@@ -269,12 +683,89 @@ void GCNode::mark()
     // alternation.  This avoids the need for the sweep phase to
     // iterate through the surviving nodes simply to remove marks.
     s_mark ^= s_mark_mask;
-    GCNode::Marker marker;
+    // Both generations are subject to collection:
+    s_live->splice_back(s_old);
+#ifdef PARALLEL_MARK
+    if (s_mark_threads > 1 && s_num_nodes >= s_min_parallel_mark_nodes) {
+	ParallelMarker(s_mark_threads).markFromRoots();
+	moveMarkedToReachable();
+    } else
+#endif
+    {
+	GCNode::Marker marker;
+	GCRootBase::visitRoots(&marker);
+	GCStackRootBase::visitRoots(&marker);
+	ProtectStack::visitRoots(&marker);
+	ByteCode::visitRoots(&marker);
+    }
+    WeakRef::markThru();
+}
+
+void GCNode::minorGC()
+{
+    // Tally the references to each young node from other young
+    // nodes:
+    {
+	List::const_iterator end = s_live->end();
+	for (List::const_iterator it = s_live->begin(); it != end; ++it)
+	    (*it)->m_young_refs = 0;
+	YoungRefCounter counter;
+	for (List::const_iterator it = s_live->begin(); it != end; ++it)
+	    (*it)->visitReferents(&counter);
+    }
+    // A young node whose reference count exceeds this tally is
+    // referenced from outside the young generation (or its reference
+    // count has saturated), and so is a root for the minor
+    // collection.  These nodes are gathered before any marking
+    // starts, because marking moves nodes off s_live:
+    vector<const GCNode*> remembered;
+    {
+	List::const_iterator end = s_live->end();
+	for (List::const_iterator it = s_live->begin(); it != end; ++it) {
+	    const GCNode* node = *it;
+	    unsigned int refcount = node->m_rcmmu & s_refcount_mask;
+	    if (refcount == s_refcount_mask
+		|| (refcount >> 1) > node->m_young_refs)
+		remembered.push_back(node);
+	}
+    }
+    YoungMarker marker;
+    for (vector<const GCNode*>::const_iterator it = remembered.begin();
+	 it != remembered.end(); ++it)
+	marker(*it);
     GCRootBase::visitRoots(&marker);
     GCStackRootBase::visitRoots(&marker);
     ProtectStack::visitRoots(&marker);
     ByteCode::visitRoots(&marker);
-    WeakRef::markThru();
+    // Weak references are processed only by full collections; in a
+    // minor collection the GCEdges within a WeakRef keep their
+    // targets alive.
+
+    // Nodes remaining on s_live are unreachable:
+    List zombies;
+    while (!s_live->empty()) {
+	GCNode* node = s_live->front();
+	node->detachReferents();
+	zombies.splice_back(node);
+    }
+    s_old->splice_back(s_reachable);
+    gclite();
+}
+
+void GCNode::moveMarkedToReachable()
+{
+    List::const_iterator it = s_live->begin();
+    while (it != s_live->end()) {
+	const GCNode* node = *it;
+	++it;
+	if (node->isMarked()) {
+	    if (!node->m_old) {
+		node->m_old = true;
+		++s_num_old_nodes;
+	    }
+	    s_reachable->splice_back(node);
+	}
+    }
 }
 
 void GCNode::sweep()
@@ -304,8 +795,9 @@ void GCNode::sweep()
 	node->detachReferents();
 	zombies.splice_back(node);
     }
-    // Transfer the s_reachable list to the exposed list:
-    s_live->splice_back(s_reachable);
+    // The nodes on the s_reachable list have all been promoted to the
+    // old generation:
+    s_old->splice_back(s_reachable);
     // The preceding will have resulted in some nodes within
     // unreachable subgraphs getting transferred to the moribund list,
     // rather than being deleted immediately.  Now we clear up this detritus:
@@ -316,6 +808,19 @@ void GCNode::sweep()
     // automatically.
 }
 
+void GCNode::shade() const
+{
+    m_rcmmu &= static_cast<unsigned char>(~s_mark_mask);
+    m_rcmmu |= s_mark;
+    if (!m_old) {
+	m_old = true;
+	++s_num_old_nodes;
+    }
+    s_reachable->splice_back(this);
+    m_grey = true;
+    s_grey->push_back(this);
+}
+
 #ifdef GCID
 void GCNode::watch() const
 {
@@ -353,9 +858,23 @@ void GCNode::Marker::operator()(const GCNode* node)
     node->m_rcmmu &= static_cast<unsigned char>(~s_mark_mask);
     node->m_rcmmu |= s_mark;
     ++m_marks_applied;
+    if (!node->m_old) {
+	node->m_old = true;
+	++s_num_old_nodes;
+    }
     s_reachable->splice_back(node);
     node->visitReferents(this);
 #ifdef GC_FIND_LOOPS
     m_ariadne.pop_back();
 #endif
 }
+
+void GCNode::YoungMarker::operator()(const GCNode* node)
+{
+    if (node->m_old)
+	return;
+    node->m_old = true;
+    ++s_num_old_nodes;
+    s_reachable->splice_back(node);
+    node->visitReferents(this);
+}
@@ -48,6 +48,7 @@ using namespace CXXR;
 namespace CXXR {
     namespace ForceNonInline {
 	int* (*INTEGERp)(SEXP) = INTEGER;
+	const int* (*INTEGER_ROp)(SEXP) = INTEGER_RO;
     }
 }
 
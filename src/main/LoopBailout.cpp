@@ -44,18 +44,6 @@
 
 using namespace CXXR;
 
-void LoopBailout::detachReferents() {
-    m_environment.detach();
-    Bailout::detachReferents();
-}
-
 void LoopBailout::throwException() {
     throw LoopException(m_environment, m_next);
 }
-
-void LoopBailout::visitReferents(const_visitor* v) const
-{
-    Bailout::visitReferents(v);
-    if (m_environment)
-	(*v)(m_environment);
-}
@@ -39,9 +39,37 @@
 
 #include "CXXR/MemoryBank.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <limits>
 
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// Large objects are mapped directly from the operating system, except
+// when NO_CELLPOOLS is defined (see below):
+#if defined(HAVE_MMAP) && defined(HAVE_MUNMAP) && !defined(NO_CELLPOOLS)
+#define LARGE_OBJECTS
+#include <sys/mman.h>
+#include <unistd.h>
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+#if !defined(Win32) && !defined(HAVE_PTHREAD) \
+    && (defined(__APPLE__) || defined(_REENTRANT) || defined(HAVE_OPENMP))
+#define HAVE_PTHREAD
+#endif
+// ThreadCache uses POSIX threads and gcc's extensions for thread-local
+// storage and atomic operations:
+#if defined(HAVE_PTHREAD) && defined(__GNUC__)
+#define THREAD_CACHES
+#include <pthread.h>
+#endif
+
 using namespace std;
 using namespace CXXR;
 
@@ -56,14 +84,64 @@ const size_t MemoryBank::s_new_threshold = 0;
 const size_t MemoryBank::s_new_threshold = 193;
 #endif
 
+#ifdef LARGE_OBJECTS
+const size_t MemoryBank::s_large_threshold = 1 << 20;
+#else
+const size_t MemoryBank::s_large_threshold = numeric_limits<size_t>::max();
+#endif
+
+size_t MemoryBank::s_large_bytes = 0;
 size_t MemoryBank::s_blocks_allocated = 0;
 size_t MemoryBank::s_bytes_allocated = 0;
+void (*MemoryBank::s_sampler)(void*, size_t, unsigned int) = 0;
+size_t MemoryBank::s_sample_interval = 0;
+long MemoryBank::s_sample_countdown = numeric_limits<long>::max();
 #ifdef R_MEMORY_PROFILING
 void (*MemoryBank::s_monitor)(size_t) = 0;
 size_t MemoryBank::s_monitor_threshold = numeric_limits<size_t>::max();
 #endif
 
 MemoryBank::Pool* MemoryBank::s_pools;
+MemoryBank::Pool* MemoryBank::s_depot;
+unsigned int MemoryBank::s_num_thread_caches = 0;
+bool MemoryBank::s_thread_caches_used = false;
+long MemoryBank::s_foreign_blocks = 0;
+long MemoryBank::s_foreign_bytes = 0;
+const long MemoryBank::s_fold_bytes = 65536;
+
+#ifdef THREAD_CACHES
+namespace {
+    // ThreadCache currently in use by this thread, if any:
+    __thread MemoryBank::ThreadCache* t_cache = 0;
+
+    pthread_mutex_t depot_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+    // Lock the depot for the lifetime of this object:
+    class DepotLock {
+    public:
+	DepotLock()
+	{
+	    pthread_mutex_lock(&depot_mutex);
+	}
+
+	~DepotLock()
+	{
+	    pthread_mutex_unlock(&depot_mutex);
+	}
+    };
+}
+#endif
+
+#ifdef LARGE_OBJECTS
+namespace {
+    // Round up to a whole number of pages:
+    size_t pageRound(size_t bytes)
+    {
+	static const size_t pagesize = size_t(sysconf(_SC_PAGESIZE));
+	return (bytes + pagesize - 1) & ~(pagesize - 1);
+    }
+}
+#endif
 
 // Note that the C++ standard requires that an operator new returns a
 // valid pointer even when 0 bytes are requested.  The entry at
@@ -82,11 +160,17 @@ const unsigned char MemoryBank::s_pooltab[]
 
 void* MemoryBank::allocate(size_t bytes) throw (std::bad_alloc)
 {
+#ifdef THREAD_CACHES
+    if (s_num_thread_caches != 0 && t_cache)
+	return t_cache->allocate(bytes);
+#endif
 #ifdef R_MEMORY_PROFILING
     if (s_monitor && bytes >= s_monitor_threshold) s_monitor(bytes);
 #endif
     void* p;
-    if (bytes >= s_new_threshold)
+    if (bytes >= s_large_threshold)
+	p = allocateLarge(bytes);
+    else if (bytes >= s_new_threshold)
 	p = ::operator new(bytes);
     else {
 	Pool& pool = s_pools[s_pooltab[(bytes + 7) >> 3]];
@@ -94,28 +178,94 @@ void* MemoryBank::allocate(size_t bytes) throw (std::bad_alloc)
     }
     ++s_blocks_allocated;
     s_bytes_allocated += bytes;
+    if ((s_sample_countdown -= long(bytes)) < 0)
+	sample(p, bytes);
     return p;
 }
 
+void* MemoryBank::allocateLarge(size_t bytes) throw (std::bad_alloc)
+{
+#ifdef LARGE_OBJECTS
+    void* p = mmap(0, pageRound(bytes), PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+	throw bad_alloc();
+    // Large objects may also be allocated via a ThreadCache:
+#ifdef THREAD_CACHES
+    __sync_fetch_and_add(&s_large_bytes, bytes);
+#else
+    s_large_bytes += bytes;
+#endif
+    return p;
+#else
+    return ::operator new(bytes);
+#endif
+}
+
 void MemoryBank::check()
 {
+    // CellPool::check() requires each free cell to lie within one of
+    // the pool's own superblocks, which ceases to hold once cells
+    // have migrated between s_pools and s_depot:
+    if (s_thread_caches_used)
+	return;
     for (unsigned int i = 0; i < s_num_pools; ++i)
 	s_pools[i].check();
 }
 
+bool MemoryBank::deallocateInThreadCache(void* p, size_t bytes)
+{
+#ifdef THREAD_CACHES
+    if (t_cache) {
+	t_cache->deallocate(p, bytes);
+	return true;
+    }
+#endif
+    return false;
+}
+
+void MemoryBank::deallocateLarge(void* p, size_t bytes)
+{
+#ifdef LARGE_OBJECTS
+    munmap(p, pageRound(bytes));
+#ifdef THREAD_CACHES
+    __sync_fetch_and_sub(&s_large_bytes, bytes);
+#else
+    s_large_bytes -= bytes;
+#endif
+#else
+    ::operator delete(p);
+#endif
+}
+
 void MemoryBank::defragment()
 {
+#ifndef NO_CELLPOOLS
+    size_t released = 0;
     for (unsigned int i = 0; i < s_num_pools; ++i)
-	s_pools[i].defragment();
-}    
+	released += s_pools[i].defragment();
+#ifdef THREAD_CACHES
+    if (s_thread_caches_used) {
+	DepotLock lock;
+	for (unsigned int i = 0; i < s_num_pools; ++i)
+	    released += s_depot[i].defragment();
+    }
+#endif
+#ifdef __GLIBC__
+    // Superblocks released by the pools are returned only to the
+    // malloc arena; ask glibc to hand wholly free pages back to the
+    // operating system:
+    if (released > 0)
+	malloc_trim(0);
+#endif
+#endif
+}
 
-void MemoryBank::initialize()
+void MemoryBank::initializePools(Pool* pools)
 {
-#ifndef NO_CELLPOOLS
     // The following leave some space at the end of each 4096-byte
     // page, in case posix_memalign needs to put some housekeeping
     // information for the next page there.
-    static Pool pools[s_num_pools];
     pools[0].initialize(1, 511);
     pools[1].initialize(2, 255);
     pools[2].initialize(3, 170);
@@ -126,8 +276,74 @@ void MemoryBank::initialize()
     pools[7].initialize(12, 42);
     pools[8].initialize(16, 31);
     pools[9].initialize(24, 21);
+}
+
+void MemoryBank::initialize()
+{
+#ifndef NO_CELLPOOLS
+    static Pool pools[s_num_pools];
+    initializePools(pools);
     s_pools = pools;
+    static Pool depot[s_num_pools];
+    initializePools(depot);
+    s_depot = depot;
+#endif
+}
+
+void* MemoryBank::reallocate(void* p, size_t old_bytes, size_t new_bytes)
+    throw (std::bad_alloc)
+{
+#if defined(LARGE_OBJECTS) && defined(MREMAP_MAYMOVE)
+    bool own_tallies = true;  // False if using a ThreadCache.
+#ifdef THREAD_CACHES
+    own_tallies = (s_num_thread_caches == 0 || !t_cache);
+#endif
+    if (own_tallies && old_bytes >= s_large_threshold
+	&& new_bytes >= s_large_threshold) {
+	void* q = mremap(p, pageRound(old_bytes), pageRound(new_bytes),
+			 MREMAP_MAYMOVE);
+	if (q == MAP_FAILED)
+	    throw bad_alloc();
+#ifdef THREAD_CACHES
+	__sync_fetch_and_add(&s_large_bytes, new_bytes);
+	__sync_fetch_and_sub(&s_large_bytes, old_bytes);
+#else
+	s_large_bytes += new_bytes;
+	s_large_bytes -= old_bytes;
+#endif
+	s_bytes_allocated += new_bytes;
+	s_bytes_allocated -= old_bytes;
+	if (new_bytes > old_bytes
+	    && (s_sample_countdown -= long(new_bytes - old_bytes)) < 0)
+	    sample(q, new_bytes);
+	return q;
+    }
 #endif
+    void* q = allocate(new_bytes);
+    memcpy(q, p, std::min(old_bytes, new_bytes));
+    deallocate(p, old_bytes);
+    return q;
+}
+
+void MemoryBank::sample(void* p, size_t bytes)
+{
+    if (!s_sampler) {
+	s_sample_countdown = numeric_limits<long>::max();
+	return;
+    }
+    long interval = long(s_sample_interval);
+    unsigned int count = (-s_sample_countdown)/interval + 1;
+    s_sample_countdown += count*interval;
+    s_sampler(p, bytes, count);
+}
+
+void MemoryBank::setSampler(void (*sampler)(void*, size_t, unsigned int),
+			    size_t interval)
+{
+    s_sampler = sampler;
+    s_sample_interval = (sampler ? interval : 0);
+    s_sample_countdown = (sampler ? long(interval)
+			  : numeric_limits<long>::max());
 }
 
 #ifdef R_MEMORY_PROFILING
@@ -138,3 +354,121 @@ void MemoryBank::setMonitor(void (*monitor)(size_t), size_t threshold)
 	= (monitor ? threshold : numeric_limits<size_t>::max());
 }
 #endif
+
+// ***** Class MemoryBank::ThreadCache *****
+
+#ifdef THREAD_CACHES
+
+MemoryBank::ThreadCache::ThreadCache()
+    : m_blocks(0), m_bytes(0), m_previous(t_cache)
+{
+    for (unsigned int i = 0; i < s_num_pools; ++i) {
+	m_magazines[i].m_cells = 0;
+	m_magazines[i].m_count = 0;
+    }
+    t_cache = this;
+    s_thread_caches_used = true;
+    __sync_fetch_and_add(&s_num_thread_caches, 1);
+}
+
+MemoryBank::ThreadCache::~ThreadCache()
+{
+    {
+	DepotLock lock;
+	for (unsigned int i = 0; i < s_num_pools; ++i) {
+	    Magazine& mag = m_magazines[i];
+	    while (mag.m_cells) {
+		void* cell = mag.m_cells;
+		mag.m_cells = *static_cast<void**>(cell);
+		s_depot[i].deallocate(cell);
+	    }
+	}
+    }
+    fold();
+    t_cache = m_previous;
+    __sync_fetch_and_sub(&s_num_thread_caches, 1);
+}
+
+void* MemoryBank::ThreadCache::allocate(size_t bytes)
+{
+    void* p;
+    if (bytes >= s_large_threshold)
+	p = allocateLarge(bytes);
+    else if (bytes >= s_new_threshold)
+	p = ::operator new(bytes);
+    else {
+	unsigned int i = s_pooltab[(bytes + 7) >> 3];
+	Magazine& mag = m_magazines[i];
+	if (!mag.m_cells)
+	    replenish(i);
+	p = mag.m_cells;
+	mag.m_cells = *static_cast<void**>(p);
+	--mag.m_count;
+    }
+    tally(1, long(bytes));
+    return p;
+}
+
+void MemoryBank::ThreadCache::deallocate(void* p, size_t bytes)
+{
+    if (bytes >= s_large_threshold)
+	deallocateLarge(p, bytes);
+    else if (bytes >= s_new_threshold)
+	::operator delete(p);
+    else {
+	unsigned int i = s_pooltab[(bytes + 7) >> 3];
+	Magazine& mag = m_magazines[i];
+	*static_cast<void**>(p) = mag.m_cells;
+	mag.m_cells = p;
+	// Keep up to two superblocks' worth of cells:
+	if (++mag.m_count*s_depot[i].cellSize()
+	    > 2*s_depot[i].superblockSize())
+	    release(i);
+    }
+    tally(-1, -long(bytes));
+}
+
+void MemoryBank::ThreadCache::fold()
+{
+    __sync_fetch_and_add(&s_foreign_blocks, m_blocks);
+    __sync_fetch_and_add(&s_foreign_bytes, m_bytes);
+    m_blocks = m_bytes = 0;
+}
+
+void MemoryBank::ThreadCache::release(unsigned int pool)
+{
+    Pool& depot = s_depot[pool];
+    Magazine& mag = m_magazines[pool];
+    size_t n = depot.superblockSize()/depot.cellSize();
+    DepotLock lock;
+    for (size_t k = 0; k < n; ++k) {
+	void* cell = mag.m_cells;
+	mag.m_cells = *static_cast<void**>(cell);
+	depot.deallocate(cell);
+    }
+    mag.m_count -= n;
+}
+
+void MemoryBank::ThreadCache::replenish(unsigned int pool)
+{
+    Pool& depot = s_depot[pool];
+    Magazine& mag = m_magazines[pool];
+    size_t n = depot.superblockSize()/depot.cellSize();
+    DepotLock lock;
+    for (size_t k = 0; k < n; ++k) {
+	void* cell = depot.allocate();
+	*static_cast<void**>(cell) = mag.m_cells;
+	mag.m_cells = cell;
+	++mag.m_count;
+    }
+}
+
+#else  // THREAD_CACHES
+
+MemoryBank::ThreadCache::ThreadCache()
+{}
+
+MemoryBank::ThreadCache::~ThreadCache()
+{}
+
+#endif  // THREAD_CACHES
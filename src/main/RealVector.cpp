@@ -47,6 +47,7 @@ namespace CXXR {
     namespace ForceNonInline {
 	Rboolean (*isRealptr)(SEXP s) = Rf_isReal;
 	double* (*REALp)(SEXP) = REAL;
+	const double* (*REAL_ROp)(SEXP) = REAL_RO;
     }
 }
 
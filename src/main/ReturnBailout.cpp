@@ -45,7 +45,6 @@
 using namespace CXXR;
 
 void ReturnBailout::detachReferents() {
-    m_environment.detach();
     m_value.detach();
     Bailout::detachReferents();
 }
@@ -58,8 +57,6 @@ void ReturnBailout::throwException() {
 void ReturnBailout::visitReferents(const_visitor* v) const
 {
     Bailout::visitReferents(v);
-    if (m_environment)
-	(*v)(m_environment);
     if (m_value)
 	(*v)(m_value);
 }
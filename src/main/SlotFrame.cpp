@@ -0,0 +1,236 @@
+/*CXXR $Id$
+ *CXXR
+ *CXXR This file is part of CXXR, a project to refactor the R interpreter
+ *CXXR into C++.  It may consist in whole or in part of program code and
+ *CXXR documentation taken from the R project itself, incorporated into
+ *CXXR CXXR (and possibly MODIFIED) under the terms of the GNU General Public
+ *CXXR Licence.
+ *CXXR
+ *CXXR CXXR is Copyright (C) 2008-14 Andrew R. Runnalls, subject to such other
+ *CXXR copyrights and copyright restrictions as may be stated below.
+ *CXXR
+ *CXXR CXXR is not part of the R project, and bugs and other issues should
+ *CXXR not be reported via r-bugs or other R project channels; instead refer
+ *CXXR to the CXXR website.
+ *CXXR */
+
+/** @file SlotFrame.cpp
+ *
+ * @brief Implementation of class CXXR:SlotFrame.
+ */
+
+#include "CXXR/SlotFrame.hpp"
+
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/range/adaptor/filtered.hpp>
+#include <boost/range/adaptor/transformed.hpp>
+#include <boost/range/join.hpp>
+#include "CXXR/Expression.h"
+#include "CXXR/PairList.h"
+#include "CXXR/Symbol.h"
+
+using namespace std;
+using namespace CXXR;
+
+// ***** Class SlotFrame::Layout *****
+
+SlotFrame::Layout::Layout(const PairList* formals, const RObject* body)
+    : m_mask(0)
+{
+    for (const PairList* pl = formals; pl; pl = pl->tail())
+	addSymbol(static_cast<const Symbol*>(pl->tag()));
+    scan(body);
+    // Set up the hash table, keeping it at most half full:
+    size_t tabsize = 2;
+    while (tabsize < 2*m_symbols.size())
+	tabsize *= 2;
+    m_table.resize(tabsize, -1);
+    m_mask = tabsize - 1;
+    for (unsigned int s = 0; s < m_symbols.size(); ++s) {
+	size_t i = hash(m_symbols[s]);
+	while (m_table[i] >= 0)
+	    i = (i + 1) & m_mask;
+	m_table[i] = int(s);
+    }
+}
+
+void SlotFrame::Layout::addSymbol(const Symbol* symbol)
+{
+    if (symbol
+	&& find(m_symbols.begin(), m_symbols.end(), symbol) == m_symbols.end())
+	m_symbols.push_back(symbol);
+}
+
+void SlotFrame::Layout::scan(const RObject* expression)
+{
+    static const Symbol* assign_sym = Symbol::obtain("<-");
+    static const Symbol* equals_sym = Symbol::obtain("=");
+    static const Symbol* for_sym = Symbol::obtain("for");
+    static const Symbol* function_sym = Symbol::obtain("function");
+    static const Symbol* quote_sym = Symbol::obtain("quote");
+    const Expression* call = dynamic_cast<const Expression*>(expression);
+    if (!call)
+	return;
+    const RObject* fun = call->car();
+    const PairList* args = call->tail();
+    if (fun == function_sym || fun == quote_sym)
+	return;
+    if (args && (fun == assign_sym || fun == equals_sym || fun == for_sym)) {
+	// Find the Symbol ultimately assigned to, e.g. x in
+	// names(x)[2] <- "b":
+	const RObject* target = args->car();
+	const Expression* tcall;
+	while ((tcall = dynamic_cast<const Expression*>(target))
+	       && tcall->tail())
+	    target = tcall->tail()->car();
+	addSymbol(dynamic_cast<const Symbol*>(target));
+    }
+    scan(fun);
+    for (const PairList* pl = args; pl; pl = pl->tail())
+	scan(pl->car());
+}
+
+// ***** Class SlotFrame *****
+
+SlotFrame::SlotFrame(const Layout* layout)
+    : m_layout(layout), m_slots(layout->size()), m_overflow(0)
+{}
+
+SlotFrame::SlotFrame()
+    : m_layout(expose(new Layout(0, 0))), m_overflow(0)
+{}
+
+SlotFrame::SlotFrame(const SlotFrame& source)
+    : Frame(source), m_layout(source.m_layout), m_slots(source.m_slots),
+      m_overflow(source.m_overflow ? new Overflow(*source.m_overflow) : 0)
+{}
+
+Frame::Binding* SlotFrame::binding(const Symbol* symbol)
+{
+    int s = m_layout->slot(symbol);
+    if (s >= 0) {
+	Binding& bdg = m_slots[s];
+	return (bdg.frame() ? &bdg : 0);
+    }
+    if (!m_overflow)
+	return 0;
+    Overflow::iterator it = m_overflow->find(symbol);
+    if (it == m_overflow->end())
+	return 0;
+    return &(*it).second;
+}
+
+const Frame::Binding* SlotFrame::binding(const Symbol* symbol) const
+{
+    return const_cast<SlotFrame*>(this)->binding(symbol);
+}
+
+namespace {
+    bool isBound(const Frame::Binding& bdg)
+    {
+	return bdg.frame() != 0;
+    }
+}
+
+Frame::BindingRange SlotFrame::bindingRange() const
+{
+    boost::function<const Binding& (const Overflow::value_type&)> f
+	= boost::bind(&Overflow::value_type::second, _1);
+    const Overflow& overflow = (m_overflow ? *m_overflow : emptyOverflow());
+    return BindingRange(boost::join(m_slots, overflow
+				    | boost::adaptors::transformed(f))
+			| boost::adaptors::filtered(isBound));
+}
+
+SlotFrame* SlotFrame::clone() const
+{
+    return expose(new SlotFrame(*this));
+}
+
+void SlotFrame::detachReferents()
+{
+    m_layout.detach();
+    Frame::detachReferents();
+}
+
+const SlotFrame::Overflow& SlotFrame::emptyOverflow()
+{
+    static Overflow* empty = new Overflow;
+    return *empty;
+}
+
+void SlotFrame::lockBindings()
+{
+    for (Slots::iterator it = m_slots.begin(); it != m_slots.end(); ++it)
+	if ((*it).frame())
+	    (*it).setLocking(true);
+    if (m_overflow)
+	for (Overflow::iterator it = m_overflow->begin();
+	     it != m_overflow->end(); ++it)
+	    (*it).second.setLocking(true);
+}
+
+const GCNode* SlotFrame::shape() const
+{
+    // Overflow Bindings can be of any Symbol:
+    return (m_overflow ? 0 : m_layout.get());
+}
+
+size_t SlotFrame::size() const
+{
+    size_t ans = (m_overflow ? m_overflow->size() : 0);
+    for (Slots::const_iterator it = m_slots.begin(); it != m_slots.end(); ++it)
+	if ((*it).frame())
+	    ++ans;
+    return ans;
+}
+
+void SlotFrame::v_clear()
+{
+    for (Slots::iterator it = m_slots.begin(); it != m_slots.end(); ++it)
+	vacate(&(*it));
+    // Discard the overflow map, so that the Frame regains its
+    // shape():
+    delete m_overflow;
+    m_overflow = 0;
+}
+
+bool SlotFrame::v_erase(const Symbol* symbol)
+{
+    int s = m_layout->slot(symbol);
+    if (s >= 0) {
+	Binding& bdg = m_slots[s];
+	bool ans = (bdg.frame() != 0);
+	vacate(&bdg);
+	return ans;
+    }
+    return (m_overflow && m_overflow->erase(symbol));
+}
+
+Frame::Binding* SlotFrame::v_obtainBinding(const Symbol* symbol)
+{
+    int s = m_layout->slot(symbol);
+    if (s >= 0)
+	return &m_slots[s];
+    if (!m_overflow)
+	m_overflow = new Overflow;
+    return &(*m_overflow)[symbol];
+}
+
+void SlotFrame::vacate(Binding* bdg)
+{
+    bdg->~Binding();
+    new (bdg) Binding();
+}
+
+void SlotFrame::visitReferents(const_visitor* v) const
+{
+    const GCNode* layout = m_layout;
+    Frame::visitReferents(v);
+    if (layout)
+	(*v)(layout);
+}
+
+BOOST_CLASS_EXPORT_IMPLEMENT(CXXR::SlotFrame)
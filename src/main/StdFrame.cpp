@@ -40,10 +40,7 @@
 
 #include "CXXR/StdFrame.hpp"
 
-#include <cmath>
-#include <boost/bind.hpp>
-#include <boost/function.hpp>
-#include <boost/iterator/transform_iterator.hpp>
+#include <boost/range/adaptor/filtered.hpp>
 #include "localization.h"
 #include "R_ext/Error.h"
 #include "CXXR/GCStackRoot.hpp"
@@ -55,41 +52,43 @@ using namespace CXXR;
 
 // We want to be able to determine quickly if a symbol is *not*
 // defined in an frame, so that we can carry on working up the
-// chain of enclosing frames.  On average the number of tests
-// needed to determine that a symbol is not present is 1 + 2L, where L
-// is the load factor.  So we keep the load factor small:
-namespace {
-    const double maximum_load_factor = 0.5;
-}
-
+// chain of enclosing frames.  With linear probing, the expected
+// number of entries examined to determine that a symbol is not
+// present is about (1 + 1/(1 - L)^2)/2, where L is the load factor.
+// So we keep the load factor to at most 0.5:
 StdFrame::StdFrame(size_t initial_capacity)
-  : m_map(size_t(ceil(double(initial_capacity)/maximum_load_factor)))
+    : m_entries(0), m_shift(0)
 {
-    m_map.max_load_factor(maximum_load_factor);
+    size_t capacity = 2;
+    while (capacity < 2*initial_capacity)
+	capacity *= 2;
+    rehash(capacity);
 }
 
 Frame::Binding* StdFrame::binding(const Symbol* symbol)
 {
-    map::iterator it = m_map.find(symbol);
-    if (it == m_map.end())
+    const Entry& entry = m_table[find(symbol)];
+    if (!entry.m_symbol)
 	return 0;
-    return &(*it).second;
+    Binding& bdg = m_slots[entry.m_slot];
+    return (bdg.frame() ? &bdg : 0);
 }
 
 const Frame::Binding* StdFrame::binding(const Symbol* symbol) const
 {
-    map::const_iterator it = m_map.find(symbol);
-    if (it == m_map.end())
-	return 0;
-    return &(*it).second;
+    return const_cast<StdFrame*>(this)->binding(symbol);
+}
+
+namespace {
+    bool isBound(const Frame::Binding& bdg)
+    {
+	return bdg.frame() != 0;
+    }
 }
 
 Frame::BindingRange StdFrame::bindingRange() const
 {
-    boost::function<const Binding& (const map::value_type&)> f
-	= boost::bind(&map::value_type::second, _1);
-    return BindingRange(boost::make_transform_iterator(m_map.begin(), f),
-			boost::make_transform_iterator(m_map.end(), f));
+    return BindingRange(m_slots | boost::adaptors::filtered(isBound));
 }
 
 StdFrame* StdFrame::clone() const
@@ -99,28 +98,90 @@ StdFrame* StdFrame::clone() const
 
 void StdFrame::lockBindings()
 {
-    for (map::iterator it = m_map.begin(); it != m_map.end(); ++it)
-	(*it).second.setLocking(true);
+    for (Slots::iterator it = m_slots.begin(); it != m_slots.end(); ++it)
+	if ((*it).frame())
+	    (*it).setLocking(true);
+}
+
+void StdFrame::rehash(size_t capacity)
+{
+    vector<Entry> old_table(capacity);
+    old_table.swap(m_table);
+    m_shift = 8*sizeof(size_t);
+    for (size_t n = capacity; n > 1; n /= 2)
+	--m_shift;
+    for (vector<Entry>::const_iterator it = old_table.begin();
+	 it != old_table.end(); ++it)
+	if ((*it).m_symbol)
+	    m_table[find((*it).m_symbol)] = *it;
 }
 
 size_t StdFrame::size() const
 {
-    return m_map.size();
+    return m_slots.size() - m_vacated.size();
 }
 
 void StdFrame::v_clear()
 {
-    m_map.clear();
+    m_slots.clear();
+    m_vacated.clear();
+    vector<Entry>(m_table.size()).swap(m_table);
+    m_entries = 0;
 }
 
 bool StdFrame::v_erase(const Symbol* symbol)
 {
-    return m_map.erase(symbol);
+    size_t i = find(symbol);
+    if (!m_table[i].m_symbol)
+	return false;
+    unsigned int slot = m_table[i].m_slot;
+    Binding& bdg = m_slots[slot];
+    bool ans = (bdg.frame() != 0);
+    bdg.~Binding();
+    new (&bdg) Binding();
+    m_vacated.push_back(slot);
+    // Close up the gap in the probe sequence, so that no deletion
+    // markers are needed:
+    size_t mask = m_table.size() - 1;
+    size_t j = i;
+    while (true) {
+	j = (j + 1) & mask;
+	const Symbol* sym = m_table[j].m_symbol;
+	if (!sym)
+	    break;
+	// Move entry j into the gap unless its home position lies
+	// cyclically in (i, j]:
+	size_t home = hash(sym);
+	if (((j - home) & mask) >= ((j - i) & mask)) {
+	    m_table[i] = m_table[j];
+	    i = j;
+	}
+    }
+    m_table[i] = Entry();
+    --m_entries;
+    return ans;
 }
 
 Frame::Binding* StdFrame::v_obtainBinding(const Symbol* symbol)
 {
-    return &m_map[symbol];
+    size_t i = find(symbol);
+    if (m_table[i].m_symbol)
+	return &m_slots[m_table[i].m_slot];
+    if (2*(m_entries + 1) > m_table.size()) {
+	rehash(2*m_table.size());
+	i = find(symbol);
+    }
+    Entry& entry = m_table[i];
+    entry.m_symbol = symbol;
+    if (m_vacated.empty()) {
+	entry.m_slot = (unsigned int)(m_slots.size());
+	m_slots.push_back(Binding());
+    } else {
+	entry.m_slot = m_vacated.back();
+	m_vacated.pop_back();
+    }
+    ++m_entries;
+    return &m_slots[entry.m_slot];
 }
 
 BOOST_CLASS_EXPORT_IMPLEMENT(CXXR::StdFrame)
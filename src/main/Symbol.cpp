@@ -79,7 +79,8 @@ namespace {
 // ***** Class Symbol itself *****
 
 Symbol::Symbol(const String* the_name)
-    : RObject(SYMSXP), m_name(the_name), m_dd_index(0)
+    : RObject(SYMSXP), m_name(the_name), m_dd_index(0),
+      m_lookup_watched(false)
 {
     if (m_name) {
 	if (m_name->size() == 0)
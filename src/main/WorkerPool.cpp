@@ -0,0 +1,224 @@
+/*CXXR $Id$
+ *CXXR
+ *CXXR This file is part of CXXR, a project to refactor the R interpreter
+ *CXXR into C++.  It may consist in whole or in part of program code and
+ *CXXR documentation taken from the R project itself, incorporated into
+ *CXXR CXXR (and possibly MODIFIED) under the terms of the GNU General Public
+ *CXXR Licence.
+ *CXXR
+ *CXXR CXXR is Copyright (C) 2008-14 Andrew R. Runnalls, subject to such other
+ *CXXR copyrights and copyright restrictions as may be stated below.
+ *CXXR
+ *CXXR CXXR is not part of the R project, and bugs and other issues should
+ *CXXR not be reported via r-bugs or other R project channels; instead refer
+ *CXXR to the CXXR website.
+ *CXXR */
+
+/** @file WorkerPool.cpp
+ *
+ * Implementation of class WorkerPool.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "CXXR/WorkerPool.hpp"
+
+#include <algorithm>
+
+#if !defined(Win32) && !defined(HAVE_PTHREAD) \
+    && (defined(__APPLE__) || defined(_REENTRANT) || defined(HAVE_OPENMP))
+#define HAVE_PTHREAD
+#endif
+// The pool uses POSIX threads and gcc's atomic builtins:
+#if defined(HAVE_PTHREAD) && defined(__GNUC__)
+#define WORKER_POOL
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+using namespace std;
+using namespace CXXR;
+
+const size_t WorkerPool::s_min_chunk = 32768;
+
+#ifdef WORKER_POOL
+namespace {
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;  // Signalled
+      // when a job is posted.
+    pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;  // Signalled
+      // when the last chunk of a job is complete, or the last
+      // thread leaves a job.
+
+    unsigned int num_threads = 0;  // Number of pool threads created.
+
+    // The current job.  These are written only by run(), with mutex
+    // held and no pool thread active:
+    WorkerPool::Task job_task;
+    void* job_data;
+    size_t job_size;
+    size_t job_chunk_size;
+    unsigned int job_chunks;
+    unsigned long job_number = 0;  // Incremented for each job posted.
+
+    volatile unsigned int next_chunk;  // Claimed atomically.
+    volatile unsigned int chunks_done;  // Incremented atomically.
+    unsigned int num_active = 0;  // Pool threads that have joined the
+      // current job and not yet left it; protected by mutex.
+
+    // Claim and process chunks of the current job until none
+    // remain:
+    void work()
+    {
+	unsigned int chunk;
+	while ((chunk = __sync_fetch_and_add(&next_chunk, 1)) < job_chunks) {
+	    size_t begin = chunk*job_chunk_size;
+	    size_t end = min(begin + job_chunk_size, job_size);
+	    job_task(job_data, begin, end, chunk);
+	    if (__sync_add_and_fetch(&chunks_done, 1) == job_chunks) {
+		pthread_mutex_lock(&mutex);
+		pthread_cond_broadcast(&done_cond);
+		pthread_mutex_unlock(&mutex);
+	    }
+	}
+    }
+
+    void* threadMain(void*)
+    {
+	unsigned long last_job = 0;
+	pthread_mutex_lock(&mutex);
+	while (true) {
+	    while (job_number == last_job)
+		pthread_cond_wait(&work_cond, &mutex);
+	    last_job = job_number;
+	    ++num_active;
+	    pthread_mutex_unlock(&mutex);
+	    work();
+	    pthread_mutex_lock(&mutex);
+	    if (--num_active == 0)
+		pthread_cond_broadcast(&done_cond);
+	}
+	return 0;
+    }
+
+    // A child process created by fork() (e.g. by package parallel)
+    // inherits none of the pool threads, so the pool is emptied in
+    // the child.  The mutex is held across the fork so that the
+    // child inherits it in a consistent state:
+    void prepareFork()
+    {
+	pthread_mutex_lock(&mutex);
+    }
+
+    void parentAfterFork()
+    {
+	pthread_mutex_unlock(&mutex);
+    }
+
+    void childAfterFork()
+    {
+	num_threads = 0;
+	num_active = 0;
+	pthread_mutex_unlock(&mutex);
+    }
+
+    // Top up the pool to n threads, which are started with all
+    // signals blocked, so that signals continue to be handled by the
+    // main thread:
+    void createThreads(unsigned int n)
+    {
+	if (num_threads >= n)
+	    return;
+	static bool fork_handlers = false;
+	if (!fork_handlers) {
+	    pthread_atfork(prepareFork, parentAfterFork, childAfterFork);
+	    fork_handlers = true;
+	}
+	sigset_t all, saved;
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &saved);
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	while (num_threads < n) {
+	    pthread_t thread;
+	    if (pthread_create(&thread, &attr, threadMain, 0) != 0)
+		break;
+	    ++num_threads;
+	}
+	pthread_attr_destroy(&attr);
+	pthread_sigmask(SIG_SETMASK, &saved, 0);
+    }
+
+    // Process a job of n elements, divided into the specified number
+    // of chunks of chunk_size elements (the last possibly shorter):
+    void runJob(WorkerPool::Task task, void* data, size_t n,
+		size_t chunk_size, unsigned int chunks)
+    {
+	pthread_mutex_lock(&mutex);
+	createThreads(chunks - 1);
+	// Pool threads still finishing with the previous job (which
+	// may only now have woken up to it) must leave it before it
+	// is replaced:
+	while (num_active > 0)
+	    pthread_cond_wait(&done_cond, &mutex);
+	job_task = task;
+	job_data = data;
+	job_size = n;
+	job_chunk_size = chunk_size;
+	job_chunks = chunks;
+	next_chunk = 0;
+	chunks_done = 0;
+	++job_number;
+	pthread_cond_broadcast(&work_cond);
+	pthread_mutex_unlock(&mutex);
+	// The calling thread takes its share, and then waits for any
+	// chunks still in progress on the pool threads:
+	work();
+	pthread_mutex_lock(&mutex);
+	while (chunks_done < chunks)
+	    pthread_cond_wait(&done_cond, &mutex);
+	pthread_mutex_unlock(&mutex);
+    }
+}
+#endif
+
+unsigned int WorkerPool::numChunks(size_t n, unsigned int max_threads)
+{
+#ifdef WORKER_POOL
+    size_t ans = min(size_t(max_threads), n/s_min_chunk);
+    return (ans > 1 ? (unsigned int)(ans) : 1);
+#else
+    return 1;
+#endif
+}
+
+void WorkerPool::run(Task task, void* data, size_t n,
+		     unsigned int max_threads, size_t granularity)
+{
+    unsigned int chunks = numChunks(n, max_threads);
+    if (chunks == 1) {
+	task(data, 0, n, 0);
+	return;
+    }
+#ifdef WORKER_POOL
+    size_t chunk_size = (n + chunks - 1)/chunks;
+    chunk_size = ((chunk_size + granularity - 1)/granularity)*granularity;
+    chunks = (unsigned int)((n + chunk_size - 1)/chunk_size);
+    runJob(task, data, n, chunk_size, chunks);
+#endif
+}
+
+void WorkerPool::runEach(Task task, void* data, unsigned int num_tasks)
+{
+#ifdef WORKER_POOL
+    if (num_tasks > 1) {
+	runJob(task, data, num_tasks, 1, num_tasks);
+	return;
+    }
+#endif
+    for (unsigned int i = 0; i < num_tasks; ++i)
+	task(data, i, i + 1, i);
+}
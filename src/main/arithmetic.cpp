@@ -45,7 +45,10 @@
 #include <config.h>
 #endif
 
+#include <algorithm>
+#include <functional>
 #include <limits>
+#include <vector>
 
 /* interval at which to check interrupts, a guess */
 #define NINTERRUPT 10000000
@@ -84,6 +87,8 @@ extern "C" {
 #include "CXXR/BinaryFunction.hpp"
 #include "CXXR/GCStackRoot.hpp"
 #include "CXXR/UnaryFunction.hpp"
+#include "CXXR/VectorKernels.hpp"
+#include "CXXR/WorkerPool.hpp"
 
 using namespace CXXR;
 using namespace VectorOps;
@@ -382,6 +387,33 @@ namespace {
 	}
 	return static_cast<VectorBase*>(v);
     }
+
+    // Obtain a vector to receive the result of a binary arithmetic
+    // operation.  If one of the operands is a temporary (i.e. NAMED
+    // is 0) of the result's type and length, and has no attributes,
+    // its storage is reused for the result: this avoids allocating a
+    // fresh vector for each intermediate of an expression such as
+    // a*x + b*y - c.  The element loops of real_binary() and
+    // integer_binary() read each element of a full-length operand
+    // before writing the corresponding element of the result, so
+    // the result may safely overwrite such an operand.
+    SEXP allocResult(SEXPTYPE type, R_xlen_t n, SEXP s1, SEXP s2)
+    {
+	if (TYPEOF(s1) == type && XLENGTH(s1) == n
+	    && NAMED(s1) == 0 && ATTRIB(s1) == R_NilValue)
+	    return s1;
+	if (TYPEOF(s2) == type && XLENGTH(s2) == n
+	    && NAMED(s2) == 0 && ATTRIB(s2) == R_NilValue)
+	    return s2;
+	return allocVector(type, n);
+    }
+
+    // Maximum number of threads to be used for element-wise
+    // operations on long vectors, as set by setNumMathThreads():
+    unsigned int mathThreads()
+    {
+	return (R_num_math_threads > 1 ? R_num_math_threads : 1);
+    }
 }
 
 SEXP attribute_hidden R_binary(SEXP call, SEXP op, SEXP xarg, SEXP yarg)
@@ -660,12 +692,111 @@ namespace {
 #define INTEGER_OVERFLOW_WARNING _("NAs produced by integer overflow")
 #endif
 
+namespace {
+    // Integer addition, subtraction and multiplication.  Each of
+    // these yields NA if either operand is NA, and also yields NA,
+    // setting *naflag, on overflow.
+    struct IntegerPlus {
+	int operator()(int x1, int x2, bool* naflag) const
+	{
+	    if (x1 == NA_INTEGER || x2 == NA_INTEGER)
+		return NA_INTEGER;
+	    int val = x1 + x2;
+	    if (val != NA_INTEGER && GOODISUM(x1, x2, val))
+		return val;
+	    *naflag = true;
+	    return NA_INTEGER;
+	}
+    };
+
+    struct IntegerMinus {
+	int operator()(int x1, int x2, bool* naflag) const
+	{
+	    if (x1 == NA_INTEGER || x2 == NA_INTEGER)
+		return NA_INTEGER;
+	    int val = x1 - x2;
+	    if (val != NA_INTEGER && GOODIDIFF(x1, x2, val))
+		return val;
+	    *naflag = true;
+	    return NA_INTEGER;
+	}
+    };
+
+    struct IntegerTimes {
+	int operator()(int x1, int x2, bool* naflag) const
+	{
+	    if (x1 == NA_INTEGER || x2 == NA_INTEGER)
+		return NA_INTEGER;
+	    int val = x1 * x2;
+	    if (val != NA_INTEGER && GOODIPROD(x1, x2, val))
+		return val;
+	    *naflag = true;
+	    return NA_INTEGER;
+	}
+    };
+
+    // Operands and result of an integer operation, with an overflow
+    // flag for each chunk processed by the WorkerPool:
+    struct IntegerArithmeticData {
+	int* out;
+	const int* x;
+	R_xlen_t n1;
+	const int* y;
+	R_xlen_t n2;
+	std::vector<char> naflags;
+    };
+
+    // WorkerPool::Task for operands of equal length, or of which at
+    // least one is of length 1:
+    template <class Op>
+    void integerArithmeticChunk(void* data, size_t begin, size_t end,
+				unsigned int chunk)
+    {
+	IntegerArithmeticData* d = static_cast<IntegerArithmeticData*>(data);
+	Op op;
+	bool naflag = false;
+	const R_xlen_t xstep = (d->n1 == 1 ? 0 : 1);
+	const R_xlen_t ystep = (d->n2 == 1 ? 0 : 1);
+	for (R_xlen_t i = begin; i < R_xlen_t(end); ++i)
+	    d->out[i] = op(d->x[i*xstep], d->y[i*ystep], &naflag);
+	d->naflags[chunk] = naflag;
+    }
+
+    // Apply Op to integer operands of lengths n1 and n2 (neither
+    // zero), writing n elements to out, and return true if any
+    // overflow occurred.  Long vectors are processed in parallel if
+    // setNumMathThreads() allows.
+    template <class Op>
+    bool integerArithmetic(int* out, const int* x, R_xlen_t n1,
+			   const int* y, R_xlen_t n2, R_xlen_t n)
+    {
+	if (n1 != n2 && n1 != 1 && n2 != 1) {
+	    Op op;
+	    bool naflag = false;
+	    R_xlen_t i, i1, i2;
+	    mod_iterate(n1, n2, i1, i2) {
+		out[i] = op(x[i1], y[i2], &naflag);
+	    }
+	    return naflag;
+	}
+	IntegerArithmeticData data;
+	data.out = out;
+	data.x = x;
+	data.n1 = n1;
+	data.y = y;
+	data.n2 = n2;
+	data.naflags.resize(WorkerPool::numChunks(n, mathThreads()));
+	WorkerPool::run(integerArithmeticChunk<Op>, &data, n, mathThreads());
+	return (std::find(data.naflags.begin(), data.naflags.end(), true)
+		!= data.naflags.end());
+    }
+}
+
 static SEXP integer_binary(ARITHOP_TYPE code, SEXP s1, SEXP s2, SEXP lcall)
 {
     R_xlen_t i, i1, i2, n, n1, n2;
     int x1, x2;
     SEXP ans;
-    Rboolean naflag = FALSE;
 
     n1 = XLENGTH(s1);
     n2 = XLENGTH(s2);
@@ -673,71 +804,26 @@ static SEXP integer_binary(ARITHOP_TYPE code, SEXP s1, SEXP s2, SEXP lcall)
     if (n1 == 0 || n2 == 0) n = 0; else n = (n1 > n2) ? n1 : n2;
 
     if (code == DIVOP || code == POWOP)
-	ans = allocVector(REALSXP, n);
+	ans = allocResult(REALSXP, n, s1, s2);
     else
-	ans = allocVector(INTSXP, n);
+	ans = allocResult(INTSXP, n, s1, s2);
     if (n1 == 0 || n2 == 0) return(ans);
     PROTECT(ans);
 
     switch (code) {
     case PLUSOP:
-	mod_iterate(n1, n2, i1, i2) {
-//	    if ((i+1) % NINTERRUPT == 0) R_CheckUserInterrupt();
-	    x1 = INTEGER(s1)[i1];
-	    x2 = INTEGER(s2)[i2];
-	    if (x1 == NA_INTEGER || x2 == NA_INTEGER)
-		INTEGER(ans)[i] = NA_INTEGER;
-	    else {
-		int val = x1 + x2;
-		if (val != NA_INTEGER && GOODISUM(x1, x2, val))
-		    INTEGER(ans)[i] = val;
-		else {
-		    INTEGER(ans)[i] = NA_INTEGER;
-		    naflag = TRUE;
-		}
-	    }
-	}
-	if (naflag)
+	if (integerArithmetic<IntegerPlus>(INTEGER(ans), INTEGER(s1), n1,
+					   INTEGER(s2), n2, n))
 	    warningcall(lcall, INTEGER_OVERFLOW_WARNING);
 	break;
     case MINUSOP:
-	mod_iterate(n1, n2, i1, i2) {
-//	    if ((i+1) % NINTERRUPT == 0) R_CheckUserInterrupt();
-	    x1 = INTEGER(s1)[i1];
-	    x2 = INTEGER(s2)[i2];
-	    if (x1 == NA_INTEGER || x2 == NA_INTEGER)
-		INTEGER(ans)[i] = NA_INTEGER;
-	    else {
-		int val = x1 - x2;
-		if (val != NA_INTEGER && GOODIDIFF(x1, x2, val))
-		    INTEGER(ans)[i] = val;
-		else {
-		    naflag = TRUE;
-		    INTEGER(ans)[i] = NA_INTEGER;
-		}
-	    }
-	}
-	if (naflag)
+	if (integerArithmetic<IntegerMinus>(INTEGER(ans), INTEGER(s1), n1,
+					    INTEGER(s2), n2, n))
 	    warningcall(lcall, INTEGER_OVERFLOW_WARNING);
 	break;
     case TIMESOP:
-	mod_iterate(n1, n2, i1, i2) {
-//	    if ((i+1) % NINTERRUPT == 0) R_CheckUserInterrupt();
-	    x1 = INTEGER(s1)[i1];
-	    x2 = INTEGER(s2)[i2];
-	    if (x1 == NA_INTEGER || x2 == NA_INTEGER)
-		INTEGER(ans)[i] = NA_INTEGER;
-	    else {
-		int val = x1 * x2;
-		if (val != NA_INTEGER && GOODIPROD(x1, x2, val))
-		    INTEGER(ans)[i] = val;
-		else {
-		    naflag = TRUE;
-		    INTEGER(ans)[i] = NA_INTEGER;
-		}
-	    }
-	}
-	if (naflag)
+	if (integerArithmetic<IntegerTimes>(INTEGER(ans), INTEGER(s1), n1,
+					    INTEGER(s2), n2, n))
 	    warningcall(lcall, INTEGER_OVERFLOW_WARNING);
 	break;
     case DIVOP:
@@ -819,6 +905,57 @@ namespace {
     }
 }
 
+namespace {
+    // Operands and result of a real operation:
+    struct RealArithmeticData {
+	double* out;
+	const double* x;
+	R_xlen_t n1;
+	const double* y;
+	R_xlen_t n2;
+    };
+
+    // WorkerPool::Task for operands of equal length, or of which at
+    // least one is of length 1:
+    template <class Op>
+    void realArithmeticChunk(void* data, size_t begin, size_t end,
+			     unsigned int)
+    {
+	using namespace VectorOps;
+	RealArithmeticData* d = static_cast<RealArithmeticData*>(data);
+	size_t len = end - begin;
+	if (d->n1 == 1)
+	    Kernels::map<Kernels::RealArithmetic<Op> >(d->out + begin,
+						       d->x, 1,
+						       d->y + begin, len);
+	else if (d->n2 == 1)
+	    Kernels::map<Kernels::RealArithmetic<Op> >(d->out + begin,
+						       d->x + begin, len,
+						       d->y, 1);
+	else Kernels::map<Kernels::RealArithmetic<Op> >(d->out + begin,
+							d->x + begin, len,
+							d->y + begin, len);
+    }
+
+    // Apply Op to real operands of lengths n1 and n2, which must
+    // either be equal or include 1, writing the result to out.  Long
+    // vectors are processed in parallel if setNumMathThreads()
+    // allows.
+    template <class Op>
+    void realArithmetic(double* out, const double* x, R_xlen_t n1,
+			const double* y, R_xlen_t n2)
+    {
+	RealArithmeticData data;
+	data.out = out;
+	data.x = x;
+	data.n1 = n1;
+	data.y = y;
+	data.n2 = n2;
+	WorkerPool::run(realArithmeticChunk<Op>, &data, std::max(n1, n2),
+			mathThreads());
+    }
+}
+
 static SEXP real_binary(ARITHOP_TYPE code, SEXP s1, SEXP s2)
 {
     R_xlen_t i, i1, i2, n, n1, n2;
@@ -832,24 +969,14 @@ static SEXP real_binary(ARITHOP_TYPE code, SEXP s1, SEXP s2)
     if (n1 == 0 || n2 == 0) return(allocVector(REALSXP, 0));
 
     n = (n1 > n2) ? n1 : n2;
-    PROTECT(ans = allocVector(REALSXP, n));
+    PROTECT(ans = allocResult(REALSXP, n, s1, s2));
 
     switch (code) {
     case PLUSOP:
 	if(TYPEOF(s1) == REALSXP && TYPEOF(s2) == REALSXP) {
-            if (n2 == 1) {
-                double tmp = REAL(s2)[0];
-                for (i = 0; i < n; i++)
-		    REAL(ans)[i] = REAL(s1)[i] + tmp;
-            }
-            else if (n1 == 1) {
-                double tmp = REAL(s1)[0];
-                for (i = 0; i < n; i++)
-		    REAL(ans)[i] = tmp + REAL(s2)[i];
-            }
-            else if (n1 == n2)
-                for (i = 0; i < n; i++)
-		    REAL(ans)[i] = REAL(s1)[i] + REAL(s2)[i];
+            if (n1 == n2 || n1 == 1 || n2 == 1)
+		realArithmetic<std::plus<double> >(REAL(ans), REAL(s1), n1,
+						   REAL(s2), n2);
             else
                 mod_iterate(n1, n2, i1, i2) {
 //		    if ((i+1) % NINTERRUPT == 0) R_CheckUserInterrupt();
@@ -869,19 +996,9 @@ static SEXP real_binary(ARITHOP_TYPE code, SEXP s1, SEXP s2)
 	break;
     case MINUSOP:
 	if(TYPEOF(s1) == REALSXP && TYPEOF(s2) == REALSXP) {
-            if (n2 == 1) {
-                double tmp = REAL(s2)[0];
-                for (i = 0; i < n; i++)
-		    REAL(ans)[i] = REAL(s1)[i] - tmp;
-            }
-            else if (n1 == 1) {
-                double tmp = REAL(s1)[0];
-                for (i = 0; i < n; i++)
-		    REAL(ans)[i] = tmp - REAL(s2)[i];
-            }
-            else if (n1 == n2)
-                for (i = 0; i < n; i++)
-		    REAL(ans)[i] = REAL(s1)[i] - REAL(s2)[i];
+            if (n1 == n2 || n1 == 1 || n2 == 1)
+		realArithmetic<std::minus<double> >(REAL(ans), REAL(s1), n1,
+						    REAL(s2), n2);
             else
                 mod_iterate(n1, n2, i1, i2) {
 //		    if ((i+1) % NINTERRUPT == 0) R_CheckUserInterrupt();
@@ -901,19 +1018,9 @@ static SEXP real_binary(ARITHOP_TYPE code, SEXP s1, SEXP s2)
 	break;
     case TIMESOP:
 	if(TYPEOF(s1) == REALSXP && TYPEOF(s2) == REALSXP) {
-            if (n2 == 1) {
-                double tmp = REAL(s2)[0];
-                for (i = 0; i < n; i++)
-		    REAL(ans)[i] = REAL(s1)[i] * tmp;
-            }
-            else if (n1 == 1) {
-                double tmp = REAL(s1)[0];
-                for (i = 0; i < n; i++)
-		    REAL(ans)[i] = tmp * REAL(s2)[i];
-            }
-            else if (n1 == n2)
-                for (i = 0; i < n; i++)
-		    REAL(ans)[i] = REAL(s1)[i] * REAL(s2)[i];
+            if (n1 == n2 || n1 == 1 || n2 == 1)
+		realArithmetic<std::multiplies<double> >(REAL(ans), REAL(s1), n1,
+							 REAL(s2), n2);
             else
                 mod_iterate(n1, n2, i1, i2) {
 //		    if ((i+1) % NINTERRUPT == 0) R_CheckUserInterrupt();
@@ -933,19 +1040,9 @@ static SEXP real_binary(ARITHOP_TYPE code, SEXP s1, SEXP s2)
 	break;
     case DIVOP:
 	if(TYPEOF(s1) == REALSXP && TYPEOF(s2) == REALSXP) {
-            if (n2 == 1) {
-                double tmp = REAL(s2)[0];
-                for (i = 0; i < n; i++)
-		    REAL(ans)[i] = REAL(s1)[i] / tmp;
-            }
-            else if (n1 == 1) {
-                double tmp = REAL(s1)[0];
-                for (i = 0; i < n; i++)
-		    REAL(ans)[i] = tmp / REAL(s2)[i];
-            }
-            else if (n1 == n2)
-                for (i = 0; i < n; i++)
-		    REAL(ans)[i] = REAL(s1)[i] / REAL(s2)[i];
+            if (n1 == n2 || n1 == 1 || n2 == 1)
+		realArithmetic<std::divides<double> >(REAL(ans), REAL(s1), n1,
+						      REAL(s2), n2);
             else
                 mod_iterate(n1, n2, i1, i2) {
 //		    if ((i+1) % NINTERRUPT == 0) R_CheckUserInterrupt();
@@ -1079,6 +1176,13 @@ public:
 	return ans;
     }
 
+    // Take account of NaNs noted by another NaNWarner, e.g. one
+    // that has processed a different chunk of the same vector:
+    void merge(const NaNWarner& other)
+    {
+	m_any_NaN = m_any_NaN || other.m_any_NaN;
+    }
+
     void warnings()
     {
 	if (m_any_NaN)
@@ -1089,7 +1193,32 @@ private:
     bool m_any_NaN;
 };
 
-static SEXP math1(SEXP sa, double (*f)(double), SEXP lcall)
+namespace {
+    typedef NaNWarner<double, double, double (*)(double)> Math1Warner;
+
+    // Argument and result of a function of one argument, with a
+    // NaNWarner for each chunk processed by the WorkerPool:
+    struct Math1Data {
+	const double* in;
+	double* out;
+	std::vector<Math1Warner> warners;
+    };
+
+    void math1Chunk(void* data, size_t begin, size_t end,
+		    unsigned int chunk)
+    {
+	Math1Data* d = static_cast<Math1Data*>(data);
+	Math1Warner warner(d->warners[chunk]);
+	for (size_t i = begin; i < end; ++i)
+	    d->out[i] = warner(d->in[i]);
+	d->warners[chunk] = warner;
+    }
+}
+
+// If 'parallel' is true, f must be safe to call concurrently from
+// several threads, and in particular must not raise warnings.
+static SEXP math1(SEXP sa, double (*f)(double), SEXP lcall,
+		  bool parallel = true)
 {
     using namespace VectorOps;
     if (!isNumeric(sa))
@@ -1097,8 +1226,24 @@ static SEXP math1(SEXP sa, double (*f)(double), SEXP lcall)
     /* coercion can lose the object bit */
     GCStackRoot<RealVector>
 	rv(static_cast<RealVector*>(coerceVector(sa, REALSXP)));
-    UnaryFunction<double (*)(double), CopyAllAttributes, NaNWarner> uf(f);
-    return uf.apply<RealVector>(rv.get());
+    size_t n = rv->size();
+    unsigned int chunks = WorkerPool::numChunks(n, mathThreads());
+    if (!parallel || chunks == 1) {
+	UnaryFunction<double (*)(double), CopyAllAttributes, NaNWarner> uf(f);
+	return uf.apply<RealVector>(rv.get());
+    }
+    GCStackRoot<RealVector> ans(CXXR_NEW(RealVector(n)));
+    Math1Data data;
+    data.in = &(*rv)[0];
+    data.out = &(*ans)[0];
+    data.warners.resize(chunks, Math1Warner(f));
+    WorkerPool::run(math1Chunk, &data, n, mathThreads());
+    Math1Warner warner(f);
+    for (unsigned int i = 0; i < chunks; ++i)
+	warner.merge(data.warners[i]);
+    warner.warnings();
+    CopyAllAttributes::copyAttributes(ans, rv);
+    return ans;
 }
 
 SEXP attribute_hidden do_math1(SEXP call, SEXP op, SEXP args, SEXP env)
@@ -1115,6 +1260,9 @@ SEXP attribute_hidden do_math1(SEXP call, SEXP op, SEXP args, SEXP env)
 	return complex_math1(call, op, args, env);
 
 #define MATH1(x) math1(CAR(args), x, call);
+    // Functions from Rmath may raise warnings, so are not applied
+    // in parallel:
+#define MATH1_SERIAL(x) math1(CAR(args), x, call, false);
     switch (PRIMVAL(op)) {
     case 1: return MATH1(floor);
     case 2: return MATH1(ceil);
@@ -1139,11 +1287,11 @@ SEXP attribute_hidden do_math1(SEXP call, SEXP op, SEXP args, SEXP env)
     case 34: return MATH1(asinh);
     case 35: return MATH1(atanh);
 
-    case 40: return MATH1(lgammafn);
-    case 41: return MATH1(gammafn);
+    case 40: return MATH1_SERIAL(lgammafn);
+    case 41: return MATH1_SERIAL(gammafn);
 
-    case 42: return MATH1(digamma);
-    case 43: return MATH1(trigamma);
+    case 42: return MATH1_SERIAL(digamma);
+    case 43: return MATH1_SERIAL(trigamma);
 	/* case 44: return MATH1(tetragamma);
 	   case 45: return MATH1(pentagamma);
 	   removed in 2.0.0
@@ -385,25 +385,36 @@ SEXP attribute_hidden do_rowscols(SEXP call, SEXP op, SEXP args, SEXP rho)
     return ans;
 }
 
-static void matprod(double *x, int nrx, int ncx,
-		    double *y, int nry, int ncy, double *z)
+/* Does the real vector sx contain NA or NaN?  A negative answer is
+   recorded on sx, so that the scan need not be repeated if sx is
+   used again unchanged. */
+static Rboolean hasNaN(SEXP sx)
+{
+    const VectorBase* vb = static_cast<const VectorBase*>(sx);
+    if (vb->knownToHave(VectorBase::NO_NA))
+	return FALSE;
+    const double *x = REAL_RO(sx);
+    R_xlen_t n = XLENGTH(sx);
+    for (R_xlen_t i = 0; i < n; i++)
+	if (ISNAN(x[i])) return TRUE;
+    vb->noteProperty(VectorBase::NO_NA);
+    return FALSE;
+}
+
+static void matprod(SEXP sx, int nrx, int ncx,
+		    SEXP sy, int nry, int ncy, double *z)
 {
     CXXRCONST char *transa = "N", *transb = "N";
     double one = 1.0, zero = 0.0;
     LDOUBLE sum;
-    Rboolean have_na = FALSE;
     R_xlen_t NRX = nrx, NRY = nry;
+    const double *x = REAL_RO(sx), *y = REAL_RO(sy);
 
     if (nrx > 0 && ncx > 0 && nry > 0 && ncy > 0) {
 	/* Don't trust the BLAS to handle NA/NaNs correctly: PR#4582
 	 * The test is only O(n) here.
 	 */
-	for (R_xlen_t i = 0; i < NRX*ncx; i++)
-	    if (ISNAN(x[i])) {have_na = TRUE; break;}
-	if (!have_na)
-	    for (R_xlen_t i = 0; i < NRY*ncy; i++)
-		if (ISNAN(y[i])) {have_na = TRUE; break;}
-	if (have_na) {
+	if (hasNaN(sx) || hasNaN(sy)) {
 	    for (int i = 0; i < nrx; i++)
 		for (int k = 0; k < ncy; k++) {
 		    sum = 0.0;
@@ -692,8 +703,8 @@ SEXP attribute_hidden do_matprod(SEXP call, SEXP op, SEXP args, SEXP rho)
 	    cmatprod(COMPLEX(CAR(args)), nrx, ncx,
 		     COMPLEX(CADR(args)), nry, ncy, COMPLEX(ans));
 	else
-	    matprod(REAL(CAR(args)), nrx, ncx,
-		    REAL(CADR(args)), nry, ncy, REAL(ans));
+	    matprod(CAR(args), nrx, ncx,
+		    CADR(args), nry, ncy, REAL(ans));
 
 	PROTECT(xdims = getAttrib(CAR(args), R_DimNamesSymbol));
 	PROTECT(ydims = getAttrib(CADR(args), R_DimNamesSymbol));
@@ -44,7 +44,10 @@
 #include <Print.h>
 #include <Fileio.h>
 #include <Rconnections.h>
+#include "CXXR/Bailout.hpp"
+#include "CXXR/BailoutContext.hpp"
 #include "CXXR/ClosureContext.hpp"
+#include "CXXR/MemoryBank.hpp"
 
 #include <R_ext/RS.h> /* for Memzero */
 
@@ -768,14 +771,24 @@ SEXP attribute_hidden do_makevector(SEXP call, SEXP op, SEXP args, SEXP rho)
 	error(_("vector: cannot make a vector of mode '%s'."),
 	      translateChar(STRING_ELT(s, 0))); /* should be ASCII */
     }
-    if (mode == INTSXP || mode == LGLSXP)
-	Memzero(INTEGER(s), len);
-    else if (mode == REALSXP)
-	Memzero(REAL(s), len);
-    else if (mode == CPLXSXP)
-	Memzero(COMPLEX(s), len);
-    else if (mode == RAWSXP)
-	Memzero(RAW(s), len);
+    /* Large blocks come from MemoryBank already zeroed, and
+       touching them would needlessly commit physical memory: */
+    if (mode == INTSXP || mode == LGLSXP) {
+	if (!MemoryBank::zeroFilled(len*sizeof(int)))
+	    Memzero(INTEGER(s), len);
+    }
+    else if (mode == REALSXP) {
+	if (!MemoryBank::zeroFilled(len*sizeof(double)))
+	    Memzero(REAL(s), len);
+    }
+    else if (mode == CPLXSXP) {
+	if (!MemoryBank::zeroFilled(len*sizeof(Rcomplex)))
+	    Memzero(COMPLEX(s), len);
+    }
+    else if (mode == RAWSXP) {
+	if (!MemoryBank::zeroFilled(len*sizeof(Rbyte)))
+	    Memzero(RAW(s), len);
+    }
     /* other cases: list/expression have "NULL", ok */
     return s;
 }
@@ -972,6 +985,26 @@ static SEXP setDflt(SEXP arg, SEXP dflt)
     return(CAR(arg));
 }
 
+/* Evaluate the selected alternative of a switch.  As in do_if, this
+   is done within a BailoutContext, so that return(), break and next
+   within the alternative need not throw C++ exceptions. */
+
+static SEXP evalAlternative(SEXP alt, SEXP rho)
+{
+    RObject* ans;
+    {
+	BailoutContext bcntxt;
+	ans = eval(alt, rho);
+    }
+    if (ans && ans->sexptype() == BAILSXP) {
+	Evaluator::Context* callctxt
+	    = Evaluator::Context::innermost()->nextOut();
+	if (!callctxt || callctxt->type() != Evaluator::Context::BAILOUT)
+	    static_cast<Bailout*>(ans)->throwException();
+    }
+    return ans;
+}
+
 /* For switch, evaluate the first arg, if it is a character then try
  to match the name with the remaining args, and evaluate the match. If
  the value is missing then take the next non-missing arg as the value.
@@ -1030,7 +1063,7 @@ SEXP attribute_hidden do_switch(SEXP call, SEXP op, SEXP args, SEXP rho)
 			for (z = CDR(y); z != R_NilValue; z = CDR(z))
 			    if (TAG(z) == R_NilValue) dflt = setDflt(z, dflt);
 
-			ans =  eval(CAR(y), rho);
+			ans =  evalAlternative(CAR(y), rho);
 			UNPROTECT(2);
 			return ans;
 		    }
@@ -1038,7 +1071,7 @@ SEXP attribute_hidden do_switch(SEXP call, SEXP op, SEXP args, SEXP rho)
 		    dflt = setDflt(y, dflt);
 	    }
 	    if (dflt) {
-		ans =  eval(dflt, rho);
+		ans =  evalAlternative(dflt, rho);
 		UNPROTECT(2);
 		return ans;
 	    }
@@ -1049,7 +1082,7 @@ SEXP attribute_hidden do_switch(SEXP call, SEXP op, SEXP args, SEXP rho)
 		SEXP alt = CAR(nthcdr(w, argval - 1));
 		if (alt == R_MissingArg)
 		    error("empty alternative in numeric switch");
-		ans =  eval(alt, rho);
+		ans =  evalAlternative(alt, rho);
 		UNPROTECT(2);
 		return ans;
 	    }
@@ -62,6 +62,7 @@
 #include "CXXR/ByteCode.hpp"
 #include "CXXR/ClosureContext.hpp"
 #include "CXXR/DottedArgs.hpp"
+#include "CXXR/EvaluationProfiler.hpp"
 #include "CXXR/ListFrame.hpp"
 #include "CXXR/LoopBailout.hpp"
 #include "CXXR/LoopException.hpp"
@@ -465,6 +466,103 @@ SEXP do_Rprof(SEXP args)
 }
 #endif /* not R_PROFILING */
 
+/* Sampling profiler of evaluation, reporting collapsed call stacks
+   for use with flame graph tools. */
+
+extern "C"
+SEXP do_Rprofstack(SEXP args)
+{
+    double interval = Rf_asReal(CAR(args));
+    if (!R_FINITE(interval) || interval < 0 || interval > 1000)
+	Rf_error(_("invalid '%s' argument"), "interval");
+    int srcrefs = Rf_asLogical(CADR(args));
+    if (srcrefs == NA_LOGICAL)
+	Rf_error(_("invalid '%s' argument"), "srcref");
+    EvaluationProfiler::Stacks stacks;
+    EvaluationProfiler::takeStacks(&stacks);
+    unsigned int usecs = (unsigned int)(1e6*interval + 0.5);
+    if (interval > 0 && usecs == 0)
+	usecs = 1;
+    if (!EvaluationProfiler::start(usecs, srcrefs))
+	Rf_warning(_("evaluation profiling is not available on this system"));
+    size_t n = stacks.size();
+    GCStackRoot<RealVector> counts(CXXR_NEW(RealVector(n)));
+    GCStackRoot<StringVector> names(CXXR_NEW(StringVector(n)));
+    size_t i = 0;
+    for (EvaluationProfiler::Stacks::const_iterator it = stacks.begin();
+	 it != stacks.end(); ++it, ++i) {
+	(*counts)[i] = double((*it).second);
+	(*names)[i] = String::obtain((*it).first);
+    }
+    counts->setAttribute(NamesSymbol, names);
+    return counts;
+}
+
+/* Usage statistics of built-in functions. */
+
+extern "C"
+SEXP do_Rprofbuiltin(SEXP args)
+{
+    int enable = Rf_asLogical(CAR(args));
+    if (enable == NA_LOGICAL)
+	Rf_error(_("invalid '%s' argument"), "enable");
+    int reset = Rf_asLogical(CADR(args));
+    if (reset == NA_LOGICAL)
+	Rf_error(_("invalid '%s' argument"), "reset");
+    typedef std::vector<std::pair<std::string,
+				  BuiltInFunction::Statistics> > StatsVector;
+    StatsVector stats;
+    BuiltInFunction::getStatistics(&stats);
+    if (reset)
+	BuiltInFunction::resetStatistics();
+    BuiltInFunction::enableStatistics(enable);
+    const unsigned int nbins = BuiltInFunction::s_num_latency_bins;
+    const unsigned int ncols = 5 + nbins;
+    size_t n = stats.size();
+    GCStackRoot<ListVector> ans(CXXR_NEW(ListVector(ncols)));
+    GCStackRoot<StringVector> colnames(CXXR_NEW(StringVector(ncols)));
+    {
+	StringVector* name = CXXR_NEW(StringVector(n));
+	(*ans)[0] = name;
+	RealVector* calls = CXXR_NEW(RealVector(n));
+	(*ans)[1] = calls;
+	RealVector* time = CXXR_NEW(RealVector(n));
+	(*ans)[2] = time;
+	RealVector* self_time = CXXR_NEW(RealVector(n));
+	(*ans)[3] = self_time;
+	RealVector* bytes = CXXR_NEW(RealVector(n));
+	(*ans)[4] = bytes;
+	for (size_t i = 0; i < n; ++i) {
+	    const BuiltInFunction::Statistics& st = stats[i].second;
+	    (*name)[i] = String::obtain(stats[i].first);
+	    (*calls)[i] = double(st.calls);
+	    (*time)[i] = st.time;
+	    (*self_time)[i] = st.self_time;
+	    (*bytes)[i] = st.bytes;
+	}
+    }
+    (*colnames)[0] = String::obtain("name");
+    (*colnames)[1] = String::obtain("calls");
+    (*colnames)[2] = String::obtain("time");
+    (*colnames)[3] = String::obtain("self.time");
+    (*colnames)[4] = String::obtain("bytes");
+    // Histogram columns are labelled by the upper bound of their bin
+    // in microseconds:
+    for (unsigned int bin = 0; bin < nbins; ++bin) {
+	RealVector* counts = CXXR_NEW(RealVector(n));
+	(*ans)[5 + bin] = counts;
+	for (size_t i = 0; i < n; ++i)
+	    (*counts)[i] = double(stats[i].second.latency[bin]);
+	char label[16];
+	if (bin + 1 < nbins)
+	    snprintf(label, 16, "us.%u", 1u << bin);
+	else strcpy(label, "us.Inf");
+	(*colnames)[5 + bin] = String::obtain(label);
+    }
+    ans->setAttribute(NamesSymbol, colnames);
+    return ans;
+}
+
 /* NEEDED: A fixup is needed in browser, because it can trap errors,
  *	and currently does not reset the limit to the right value. */
 
@@ -702,7 +800,7 @@ SEXP R_execMethod(SEXP op, SEXP rho)
 
     // create a new environment frame enclosed by the lexical
     // environment of the method
-    GCStackRoot<Frame> newframe(CXXR_NEW(ListFrame));
+    GCStackRoot<Frame> newframe(CXXR_NEW(SlotFrame(func->frameLayout())));
     GCStackRoot<Environment>
 	newrho(CXXR_NEW(Environment(func->environment(), newframe)));
     Frame* tof = newrho->frame();
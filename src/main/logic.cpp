@@ -38,6 +38,8 @@
 #include <config.h>
 #endif
 
+#include <algorithm>
+
 #include <Defn.h>
 #include <Internal.h>
 
@@ -46,6 +48,7 @@
 #include "CXXR/GCStackRoot.hpp"
 #include "CXXR/RawVector.h"
 #include "CXXR/UnaryFunction.hpp"
+#include "CXXR/VectorKernels.hpp"
 
 using namespace CXXR;
 using namespace VectorOps;
@@ -258,17 +261,35 @@ SEXP attribute_hidden do_logic2(SEXP call, SEXP op, SEXP args, SEXP env)
 #define _OP_ALL 1
 #define _OP_ANY 2
 
+// Scan a block of a logical vector, without branches so that the
+// loop can be vectorised, reporting whether it contains target and
+// whether it contains NA:
+CXXR_KERNEL_OPTIMIZE
+static void scanLogicalBlock(const int *x, R_xlen_t n, int target,
+			     int *found, int *na)
+{
+    int f = 0, a = 0;
+    for (R_xlen_t i = 0; i < n; i++) {
+	f |= (x[i] == target);
+	a |= (x[i] == NA_LOGICAL);
+    }
+    *found = f;
+    *na = a;
+}
+
 static int checkValues(int op, int na_rm, int *x, R_xlen_t n)
 {
-    R_xlen_t i;
+    // The vector is scanned in blocks, stopping after the first block
+    // that determines the result:
+    const R_xlen_t block = 4096;
+    const int target = (op == _OP_ANY ? TRUE : FALSE);
     int has_na = 0;
-    for (i = 0; i < n; i++) {
-//	if ((i+1) % NINTERRUPT == 0) R_CheckUserInterrupt();
-        if (!na_rm && x[i] == NA_LOGICAL) has_na = 1;
-        else {
-            if (x[i] == TRUE && op == _OP_ANY) return TRUE;
-            if (x[i] == FALSE && op == _OP_ALL) return FALSE;
-	}
+    for (R_xlen_t b = 0; b < n; b += block) {
+	int found, na;
+	scanLogicalBlock(x + b, std::min(block, n - b), target, &found, &na);
+	if (found && (op == _OP_ANY || op == _OP_ALL))
+	    return target;
+	if (!na_rm && na) has_na = 1;
     }
     switch (op) {
     case _OP_ANY:
@@ -47,6 +47,7 @@
 #endif
 
 #include <R_ext/RS.h> /* for S4 allocation */
+#include "CXXR/AllocationProfiler.hpp"
 #include "CXXR/ByteCode.hpp"
 #include "CXXR/FunctionContext.hpp"
 #include "CXXR/GCManager.hpp"
@@ -222,6 +223,35 @@ SEXP attribute_hidden do_gc(SEXP call, SEXP op, SEXP args, SEXP rho)
     return value;
 }
 
+SEXP attribute_hidden do_gcstats(SEXP call, SEXP op, SEXP args, SEXP rho)
+{
+    checkArity(op, args);
+    const GCManager::Statistics& stats = GCManager::statistics();
+    const char* names[] = {"policy", "collections", "full.collections",
+			   "preemptive.collections", "gc.time",
+			   "mutator.time", "gc.fraction", "last.full.time",
+			   "trigger", "max.heap", "large.objects", ""};
+    GCStackRoot<> value(mkNamed(VECSXP, names));
+    double elapsed = stats.gc_time + stats.mutator_time;
+    /* times are in seconds, sizes in Mb */
+    SET_VECTOR_ELT(value, 0, mkString(GCManager::policy()->name()));
+    SET_VECTOR_ELT(value, 1, ScalarInteger(stats.collections));
+    SET_VECTOR_ELT(value, 2, ScalarInteger(stats.full_collections));
+    SET_VECTOR_ELT(value, 3, ScalarInteger(stats.preemptive_collections));
+    SET_VECTOR_ELT(value, 4, ScalarReal(0.001*stats.gc_time));
+    SET_VECTOR_ELT(value, 5, ScalarReal(0.001*stats.mutator_time));
+    SET_VECTOR_ELT(value, 6,
+		   ScalarReal(elapsed > 0 ? stats.gc_time/elapsed : 0.0));
+    SET_VECTOR_ELT(value, 7, ScalarReal(0.001*stats.last_full_time));
+    SET_VECTOR_ELT(value, 8,
+		   ScalarReal(double(GCManager::triggerLevel())/Mega));
+    SET_VECTOR_ELT(value, 9,
+		   ScalarReal(GCManager::maxHeap() == 0 ? R_PosInf
+			      : double(GCManager::maxHeap())/Mega));
+    SET_VECTOR_ELT(value, 10,
+		   ScalarReal(double(MemoryBank::largeBytesAllocated())/Mega));
+    return value;
+}
 
 #ifdef _R_HAVE_TIMING_
 
@@ -593,6 +623,58 @@ SEXP do_Rprofmem(SEXP args)
 
 #endif /* R_MEMORY_PROFILING */
 
+/*******************************************/
+/* Sampling allocation profiler: records
+   one allocation per 'interval' bytes    */
+/*******************************************/
+
+extern "C"
+SEXP do_Rprofalloc(SEXP args)
+{
+    double interval = asReal(CAR(args));
+    if (!R_FINITE(interval) || interval < 0)
+	error(_("invalid '%s' argument"), "interval");
+    std::vector<AllocationProfiler::Sample> samples;
+    AllocationProfiler::takeSamples(&samples);
+    AllocationProfiler::start(size_t(interval));
+    size_t n = samples.size();
+    SEXP count, bytes, size_class, type, weight, stack, ans, names;
+    PROTECT(count = allocVector(REALSXP, n));
+    PROTECT(bytes = allocVector(REALSXP, n));
+    PROTECT(size_class = allocVector(INTSXP, n));
+    PROTECT(type = allocVector(STRSXP, n));
+    PROTECT(weight = allocVector(REALSXP, n));
+    PROTECT(stack = allocVector(STRSXP, n));
+    for (size_t i = 0; i < n; ++i) {
+	const AllocationProfiler::Sample& smp = samples[i];
+	REAL(count)[i] = double(smp.count);
+	REAL(bytes)[i] = double(smp.bytes);
+	INTEGER(size_class)[i]
+	    = (smp.size_class < 0 ? NA_INTEGER : smp.size_class + 1);
+	SET_STRING_ELT(type, i, (smp.type < 0 ? NA_STRING
+				 : mkChar(type2char(SEXPTYPE(smp.type)))));
+	REAL(weight)[i] = double(smp.weight);
+	SET_STRING_ELT(stack, i, mkChar(smp.stack.c_str()));
+    }
+    PROTECT(ans = allocVector(VECSXP, 6));
+    SET_VECTOR_ELT(ans, 0, count);
+    SET_VECTOR_ELT(ans, 1, bytes);
+    SET_VECTOR_ELT(ans, 2, size_class);
+    SET_VECTOR_ELT(ans, 3, type);
+    SET_VECTOR_ELT(ans, 4, weight);
+    SET_VECTOR_ELT(ans, 5, stack);
+    PROTECT(names = allocVector(STRSXP, 6));
+    SET_STRING_ELT(names, 0, mkChar("count"));
+    SET_STRING_ELT(names, 1, mkChar("bytes"));
+    SET_STRING_ELT(names, 2, mkChar("size.class"));
+    SET_STRING_ELT(names, 3, mkChar("type"));
+    SET_STRING_ELT(names, 4, mkChar("weight"));
+    SET_STRING_ELT(names, 5, mkChar("stack"));
+    setAttrib(ans, R_NamesSymbol, names);
+    UNPROTECT(8);
+    return ans;
+}
+
 /* RBufferUtils, moved from deparse.c */
 
 #include "RBufferUtils.h"
@@ -43,6 +43,8 @@
 #include "Print.h"
 
 #include "CXXR/Evaluator.h"
+#include "CXXR/GCManager.hpp"
+#include <limits>
 
 using namespace CXXR;
 
@@ -88,6 +90,13 @@ using namespace CXXR;
  *	"warning.expression"
  *	"nwarnings"
 
+ *	"gc.pause.ms"		CXXR: GCManager::setPauseBudget()
+ *	"gc.mark.threads"	CXXR: GCManager::setMarkThreads()
+ *	"gc.policy"		CXXR: GCManager::setPolicy()
+ *	"gc.defer.refcounts"	CXXR: GCManager::setDeferredRefCounting()
+ *	"gc.cpu.fraction"	CXXR: GCManager::setGCFractionTarget()
+ *	"gc.max.heap"		CXXR: GCManager::setMaxHeap()
+
  *
  * S additionally/instead has (and one might think about some)
  * "free",	"keep"
@@ -253,9 +262,9 @@ void attribute_hidden InitOptions(void)
     char *p;
 
 #ifdef HAVE_RL_COMPLETION_MATCHES
-    PROTECT(v = val = allocList(17));
+    PROTECT(v = val = allocList(23));
 #else
-    PROTECT(v = val = allocList(16));
+    PROTECT(v = val = allocList(22));
 #endif
 
     SET_TAG(v, install("prompt"));
@@ -328,6 +337,46 @@ void attribute_hidden InitOptions(void)
     SETCAR(v, ScalarLogical(R_CBoundsCheck));
     v = CDR(v);
 
+    p = getenv("R_GC_POLICY");
+    if (p) {
+	GCManager::Policy* policy = GCManager::builtInPolicy(p);
+	if (policy)
+	    GCManager::setPolicy(policy);
+	else
+	    R_ShowMessage("WARNING: invalid R_GC_POLICY ignored\n");
+    }
+    SET_TAG(v, install("gc.policy"));
+    SETCAR(v, mkString(GCManager::policy()->name()));
+    v = CDR(v);
+
+    p = getenv("R_GC_MAX_HEAP");
+    if (p) {
+	int ierr;
+	R_size_t value = R_Decode2Long(p, &ierr);
+	if (ierr != 0)
+	    R_ShowMessage("WARNING: invalid R_GC_MAX_HEAP ignored\n");
+	else GCManager::setMaxHeap(value);
+    }
+    SET_TAG(v, install("gc.max.heap"));
+    SETCAR(v, ScalarReal(double(GCManager::maxHeap())));
+    v = CDR(v);
+
+    SET_TAG(v, install("gc.cpu.fraction"));
+    SETCAR(v, ScalarReal(GCManager::gcFractionTarget()));
+    v = CDR(v);
+
+    SET_TAG(v, install("gc.defer.refcounts"));
+    SETCAR(v, ScalarLogical(GCManager::deferredRefCounting()));
+    v = CDR(v);
+
+    SET_TAG(v, install("gc.mark.threads"));
+    SETCAR(v, ScalarInteger(int(GCManager::markThreads())));
+    v = CDR(v);
+
+    SET_TAG(v, install("gc.pause.ms"));
+    SETCAR(v, ScalarReal(GCManager::pauseBudget()));
+    v = CDR(v);
+
 #ifdef HAVE_RL_COMPLETION_MATCHES
     /* value from Rf_initialize_R */
     SET_TAG(v, install("rl_word_breaks"));
@@ -500,6 +549,66 @@ SEXP attribute_hidden do_options(SEXP call, SEXP op, SEXP args, SEXP rho)
 		    error(_("invalid value for '%s'"), CHAR(namei));
 		SET_VECTOR_ELT(value, i, SetOption(tag, argi));
 	    }
+	    else if (streql(CHAR(namei), "gc.pause.ms")) {
+		if (!isNumeric(argi) || length(argi) != 1)
+		    error(_("invalid value for '%s'"), CHAR(namei));
+		double ms = asReal(argi);
+		if (ISNAN(ms) || ms < 0)
+		    error(_("invalid value for '%s'"), CHAR(namei));
+		GCManager::setPauseBudget(ms);
+		SET_VECTOR_ELT(value, i, SetOption(tag, ScalarReal(ms)));
+	    }
+	    else if (streql(CHAR(namei), "gc.mark.threads")) {
+		if (!isNumeric(argi) || length(argi) != 1)
+		    error(_("invalid value for '%s'"), CHAR(namei));
+		int k = asInteger(argi);
+		if (k == NA_INTEGER || k < 1)
+		    error(_("invalid value for '%s'"), CHAR(namei));
+		GCManager::setMarkThreads(k);
+		SET_VECTOR_ELT(value, i, SetOption(tag, ScalarInteger(k)));
+	    }
+	    else if (streql(CHAR(namei), "gc.defer.refcounts")) {
+		if (TYPEOF(argi) != LGLSXP || LENGTH(argi) != 1)
+		    error(_("invalid value for '%s'"), CHAR(namei));
+		k = asLogical(argi);
+		if (k == NA_LOGICAL)
+		    error(_("invalid value for '%s'"), CHAR(namei));
+		GCManager::setDeferredRefCounting(k);
+		SET_VECTOR_ELT(value, i, SetOption(tag, ScalarLogical(k)));
+	    }
+	    else if (streql(CHAR(namei), "gc.policy")) {
+		if (!isString(argi) || LENGTH(argi) != 1
+		    || STRING_ELT(argi, 0) == NA_STRING)
+		    error(_("invalid value for '%s'"), CHAR(namei));
+		GCManager::Policy* policy
+		    = GCManager::builtInPolicy(CHAR(STRING_ELT(argi, 0)));
+		if (!policy)
+		    error(_("invalid value for '%s'"), CHAR(namei));
+		GCManager::setPolicy(policy);
+		SET_VECTOR_ELT(value, i,
+			       SetOption(tag, mkString(policy->name())));
+	    }
+	    else if (streql(CHAR(namei), "gc.cpu.fraction")) {
+		if (!isNumeric(argi) || length(argi) != 1)
+		    error(_("invalid value for '%s'"), CHAR(namei));
+		double f = asReal(argi);
+		if (ISNAN(f) || f <= 0 || f >= 1)
+		    error(_("invalid value for '%s'"), CHAR(namei));
+		GCManager::setGCFractionTarget(f);
+		SET_VECTOR_ELT(value, i, SetOption(tag, ScalarReal(f)));
+	    }
+	    else if (streql(CHAR(namei), "gc.max.heap")) {
+		if (!isNumeric(argi) || length(argi) != 1)
+		    error(_("invalid value for '%s'"), CHAR(namei));
+		double bytes = asReal(argi);
+		if (ISNAN(bytes) || bytes < 0)
+		    error(_("invalid value for '%s'"), CHAR(namei));
+		// Values too large for size_t, like Inf, mean no cap:
+		if (bytes < double(std::numeric_limits<size_t>::max()))
+		    GCManager::setMaxHeap(size_t(bytes));
+		else GCManager::setMaxHeap(0);
+		SET_VECTOR_ELT(value, i, SetOption(tag, ScalarReal(bytes)));
+	    }
 	    else if (streql(CHAR(namei), "warning.length")) {
 		k = asInteger(argi);
 		if (k < 100 || k > 8170)
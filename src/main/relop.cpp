@@ -50,6 +50,7 @@
 #include "CXXR/BinaryFunction.hpp"
 #include "CXXR/GCStackRoot.hpp"
 #include "CXXR/LogicalVector.h"
+#include "CXXR/VectorKernels.hpp"
 
 using namespace CXXR;
 using namespace VectorOps;
@@ -100,6 +101,42 @@ namespace {
 	}
     };
 
+}
+
+// Comparisons of real, integer and logical vectors are computed by
+// the branch-free kernels of VectorOps::Kernels where the operands'
+// lengths permit:
+namespace CXXR {
+    namespace VectorOps {
+	template <template <typename> class Relop>
+	struct BulkMapper<BinaryNAPropagator<double, double, int,
+					     NaN2NA<double, Relop> > > {
+	    static const bool enabled = true;
+
+	    static void map(int* out, const double* l, std::size_t nl,
+			    const double* r, std::size_t nr)
+	    {
+		Kernels::map<Kernels::RealComparison<Relop> >(out, l, nl,
+							       r, nr);
+	    }
+	};
+
+	template <template <typename> class Relop>
+	struct BulkMapper<BinaryNAPropagator<int, int, int,
+					     NaN2NA<int, Relop> > > {
+	    static const bool enabled = true;
+
+	    static void map(int* out, const int* l, std::size_t nl,
+			    const int* r, std::size_t nr)
+	    {
+		Kernels::map<Kernels::IntComparison<Relop> >(out, l, nl,
+							      r, nr);
+	    }
+	};
+    }  // namespace VectorOps
+}  // namespace CXXR
+
+namespace {
     template <template <typename> class Relop, class V>
     inline LogicalVector* relop_aux(const V* vl, const V* vr)
     {
@@ -113,6 +113,9 @@ Rboolean isUnsorted(SEXP x, Rboolean strictly)
     if (!isVectorAtomic(x))
 	error(_("only atomic vectors can be tested to be sorted"));
     n = XLENGTH(x);
+    const VectorBase* xv = static_cast<const VectorBase*>(x);
+    if (n >= 2 && !strictly && xv->knownToHave(VectorBase::SORTED_INCREASING))
+	return FALSE;
     if(n >= 2)
 	switch (TYPEOF(x)) {
 
@@ -123,26 +126,34 @@ Rboolean isUnsorted(SEXP x, Rboolean strictly)
 	       but we want the if() outside the loop */
 	case LGLSXP:
 	case INTSXP:
-	    if(strictly) {
-		for(i = 0; i+1 < n ; i++)
-		    if(INTEGER(x)[i] >= INTEGER(x)[i+1])
-			return TRUE;
-
-	    } else {
-		for(i = 0; i+1 < n ; i++)
-		    if(INTEGER(x)[i] > INTEGER(x)[i+1])
-			return TRUE;
+	    {
+		const int* px = INTEGER_RO(x);
+		if(strictly) {
+		    for(i = 0; i+1 < n ; i++)
+			if(px[i] >= px[i+1])
+			    return TRUE;
+
+		} else {
+		    for(i = 0; i+1 < n ; i++)
+			if(px[i] > px[i+1])
+			    return TRUE;
+		}
+		xv->noteProperty(VectorBase::SORTED_INCREASING);
 	    }
 	    break;
 	case REALSXP:
-	    if(strictly) {
-		for(i = 0; i+1 < n ; i++)
-		    if(REAL(x)[i] >= REAL(x)[i+1])
-			return TRUE;
-	    } else {
-		for(i = 0; i+1 < n ; i++)
-		    if(REAL(x)[i] > REAL(x)[i+1])
-			return TRUE;
+	    {
+		const double* px = REAL_RO(x);
+		if(strictly) {
+		    for(i = 0; i+1 < n ; i++)
+			if(px[i] >= px[i+1])
+			    return TRUE;
+		} else {
+		    for(i = 0; i+1 < n ; i++)
+			if(px[i] > px[i+1])
+			    return TRUE;
+		}
+		xv->noteProperty(VectorBase::SORTED_INCREASING);
 	    }
 	    break;
 	case CPLXSXP:
@@ -461,27 +472,41 @@ static void ssort2(StringVector* sv, R_xlen_t n, Rboolean decreasing)
 void sortVector(SEXP s, Rboolean decreasing)
 {
     R_xlen_t n = XLENGTH(s);
-    if (n >= 2 && (decreasing || isUnsorted(s, FALSE)))
-	switch (TYPEOF(s)) {
-	case LGLSXP:
-	case INTSXP:
-	    R_isort2(INTEGER(s), n, decreasing);
-	    break;
-	case REALSXP:
-	    R_rsort2(REAL(s), n, decreasing);
-	    break;
-	case CPLXSXP:
-	    R_csort2(COMPLEX(s), n, decreasing);
+    const VectorBase* vb = static_cast<const VectorBase*>(s);
+    if (n < 2
+	|| (decreasing ? vb->knownToHave(VectorBase::SORTED_DECREASING)
+	    : !isUnsorted(s, FALSE)))
+	return;
+    bool no_na = vb->knownToHave(VectorBase::NO_NA);
+    switch (TYPEOF(s)) {
+    case LGLSXP:
+    case INTSXP:
+	R_isort2(INTEGER(s), n, decreasing);
+	break;
+    case REALSXP:
+	R_rsort2(REAL(s), n, decreasing);
+	break;
+    case CPLXSXP:
+	R_csort2(COMPLEX(s), n, decreasing);
+	break;
+    case STRSXP:
+	{
+	    StringVector* sv = static_cast<StringVector*>(s);
+	    ssort2(sv, n, decreasing);
 	    break;
-	case STRSXP:
-	    {
-		StringVector* sv = static_cast<StringVector*>(s);
-		ssort2(sv, n, decreasing);
-		break;
-	    }
-	default:
-	    UNIMPLEMENTED_TYPE("sortVector", s);
 	}
+    default:
+	UNIMPLEMENTED_TYPE("sortVector", s);
+    }
+    // Sorting preserves the absence of NAs.  Integer and logical
+    // vectors end up sorted even if they contain NAs, but NaNs may
+    // leave a vector of doubles out of order:
+    if (no_na)
+	vb->noteProperty(VectorBase::NO_NA);
+    if (TYPEOF(s) == LGLSXP || TYPEOF(s) == INTSXP
+	|| (TYPEOF(s) == REALSXP && no_na))
+	vb->noteProperty(decreasing ? VectorBase::SORTED_DECREASING
+			 : VectorBase::SORTED_INCREASING);
 }
 
 
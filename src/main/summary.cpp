@@ -38,9 +38,13 @@
 #include <config.h>
 #endif
 
+#include <algorithm>
+#include <vector>
 #include <Defn.h>
 #include <Internal.h>
 #include "CXXR/GCStackRoot.hpp"
+#include "CXXR/VectorKernels.hpp"
+#include "CXXR/WorkerPool.hpp"
 
 using namespace CXXR;
 
@@ -61,85 +65,369 @@ using namespace CXXR;
 #define DbgP3(s,a,b)
 #endif
 
-#ifdef LONG_INT
-static Rboolean isum(int *x, R_xlen_t n, int *value, Rboolean narm, SEXP call)
-{
-    LONG_INT s = 0;  // at least 64-bit
-    Rboolean updated = FALSE;
-#ifdef LONG_VECTOR_SUPPORT
-    int ii = R_INT_MIN; // need > 2^32 entries to overflow.
-#endif
+// Summaries of long numeric vectors are computed block by block, each
+// block being summarised independently (in parallel if
+// setNumMathThreads() allows) by the block() member function of a
+// Reducer class, and the block summaries then being combined in order
+// by its combine() member function.  Because the blocks do not depend
+// on the number of threads, neither does the result.  Vectors of at
+// most one block are summarised by a single call of block().  The
+// block() functions avoid branches, so that the integer and min/max
+// loops can be vectorised.
+namespace {
+    const R_xlen_t SUMMARY_BLOCK = 4096;
+
+    unsigned int mathThreads()
+    {
+	return (R_num_math_threads > 0 ? R_num_math_threads : 1);
+    }
 
-    for (R_xlen_t i = 0; i < n; i++) {
-	if (x[i] != NA_INTEGER) {
-	    if(!updated) updated = TRUE;
-	    s += x[i];
-#ifdef LONG_VECTOR_SUPPORT
-	    if (ii++ > 1000) {
-		ii = 0;
-		if (s > 9000000000000000L || s < -9000000000000000L) {
-		    if(!updated) updated = TRUE;
-		    *value = NA_INTEGER;
-		    warningcall(call, _("integer overflow - use sum(as.numeric(.))"));
-		    return updated;
+    template <class Reducer>
+    struct ReductionData {
+	const Reducer* reducer;
+	const typename Reducer::Elt* x;
+	typename Reducer::Result* results;
+    };
+
+    template <class Reducer>
+    void reductionChunk(void* data, size_t begin, size_t end, unsigned int)
+    {
+	ReductionData<Reducer>* rd = static_cast<ReductionData<Reducer>*>(data);
+	for (size_t b = begin; b < end; b += SUMMARY_BLOCK)
+	    rd->results[b/SUMMARY_BLOCK]
+		= rd->reducer->block(rd->x + b,
+				     R_xlen_t(std::min(end, b + SUMMARY_BLOCK) - b));
+    }
+
+    template <class Reducer>
+    typename Reducer::Result
+    reduce(const Reducer& reducer, const typename Reducer::Elt* x,
+	   R_xlen_t n)
+    {
+	if (n <= SUMMARY_BLOCK)
+	    return reducer.block(x, n);
+	std::vector<typename Reducer::Result>
+	    results((n + SUMMARY_BLOCK - 1)/SUMMARY_BLOCK);
+	ReductionData<Reducer> rd = {&reducer, x, &results[0]};
+	WorkerPool::run(reductionChunk<Reducer>, &rd, size_t(n),
+			mathThreads(), SUMMARY_BLOCK);
+	typename Reducer::Result ans = results[0];
+	for (size_t b = 1; b < results.size(); ++b)
+	    reducer.combine(&ans, results[b]);
+	return ans;
+    }
+
+    // Sum of x - offset over the elements of x (excluding NaNs if
+    // narm), accumulated in LDOUBLE:
+    struct RealSum {
+	typedef double Elt;
+	struct Result {
+	    LDOUBLE sum;
+	    R_xlen_t count;
+	};
+
+	RealSum(bool narm, LDOUBLE offset = 0.0)
+	    : m_narm(narm), m_offset(offset)
+	{}
+
+	Result block(const double* x, R_xlen_t n) const
+	{
+	    Result r = {0.0, n};
+	    if (!m_narm)
+		for (R_xlen_t i = 0; i < n; ++i)
+		    r.sum += x[i] - m_offset;
+	    else {
+		r.count = 0;
+		for (R_xlen_t i = 0; i < n; ++i) {
+		    bool ok = !ISNAN(x[i]);
+		    r.sum += (ok ? x[i] - m_offset : 0.0);
+		    r.count += ok;
 		}
 	    }
-#endif
-	} else if (!narm) {
-	    if(!updated) updated = TRUE;
-	    *value = NA_INTEGER;
-	    return updated;
+	    return r;
+	}
+
+	void combine(Result* acc, const Result& r) const
+	{
+	    acc->sum += r.sum;
+	    acc->count += r.count;
+	}
+    private:
+	bool m_narm;
+	LDOUBLE m_offset;
+    };
+
+    // Sum of the non-NA elements of x, noting whether any NA was
+    // encountered.  overflow is set if the running sum, tested after
+    // each block, exceeds 9e15 in absolute value:
+    template <typename Acc>
+    struct IntSum {
+	typedef int Elt;
+	struct Result {
+	    Acc sum;
+	    R_xlen_t count;
+	    bool na;
+	    bool overflow;
+	};
+
+	CXXR_KERNEL_OPTIMIZE
+	Result block(const int* x, R_xlen_t n) const
+	{
+	    Acc sum = 0;
+	    R_xlen_t count = 0;
+	    for (R_xlen_t i = 0; i < n; ++i) {
+		bool ok = (x[i] != NA_INTEGER);
+		sum += (ok ? x[i] : 0);
+		count += ok;
+	    }
+	    Result r = {sum, count, count != n, false};
+	    return r;
+	}
+
+	void combine(Result* acc, const Result& r) const
+	{
+	    acc->sum += r.sum;
+	    acc->count += r.count;
+	    acc->na |= r.na;
+	    if (acc->sum > 9000000000000000.0 || acc->sum < -9000000000000000.0)
+		acc->overflow = true;
 	}
+    };
+
+    // Minimum and maximum of the elements of x, taking NA_INTEGER
+    // (i.e. INT_MIN) at face value, together with the minimum over
+    // the non-NA elements of x - 1, computed in unsigned arithmetic
+    // so that NA_INTEGER maps to INT_MAX.  Thus x contains NA iff min
+    // is NA_INTEGER, and contains a non-NA element iff min_less_1 is
+    // not INT_MAX.
+    struct IntRange {
+	typedef int Elt;
+	struct Result {
+	    int min;
+	    int max;
+	    int min_less_1;
+	};
+
+	CXXR_KERNEL_OPTIMIZE
+	Result block(const int* x, R_xlen_t n) const
+	{
+	    int mn = INT_MAX, mx = INT_MIN, mn1 = INT_MAX;
+	    for (R_xlen_t i = 0; i < n; ++i) {
+		int v = x[i];
+		int v1 = int(static_cast<unsigned int>(v) - 1u);
+		mn = (v < mn ? v : mn);
+		mx = (v > mx ? v : mx);
+		mn1 = (v1 < mn1 ? v1 : mn1);
+	    }
+	    Result r = {mn, mx, mn1};
+	    return r;
+	}
+
+	void combine(Result* acc, const Result& r) const
+	{
+	    acc->min = std::min(acc->min, r.min);
+	    acc->max = std::max(acc->max, r.max);
+	    acc->min_less_1 = std::min(acc->min_less_1, r.min_less_1);
+	}
+    };
+
+    // Minimum and maximum of the non-NaN elements of x (+Inf and
+    // -Inf respectively if there are none), and the number of NaNs.
+    // The loop maintains four partial results, combined at the end of
+    // the block, so that it can be vectorised.
+    struct RealRange {
+	typedef double Elt;
+	struct Result {
+	    double min;
+	    double max;
+	    R_xlen_t nans;
+	};
+
+	CXXR_KERNEL_OPTIMIZE
+	Result block(const double* x, R_xlen_t n) const
+	{
+	    double mn[4] = {R_PosInf, R_PosInf, R_PosInf, R_PosInf};
+	    double mx[4] = {R_NegInf, R_NegInf, R_NegInf, R_NegInf};
+	    R_xlen_t nans = 0;
+	    R_xlen_t i = 0;
+	    for (; i + 4 <= n; i += 4)
+		for (int j = 0; j < 4; ++j) {
+		    double v = x[i + j];
+		    mn[j] = (v < mn[j] ? v : mn[j]);
+		    mx[j] = (v > mx[j] ? v : mx[j]);
+		    nans += (v != v);
+		}
+	    for (; i < n; ++i) {
+		double v = x[i];
+		mn[0] = (v < mn[0] ? v : mn[0]);
+		mx[0] = (v > mx[0] ? v : mx[0]);
+		nans += (v != v);
+	    }
+	    Result r = {mn[0], mx[0], nans};
+	    for (int j = 1; j < 4; ++j) {
+		r.min = (mn[j] < r.min ? mn[j] : r.min);
+		r.max = (mx[j] > r.max ? mx[j] : r.max);
+	    }
+	    return r;
+	}
+
+	void combine(Result* acc, const Result& r) const
+	{
+	    acc->min = (r.min < acc->min ? r.min : acc->min);
+	    acc->max = (r.max > acc->max ? r.max : acc->max);
+	    acc->nans += r.nans;
+	}
+    };
+
+    // Value to be reported by min() or max() of a double vector
+    // containing NaNs, when na.rm is false: any NA trumps all NaNs,
+    // and otherwise the last NaN is reported.
+    double nanResult(const double* x, R_xlen_t n)
+    {
+	double s = 0.0;
+	for (R_xlen_t i = 0; i < n; ++i)
+	    if (ISNAN(x[i])) {
+		if (ISNA(x[i]))
+		    return x[i];
+		s = x[i];
+	    }
+	return s;
     }
-    if(s > INT_MAX || s < R_INT_MIN){
-	warningcall(call, _("integer overflow - use sum(as.numeric(.))"));
-	*value = NA_INTEGER;
+
+    inline bool isInfinite(LDOUBLE v)
+    {
+	return v == v && v - v != 0.0;
     }
-    else *value = int( s);
 
-    return updated;
-}
-#else
-/* Version from R 3.0.0: should never be used with a C99/C11 compiler */
-static Rboolean isum(int *x, R_xlen_t n, int *value, Rboolean narm, SEXP call)
-{
-    double s = 0.0;
-    Rboolean updated = FALSE;
+    inline bool zeroTimesInf(LDOUBLE a, LDOUBLE b)
+    {
+	return (a == 0.0 && isInfinite(b)) || (b == 0.0 && isInfinite(a));
+    }
 
-    for (R_xlen_t i = 0; i < n; i++) {
-	if (x[i] != NA_INTEGER) {
-	    if(!updated) updated = TRUE;
-	    s += x[i];
-	} else if (!narm) {
-	    if(!updated) updated = TRUE;
-	    *value = NA_INTEGER;
-	    return updated;
+    // If x is known to be free of NAs and sorted, set *index to the
+    // position of its minimum (or, if want_max, its maximum) element
+    // and return true; otherwise return false:
+    bool knownExtremum(SEXP x, bool want_max, R_xlen_t* index)
+    {
+	const VectorBase* xv = static_cast<const VectorBase*>(x);
+	if (!xv->knownToHave(VectorBase::NO_NA))
+	    return false;
+	R_xlen_t last = XLENGTH(x) - 1;
+	if (xv->knownToHave(VectorBase::SORTED_INCREASING))
+	    *index = (want_max ? last : 0);
+	else if (xv->knownToHave(VectorBase::SORTED_DECREASING))
+	    *index = (want_max ? 0 : last);
+	else return false;
+	return true;
+    }
+
+    // Product of the elements of x (excluding NaNs if narm),
+    // accumulated in LDOUBLE.  A product that has overflowed to
+    // infinity before reaching zero (or vice versa) evaluates to NaN
+    // in a sequential loop, but not necessarily when computed block
+    // by block; combine() sets zero_times_inf if it encounters this
+    // ambiguity, and the caller should then recompute the product
+    // sequentially.
+    struct RealProd {
+	typedef double Elt;
+	struct Result {
+	    LDOUBLE prod;
+	    R_xlen_t count;
+	    bool zero_times_inf;
+	};
+
+	explicit RealProd(bool narm)
+	    : m_narm(narm)
+	{}
+
+	Result block(const double* x, R_xlen_t n) const
+	{
+	    Result r = {1.0, n, false};
+	    if (!m_narm)
+		for (R_xlen_t i = 0; i < n; ++i)
+		    r.prod *= x[i];
+	    else {
+		r.count = 0;
+		for (R_xlen_t i = 0; i < n; ++i) {
+		    bool ok = !ISNAN(x[i]);
+		    r.prod *= (ok ? x[i] : 1.0);
+		    r.count += ok;
+		}
+	    }
+	    return r;
 	}
+
+	void combine(Result* acc, const Result& r) const
+	{
+	    acc->zero_times_inf |= zeroTimesInf(acc->prod, r.prod);
+	    acc->prod *= r.prod;
+	    acc->count += r.count;
+	}
+    private:
+	bool m_narm;
+    };
+
+    // Product of the non-NA elements of x, accumulated in LDOUBLE,
+    // noting whether any NA was encountered.  zero_times_inf is as for
+    // RealProd.
+    struct IntProd {
+	typedef int Elt;
+	struct Result {
+	    LDOUBLE prod;
+	    R_xlen_t count;
+	    bool na;
+	    bool zero_times_inf;
+	};
+
+	Result block(const int* x, R_xlen_t n) const
+	{
+	    Result r = {1.0, 0, false, false};
+	    for (R_xlen_t i = 0; i < n; ++i) {
+		bool ok = (x[i] != NA_INTEGER);
+		r.prod *= (ok ? x[i] : 1);
+		r.count += ok;
+	    }
+	    r.na = (r.count != n);
+	    return r;
+	}
+
+	void combine(Result* acc, const Result& r) const
+	{
+	    acc->zero_times_inf |= zeroTimesInf(acc->prod, r.prod);
+	    acc->prod *= r.prod;
+	    acc->count += r.count;
+	    acc->na |= r.na;
+	}
+    };
+}
+
+static Rboolean isum(const int *x, R_xlen_t n, int *value, Rboolean narm, SEXP call)
+{
+#ifdef LONG_INT
+    IntSum<LONG_INT>::Result r = reduce(IntSum<LONG_INT>(), x, n);
+#else
+    /* As in R 3.0.0: should never be used with a C99/C11 compiler */
+    IntSum<double>::Result r = reduce(IntSum<double>(), x, n);
+#endif
+    if (r.na && !narm) {
+	*value = NA_INTEGER;
+	return TRUE;
     }
-    if(s > INT_MAX || s < R_INT_MIN){
+    if(r.overflow || r.sum > INT_MAX || r.sum < R_INT_MIN){
 	warningcall(call, _("integer overflow - use sum(as.numeric(.))"));
 	*value = NA_INTEGER;
     }
-    else *value = int( s);
+    else *value = int( r.sum);
 
-    return updated;
+    return Rboolean(r.count > 0);
 }
-#endif
 
-static Rboolean rsum(double *x, R_xlen_t n, double *value, Rboolean narm)
+static Rboolean rsum(const double *x, R_xlen_t n, double *value, Rboolean narm)
 {
-    LDOUBLE s = 0.0;
-    Rboolean updated = FALSE;
+    RealSum::Result r = reduce(RealSum(narm), x, n);
+    *value = double( r.sum);
 
-    for (R_xlen_t i = 0; i < n; i++) {
-	if (!narm || !ISNAN(x[i])) {
-	    if(!updated) updated = TRUE;
-	    s += x[i];
-	}
-    }
-    *value = double( s);
-
-    return updated;
+    return Rboolean(r.count > 0);
 }
 
 static Rboolean csum(Rcomplex *x, R_xlen_t n, Rcomplex *value, Rboolean narm)
@@ -160,50 +448,52 @@ static Rboolean csum(Rcomplex *x, R_xlen_t n, Rcomplex *value, Rboolean narm)
     return updated;
 }
 
-static Rboolean imin(int *x, R_xlen_t n, int *value, Rboolean narm)
+static Rboolean imin(SEXP x, int *value, Rboolean narm)
 {
-    int s = 0 /* -Wall */;
-    Rboolean updated = FALSE;
-
-    /* Used to set s = INT_MAX, but this ignored INT_MAX in the input */
-    for (R_xlen_t i = 0; i < n; i++) {
-	if (x[i] != NA_INTEGER) {
-	    if (!updated || s > x[i]) {
-		s = x[i];
-		if(!updated) updated = TRUE;
-	    }
-	}
-	else if (!narm) {
-	    *value = NA_INTEGER;
-	    return(TRUE);
-	}
+    const int* px = INTEGER_RO(x);
+    R_xlen_t k;
+    if (knownExtremum(x, false, &k)) {
+	*value = px[k];
+	return TRUE;
     }
-    *value = s;
+    IntRange::Result r = reduce(IntRange(), px, XLENGTH(x));
+    if (r.min != NA_INTEGER)
+	static_cast<const VectorBase*>(x)->noteProperty(VectorBase::NO_NA);
+    if (r.min == NA_INTEGER && !narm) {
+	*value = NA_INTEGER;
+	return(TRUE);
+    }
+    if (r.min_less_1 == INT_MAX) {
+	*value = 0;
+	return FALSE;
+    }
+    *value = r.min_less_1 + 1;
 
-    return updated;
+    return TRUE;
 }
 
-static Rboolean rmin(double *x, R_xlen_t n, double *value, Rboolean narm)
+static Rboolean rmin(SEXP x, double *value, Rboolean narm)
 {
-    double s = 0.0; /* -Wall */
-    Rboolean updated = FALSE;
-
-    /* s = R_PosInf; */
-    for (R_xlen_t i = 0; i < n; i++) {
-	if (ISNAN(x[i])) {/* Na(N) */
-	    if (!narm) {
-		if(!ISNA(s)) s = x[i]; /* so any NA trumps all NaNs */
-		if(!updated) updated = TRUE;
-	    }
-	}
-	else if (!updated || x[i] < s) {  /* Never true if s is NA/NaN */
-	    s = x[i];
-	    if(!updated) updated = TRUE;
-	}
+    const double* px = REAL_RO(x);
+    R_xlen_t n = XLENGTH(x), k;
+    if (knownExtremum(x, false, &k)) {
+	*value = px[k];
+	return TRUE;
     }
-    *value = s;
+    RealRange::Result r = reduce(RealRange(), px, n);
+    if (r.nans == 0)
+	static_cast<const VectorBase*>(x)->noteProperty(VectorBase::NO_NA);
+    if (r.nans > 0 && !narm) {
+	*value = nanResult(px, n);
+	return TRUE;
+    }
+    if (r.nans == n) {
+	*value = 0.0;
+	return FALSE;
+    }
+    *value = r.min;
 
-    return updated;
+    return TRUE;
 }
 
 static Rboolean smin(SEXP x, SEXP *value, Rboolean narm)
@@ -231,47 +521,52 @@ static Rboolean smin(SEXP x, SEXP *value, Rboolean narm)
     return updated;
 }
 
-static Rboolean imax(int *x, R_xlen_t n, int *value, Rboolean narm)
+static Rboolean imax(SEXP x, int *value, Rboolean narm)
 {
-    int s = 0 /* -Wall */;
-    Rboolean updated = FALSE;
-
-    for (R_xlen_t i = 0; i < n; i++) {
-	if (x[i] != NA_INTEGER) {
-	    if (!updated || s < x[i]) {
-		s = x[i];
-		if(!updated) updated = TRUE;
-	    }
-	} else if (!narm) {
-	    *value = NA_INTEGER;
-	    return(TRUE);
-	}
+    const int* px = INTEGER_RO(x);
+    R_xlen_t k;
+    if (knownExtremum(x, true, &k)) {
+	*value = px[k];
+	return TRUE;
     }
-    *value = s;
+    IntRange::Result r = reduce(IntRange(), px, XLENGTH(x));
+    if (r.min != NA_INTEGER)
+	static_cast<const VectorBase*>(x)->noteProperty(VectorBase::NO_NA);
+    if (r.min == NA_INTEGER && !narm) {
+	*value = NA_INTEGER;
+	return(TRUE);
+    }
+    if (r.min_less_1 == INT_MAX) {
+	*value = 0;
+	return FALSE;
+    }
+    *value = r.max;
 
-    return updated;
+    return TRUE;
 }
 
-static Rboolean rmax(double *x, R_xlen_t n, double *value, Rboolean narm)
+static Rboolean rmax(SEXP x, double *value, Rboolean narm)
 {
-    double s = 0.0 /* -Wall */;
-    Rboolean updated = FALSE;
-
-    for (R_xlen_t i = 0; i < n; i++) {
-	if (ISNAN(x[i])) {/* Na(N) */
-	    if (!narm) {
-		if(!ISNA(s)) s = x[i]; /* so any NA trumps all NaNs */
-		if(!updated) updated = TRUE;
-	    }
-	}
-	else if (!updated || x[i] > s) {  /* Never true if s is NA/NaN */
-	    s = x[i];
-	    if(!updated) updated = TRUE;
-	}
+    const double* px = REAL_RO(x);
+    R_xlen_t n = XLENGTH(x), k;
+    if (knownExtremum(x, true, &k)) {
+	*value = px[k];
+	return TRUE;
     }
-    *value = s;
+    RealRange::Result r = reduce(RealRange(), px, n);
+    if (r.nans == 0)
+	static_cast<const VectorBase*>(x)->noteProperty(VectorBase::NO_NA);
+    if (r.nans > 0 && !narm) {
+	*value = nanResult(px, n);
+	return TRUE;
+    }
+    if (r.nans == n) {
+	*value = 0.0;
+	return FALSE;
+    }
+    *value = r.max;
 
-    return updated;
+    return TRUE;
 }
 
 static Rboolean smax(SEXP x, SEXP *value, Rboolean narm)
@@ -299,46 +594,28 @@ static Rboolean smax(SEXP x, SEXP *value, Rboolean narm)
     return updated;
 }
 
-static Rboolean iprod(int *x, R_xlen_t n, double *value, Rboolean narm)
+static Rboolean iprod(const int *x, R_xlen_t n, double *value, Rboolean narm)
 {
-    LDOUBLE s = 1.0;
-    Rboolean updated = FALSE;
-
-    for (R_xlen_t i = 0; i < n; i++) {
-	if (x[i] != NA_INTEGER) {
-	    s *= x[i];
-	    if(!updated) updated = TRUE;
-	}
-	else if (!narm) {
-	    if(!updated) updated = TRUE;
-	    *value = NA_REAL;
-	    return updated;
-	}
-
-	if(ISNAN(s)) {  /* how can this happen? */
-	    *value = NA_REAL;
-	    return updated;
-	}
+    IntProd::Result r = reduce(IntProd(), x, n);
+    if (r.zero_times_inf)
+	r = IntProd().block(x, n);
+    if ((r.na && !narm) || ISNAN(double(r.prod))) {
+	*value = NA_REAL;
+	return Rboolean(r.count > 0 || r.na);
     }
-    *value = double( s);
+    *value = double( r.prod);
 
-    return updated;
+    return Rboolean(r.count > 0);
 }
 
-static Rboolean rprod(double *x, R_xlen_t n, double *value, Rboolean narm)
+static Rboolean rprod(const double *x, R_xlen_t n, double *value, Rboolean narm)
 {
-    LDOUBLE s = 1.0;
-    Rboolean updated = FALSE;
+    RealProd::Result r = reduce(RealProd(narm), x, n);
+    if (r.zero_times_inf)
+	r = RealProd(narm).block(x, n);
+    *value = double( r.prod);
 
-    for (R_xlen_t i = 0; i < n; i++) {
-	if (!narm || !ISNAN(x[i])) {
-	    if(!updated) updated = TRUE;
-	    s *= x[i];
-	}
-    }
-    *value = double( s);
-
-    return updated;
+    return Rboolean(r.count > 0);
 }
 
 static Rboolean cprod(Rcomplex *x, R_xlen_t n, Rcomplex *value, Rboolean narm)
@@ -420,22 +697,18 @@ SEXP attribute_hidden do_summary(SEXP call, SEXP op, SEXP args, SEXP env)
 	case LGLSXP:
 	case INTSXP:
 	    PROTECT(ans = allocVector(REALSXP, 1));
-	    for (i = 0; i < n; i++) {
-		if(INTEGER(x)[i] == NA_INTEGER) {
-		    REAL(ans)[0] = R_NaReal;
-		    UNPROTECT(1);
-		    return ans;
-		}
-		s += INTEGER(x)[i];
+	    {
+		IntSum<LDOUBLE>::Result r
+		    = reduce(IntSum<LDOUBLE>(), INTEGER_RO(x), n);
+		REAL(ans)[0] = (r.na ? R_NaReal : double( r.sum/n));
 	    }
-	    REAL(ans)[0] = double( s/n);
 	    break;
 	case REALSXP:
 	    PROTECT(ans = allocVector(REALSXP, 1));
-	    for (i = 0; i < n; i++) s += REAL(x)[i];
+	    s = reduce(RealSum(false), REAL_RO(x), n).sum;
 	    s /= n;
 	    if(R_FINITE(double(s))) {
-		for (i = 0; i < n; i++) t += (REAL(x)[i] - s);
+		t = reduce(RealSum(false, s), REAL_RO(x), n).sum;
 		s += t/n;
 	    }
 	    REAL(ans)[0] = double( s);
@@ -549,8 +822,8 @@ SEXP attribute_hidden do_summary(SEXP call, SEXP op, SEXP args, SEXP env)
 		case LGLSXP:
 		case INTSXP:
 		    int_a = 1;
-		    if (iop == 2) updated = imin(INTEGER(a), XLENGTH(a), &itmp, narm);
-		    else	  updated = imax(INTEGER(a), XLENGTH(a), &itmp, narm);
+		    if (iop == 2) updated = imin(a, &itmp, narm);
+		    else	  updated = imax(a, &itmp, narm);
 		    break;
 		case REALSXP:
 		    real_a = 1;
@@ -558,8 +831,8 @@ SEXP attribute_hidden do_summary(SEXP call, SEXP op, SEXP args, SEXP env)
 			ans_type = REALSXP;
 			if(!empty) zcum.r = Int2Real(icum);
 		    }
-		    if (iop == 2) updated = rmin(REAL(a), XLENGTH(a), &tmp, narm);
-		    else	  updated = rmax(REAL(a), XLENGTH(a), &tmp, narm);
+		    if (iop == 2) updated = rmin(a, &tmp, narm);
+		    else	  updated = rmax(a, &tmp, narm);
 		    break;
 		case STRSXP:
 		    if(!empty && ans_type == INTSXP)
@@ -618,9 +891,7 @@ SEXP attribute_hidden do_summary(SEXP call, SEXP op, SEXP args, SEXP env)
 		switch(TYPEOF(a)) {
 		case LGLSXP:
 		case INTSXP:
-		    updated = isum(TYPEOF(a) == LGLSXP ?
-				   LOGICAL(a) :INTEGER(a), XLENGTH(a),
-				   &itmp, narm, call);
+		    updated = isum(INTEGER_RO(a), XLENGTH(a), &itmp, narm, call);
 		    if(updated) {
 			if(itmp == NA_INTEGER) goto na_answer;
 			if(ans_type == INTSXP) {
@@ -639,7 +910,7 @@ SEXP attribute_hidden do_summary(SEXP call, SEXP op, SEXP args, SEXP env)
 			ans_type = REALSXP;
 			if(!empty) zcum.r = Int2Real(icum);
 		    }
-		    updated = rsum(REAL(a), XLENGTH(a), &tmp, narm);
+		    updated = rsum(REAL_RO(a), XLENGTH(a), &tmp, narm);
 		    if(updated) {
 			zcum.r += tmp;
 		    }
@@ -669,9 +940,9 @@ SEXP attribute_hidden do_summary(SEXP call, SEXP op, SEXP args, SEXP env)
 		case INTSXP:
 		case REALSXP:
 		    if(TYPEOF(a) == REALSXP)
-			updated = rprod(REAL(a), XLENGTH(a), &tmp, narm);
+			updated = rprod(REAL_RO(a), XLENGTH(a), &tmp, narm);
 		    else
-			updated = iprod(INTEGER(a), XLENGTH(a), &tmp, narm);
+			updated = iprod(INTEGER_RO(a), XLENGTH(a), &tmp, narm);
 		    if(updated) {
 			zcum.r *= tmp;
 			zcum.i *= tmp;
@@ -804,18 +1075,25 @@ SEXP attribute_hidden do_range(SEXP call, SEXP op, SEXP args, SEXP env)
 SEXP attribute_hidden do_first_min(SEXP call, SEXP op, SEXP args, SEXP rho)
 {
     SEXP sx, ans;
-    double s, *r;
+    double s;
+    const double *r;
     int i, n, indx;
+    R_xlen_t k;
 
     checkArity(op, args);
     PROTECT(sx = coerceVector(CAR(args), REALSXP));
     if (!isNumeric(sx))
 	error(_("non-numeric argument"));
-    r = REAL(sx);
+    r = REAL_RO(sx);
     n = LENGTH(sx);
     indx = NA_INTEGER;
 
-    if(PRIMVAL(op) == 0) { /* which.min */
+    if (n > 0 && knownExtremum(sx, PRIMVAL(op) != 0, &k)) {
+	/* Sorted: find the first of any tied extreme elements */
+	indx = int(k);
+	while (indx > 0 && r[indx - 1] == r[k])
+	    indx--;
+    } else if(PRIMVAL(op) == 0) { /* which.min */
 	s = R_PosInf;
 	for (i = 0; i < n; i++)
 	    if ( !ISNAN(r[i]) && (r[i] < s || indx == NA_INTEGER) ) {
@@ -60,6 +60,36 @@ int main() {
     }
     pool.check();
     cout << "Cells allocated: " << pool.cellsAllocated() << endl;
+    // Empty the first superblock:
+    for (int i = 0; i < 5; ++i) {
+	if (i == 3) continue;
+	cout << "Deallocating dptrs[" << i << "]\n";
+	pool.deallocate(dptrs[i]);
+    }
+    cout << "Superblocks released: " << pool.defragment() << endl;
+    pool.check();
+    cout << "Cells allocated: " << pool.cellsAllocated() << endl;
+    // Leave one free cell in the second superblock and three in a
+    // new one:
+    for (int i = 0; i < 5; ++i) {
+	if (i == 3) continue;
+	cout << "Allocating dptrs[" << i << "]\n";
+	dptrs[i] = static_cast<double*>(pool.allocate());
+    }
+    double* fullest = dptrs[6];
+    cout << "Deallocating dptrs[6]\n";
+    pool.deallocate(dptrs[6]);
+    for (int i = 0; i < 3; ++i) {
+	cout << "Deallocating dptrs[" << i << "]\n";
+	pool.deallocate(dptrs[i]);
+    }
+    cout << "Superblocks released: " << pool.defragment() << endl;
+    pool.check();
+    cout << "Allocating dptrs[6]\n";
+    dptrs[6] = static_cast<double*>(pool.allocate());
+    cout << "Allocated from fullest superblock: "
+	 << (dptrs[6] == fullest ? "yes" : "no") << endl;
+    cout << "Cells allocated: " << pool.cellsAllocated() << endl;
     return 0;
 }
 
@@ -0,0 +1,175 @@
+/*CXXR $Id$
+ *CXXR
+ *CXXR This file is part of CXXR, a project to refactor the R interpreter
+ *CXXR into C++.  It may consist in whole or in part of program code and
+ *CXXR documentation taken from the R project itself, incorporated into
+ *CXXR CXXR (and possibly MODIFIED) under the terms of the GNU General Public
+ *CXXR Licence.
+ *CXXR
+ *CXXR CXXR is Copyright (C) 2008-14 Andrew R. Runnalls, subject to such other
+ *CXXR copyrights and copyright restrictions as may be stated below.
+ *CXXR
+ *CXXR CXXR is not part of the R project, and bugs and other issues should
+ *CXXR not be reported via r-bugs or other R project channels; instead refer
+ *CXXR to the CXXR website.
+ *CXXR */
+
+/** @file Closuretest.cpp
+ *
+ * Test of the reuse of working Environments by Closure::invoke().
+ * The body of the test Closure calls a probe function, which records
+ * the working Environment of each call, creates a binding in its
+ * Frame, and optionally lets the Environment escape by binding it in
+ * the calling Environment.  Working Environments that have not
+ * escaped should be reused, with their Frames emptied, so that
+ * repeated calls allocate no further GCNode objects; working
+ * Environments that have escaped must not be reused.
+ */
+
+#define R_NO_REMAP
+
+#include "CXXR/Closure.h"
+
+#define R_INTERFACE_PTRS
+
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <vector>
+
+// For Rf_InitOptions():
+#include "Defn.h"
+
+// Inclusion of Defn.h must precede this:
+#include "Rinterface.h"
+
+#include "CXXR/ArgList.hpp"
+#include "CXXR/Expression.h"
+#include "CXXR/GCStackRoot.hpp"
+#include "CXXR/ListFrame.hpp"
+#include "CXXR/Symbol.h"
+
+using namespace std;
+using namespace CXXR;
+
+extern "C" {
+    void WriteConsoleEx(const char* buf, int, int)
+    {
+	cout << buf << endl;
+    }
+
+    void DoNothing() { }
+}
+
+namespace {
+    // Function called from the body of the test Closure:
+    class Probe : public FunctionBase {
+    public:
+	static vector<Environment*> s_envs;  // Working environments
+			// seen, in order of call.
+	static bool s_all_empty;  // Was the Frame of every working
+			// environment empty on entry?
+	static Environment* s_escape_env;  // If non-null, each
+			// working environment is bound in this
+			// Environment.
+
+	Probe()
+	    : FunctionBase(BUILTINSXP)
+	{}
+
+	// Virtual function of FunctionBase:
+	RObject* apply(ArgList*, Environment* env, const Expression*) const
+	{
+	    Frame* frame = env->frame();
+	    if (frame->size() != 0)
+		s_all_empty = false;
+	    frame->obtainBinding(Symbol::obtain("tmp"))
+		->setValue(const_cast<Probe*>(this));
+	    if (s_escape_env) {
+		ostringstream name;
+		name << "escapee" << s_envs.size();
+		s_escape_env->frame()->obtainBinding(Symbol::obtain(name.str()))
+		    ->setValue(env);
+	    }
+	    s_envs.push_back(env);
+	    return 0;
+	}
+    private:
+	~Probe() {}
+    };
+
+    vector<Environment*> Probe::s_envs;
+    bool Probe::s_all_empty = true;
+    Environment* Probe::s_escape_env = 0;
+
+    const char* yesno(bool b)
+    {
+	return b ? "yes" : "no";
+    }
+
+    unsigned int distinct(const vector<Environment*>& envs)
+    {
+	return set<Environment*>(envs.begin(), envs.end()).size();
+    }
+
+    void usage(const char* cmd)
+    {
+	cerr << "Usage: " << cmd << " num_calls\n";
+	exit(1);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Evaluator evalr;
+    if (argc != 2)
+	usage(argv[0]);
+    int num_calls = atoi(argv[1]);
+    if (num_calls < 1)
+	usage(argv[0]);
+    // Set up error reporting:
+    ptr_R_WriteConsoleEx = WriteConsoleEx;
+    ptr_R_ResetConsole = ptr_R_FlushConsole =
+        ptr_R_ClearerrConsole = DoNothing;
+    Rf_InitOptions();
+    // Set up the calling Environment, and a Closure with no
+    // arguments whose body calls the probe:
+    GCStackRoot<Frame> ff(CXXR_NEW(ListFrame));
+    GCStackRoot<Environment> callenv(CXXR_NEW(Environment(0, ff)));
+    GCStackRoot<Probe> probe(GCNode::expose(new Probe));
+    GCStackRoot<Expression> body(CXXR_NEW(Expression(probe)));
+    GCStackRoot<Closure> clos(CXXR_NEW(Closure(0, body, callenv)));
+    GCStackRoot<Expression>
+	call(CXXR_NEW(Expression(Symbol::obtain("f"))));
+    ArgList args(0, ArgList::PROMISED);
+    // First call, which has to allocate a working environment:
+    clos->invoke(callenv, &args, call);
+    size_t nodes = GCNode::numNodes();
+    for (int i = 1; i < num_calls; ++i)
+	clos->invoke(callenv, &args, call);
+    cout << "Working environments used by " << num_calls << " calls: "
+	 << distinct(Probe::s_envs) << '\n';
+    cout << "Nodes allocated after the first call: "
+	 << GCNode::numNodes() - nodes << '\n';
+    cout << "Frame empty on entry to every call: "
+	 << yesno(Probe::s_all_empty) << '\n';
+    // Now let each working environment escape:
+    const unsigned int num_escapes = 10;
+    Probe::s_envs.clear();
+    Probe::s_escape_env = callenv;
+    for (unsigned int i = 0; i < num_escapes; ++i)
+	clos->invoke(callenv, &args, call);
+    Probe::s_escape_env = 0;
+    cout << "Working environments used by " << num_escapes
+	 << " escaping calls: " << distinct(Probe::s_envs) << '\n';
+    bool intact = true;
+    for (unsigned int i = 0; i < num_escapes; ++i)
+	intact = intact
+	    && Probe::s_envs[i]->frame()->binding(Symbol::obtain("tmp"));
+    cout << "Escaped environments retain their bindings: "
+	 << yesno(intact) << '\n';
+    cout << "Frame empty on entry to every call: "
+	 << yesno(Probe::s_all_empty) << '\n';
+    return 0;
+}
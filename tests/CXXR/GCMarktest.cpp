@@ -0,0 +1,301 @@
+/*CXXR $Id$
+ *CXXR
+ *CXXR This file is part of CXXR, a project to refactor the R interpreter
+ *CXXR into C++.  It may consist in whole or in part of program code and
+ *CXXR documentation taken from the R project itself, incorporated into
+ *CXXR CXXR (and possibly MODIFIED) under the terms of the GNU General Public
+ *CXXR Licence.
+ *CXXR
+ *CXXR CXXR is Copyright (C) 2008-14 Andrew R. Runnalls, subject to such other
+ *CXXR copyrights and copyright restrictions as may be stated below.
+ *CXXR
+ *CXXR CXXR is not part of the R project, and bugs and other issues should
+ *CXXR not be reported via r-bugs or other R project channels; instead refer
+ *CXXR to the CXXR website.
+ *CXXR */
+
+/** @file GCMarktest.cpp
+ *
+ * Test of the mark phase of the CXXR garbage collector.  Checks that
+ * a minor collection retains young nodes reachable only via GCEdges
+ * from old nodes, that an incremental mark interleaved with mutator
+ * writes frees nothing that is still reachable, and that a parallel
+ * mark retains exactly the same nodes as a serial mark.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "CXXR/GCEdge.hpp"
+#include "CXXR/GCManager.hpp"
+#include "CXXR/GCNode.hpp"
+#include "CXXR/GCStackRoot.hpp"
+
+using namespace std;
+using namespace CXXR;
+
+namespace {
+    // GCNode with two outgoing edges, which keeps a count of the
+    // instances in existence.  If a Link's id is less than the size
+    // of s_alive, the corresponding element of s_alive records
+    // whether that Link is in existence.
+    class Link : public GCNode {
+    public:
+	static size_t s_live;
+	static vector<char> s_alive;
+
+	GCEdge<Link> m_next;
+	GCEdge<Link> m_side;
+	unsigned int m_id;
+
+	explicit Link(unsigned int id, Link* next = 0)
+	    : m_next(next), m_id(id)
+	{
+	    ++s_live;
+	    if (m_id < s_alive.size())
+		s_alive[m_id] = 1;
+	}
+
+	// Virtual functions of GCNode:
+	void detachReferents()
+	{
+	    m_next.detach();
+	    m_side.detach();
+	}
+
+	void visitReferents(const_visitor* v) const
+	{
+	    const GCNode* next = m_next;
+	    const GCNode* side = m_side;
+	    if (next)
+		(*v)(next);
+	    if (side)
+		(*v)(side);
+	}
+    private:
+	~Link()
+	{
+	    --s_live;
+	    if (m_id < s_alive.size())
+		s_alive[m_id] = 0;
+	}
+    };
+
+    size_t Link::s_live = 0;
+    vector<char> Link::s_alive;
+
+    const char* yesno(bool b)
+    {
+	return b ? "yes" : "no";
+    }
+
+    // Count the Links reachable from head, and total their ids:
+    void survey(const Link* head, size_t* count, double* idsum)
+    {
+	vector<const Link*> stack(1, head);
+	*count = 0;
+	*idsum = 0;
+	while (!stack.empty()) {
+	    const Link* node = stack.back();
+	    stack.pop_back();
+	    ++*count;
+	    *idsum += node->m_id;
+	    const Link* next = node->m_next;
+	    const Link* side = node->m_side;
+	    if (next)
+		stack.push_back(next);
+	    if (side)
+		stack.push_back(side);
+	}
+    }
+
+    // Record in reachable the ids of the Links reachable from head:
+    void reach(const Link* head, vector<char>* reachable)
+    {
+	vector<const Link*> stack(1, head);
+	while (!stack.empty()) {
+	    const Link* node = stack.back();
+	    stack.pop_back();
+	    if (!(*reachable)[node->m_id]) {
+		(*reachable)[node->m_id] = 1;
+		const Link* next = node->m_next;
+		const Link* side = node->m_side;
+		if (next)
+		    stack.push_back(next);
+		if (side)
+		    stack.push_back(side);
+	    }
+	}
+    }
+
+    void usage(const char* cmd)
+    {
+	cerr << "Usage: " << cmd << " num_nodes\n"
+	     << "  num_nodes must be at least 1000.\n";
+	exit(1);
+    }
+
+    // Store young nodes into GCEdges of an old node, and check that
+    // minor collections retain them:
+    void testGenerations()
+    {
+	{
+	    GCStackRoot<Link> root(GCNode::expose(new Link(1)));
+	    // Promote root to the old generation:
+	    GCNode::gc(false);
+	    root->m_next = GCNode::expose(new Link(2));
+	    {
+		// Unreachable young cycle, which the minor collection
+		// should reclaim:
+		GCStackRoot<Link> a(GCNode::expose(new Link(3)));
+		a->m_next = GCNode::expose(new Link(4, a));
+	    }
+	    GCNode::gc(false);
+	    Link* young = root->m_next;
+	    cout << "Young node referenced from old node survives"
+		" minor collection: " << yesno(young && young->m_id == 2)
+		 << '\n';
+	    cout << "Links after minor collection: " << Link::s_live << '\n';
+	    // Node 2 is now old too: hang a young chain beneath it.
+	    young->m_next = GCNode::expose(new Link(6));
+	    young->m_next->m_next = GCNode::expose(new Link(5));
+	    GCNode::gc(false);
+	    Link* chain = young->m_next;
+	    cout << "Young chain beneath old node survives"
+		" minor collection: "
+		 << yesno(chain && chain->m_id == 6 && chain->m_next
+			  && chain->m_next->m_id == 5) << '\n';
+	    cout << "Links after second minor collection: "
+		 << Link::s_live << '\n';
+	    cout << "Heap consistent: " << yesno(GCNode::check()) << '\n';
+	}
+	GCNode::gc(true);
+	cout << "Links after full collection: " << Link::s_live << '\n';
+    }
+
+    // Run an incremental mark over a list of num_nodes Links, and
+    // between mark slices move tails of the list, which the mark
+    // has not yet reached, beneath new nodes hung from its head,
+    // which it has already blackened:
+    void testIncrementalMark(unsigned int num_nodes)
+    {
+	const unsigned int num_moves = 10;
+	{
+	    vector<Link*> nodes(num_nodes);
+	    GCStackRoot<Link> head;
+	    for (unsigned int i = num_nodes; i > 0; --i) {
+		head = GCNode::expose(new Link(i - 1, head));
+		nodes[i - 1] = head;
+	    }
+	    GCNode::gc(true);
+	    double budget = GCManager::pauseBudget();
+	    size_t threshold = GCManager::triggerLevel();
+	    unsigned int full = GCManager::statistics().full_collections;
+	    // A negligible budget limits each slice to a single batch
+	    // of nodes, and a negligible threshold ensures that the
+	    // next collection starts an incremental mark:
+	    GCManager::setPauseBudget(1.0e-9);
+	    GCManager::setGCThreshold(1);
+	    GCManager::gc(false);
+	    unsigned int slices = 0;
+	    while (GCManager::statistics().full_collections == full
+		   && slices <= num_nodes) {
+		if (slices < num_moves) {
+		    Link* b = nodes[num_nodes - 2 - 100*slices];
+		    GCStackRoot<Link>
+			y(GCNode::expose(new Link(num_nodes + slices)));
+		    y->m_side = head->m_side;
+		    head->m_side = y;
+		    y->m_next = b->m_next;
+		    b->m_next = 0;
+		}
+		GCManager::gc(false);
+		++slices;
+	    }
+	    GCManager::setGCThreshold(threshold);
+	    GCManager::setPauseBudget(budget);
+	    cout << "Incremental mark spanned all the moves: "
+		 << yesno(slices > num_moves
+			  && GCManager::statistics().full_collections
+			  != full) << '\n';
+	    size_t count;
+	    double idsum;
+	    survey(head, &count, &idsum);
+	    size_t total = num_nodes + num_moves;
+	    cout << "Reachable Links intact after incremental mark: "
+		 << yesno(count == total
+			  && idsum == 0.5*double(total)*double(total - 1)
+			  && Link::s_live == total) << '\n';
+	    cout << "Heap consistent: " << yesno(GCNode::check()) << '\n';
+	}
+	GCNode::gc(true);
+	cout << "Links after full collection: " << Link::s_live << '\n';
+    }
+
+    // Build a graph of num_nodes Links, comprising a list cut into
+    // segments, with pseudorandom side edges mostly pointing back
+    // to earlier Links, so that unreachable segments contain
+    // cycles.  Carry out a full collection using the specified
+    // number of mark threads, and return the ids of the surviving
+    // Links, and in reachable the ids of the Links that ought to
+    // have survived.
+    vector<char> markWith(unsigned int threads, unsigned int num_nodes,
+			  vector<char>* reachable)
+    {
+	Link::s_alive.assign(num_nodes, 0);
+	reachable->assign(num_nodes, 0);
+	{
+	    vector<Link*> nodes(num_nodes);
+	    GCStackRoot<Link> head;
+	    for (unsigned int i = num_nodes; i > 0; --i) {
+		head = GCNode::expose(new Link(i - 1, head));
+		nodes[i - 1] = head;
+	    }
+	    unsigned long seed = 1;
+	    for (unsigned int i = 0; i < num_nodes; i += 16) {
+		seed = (1103515245*seed + 12345) % 2147483648UL;
+		unsigned int limit = (i%4096 == 0 ? num_nodes : i + 1);
+		nodes[i]->m_side = nodes[seed % limit];
+	    }
+	    for (unsigned int i = 999; i < num_nodes; i += 1000)
+		nodes[i]->m_next = 0;
+	    reach(head, reachable);
+	    unsigned int saved_threads = GCManager::markThreads();
+	    GCManager::setMarkThreads(threads);
+	    GCNode::gc(true);
+	    GCManager::setMarkThreads(saved_threads);
+	}
+	vector<char> ans(Link::s_alive);
+	GCNode::gc(true);
+	Link::s_alive.clear();
+	return ans;
+    }
+
+    // Check that parallel and serial marks retain the same Links:
+    void testParallelMark(unsigned int num_nodes)
+    {
+	vector<char> reachable;
+	vector<char> serial = markWith(1, num_nodes, &reachable);
+	cout << "Serial mark retains exactly the reachable Links: "
+	     << yesno(serial == reachable) << '\n';
+	vector<char> parallel = markWith(4, num_nodes, &reachable);
+	cout << "Parallel mark retains exactly the reachable Links: "
+	     << yesno(parallel == reachable) << '\n';
+	cout << "Parallel and serial marks agree: "
+	     << yesno(parallel == serial) << '\n';
+	cout << "Links after full collection: " << Link::s_live << '\n';
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+	usage(argv[0]);
+    int num_nodes = atoi(argv[1]);
+    if (num_nodes < 1000)
+	usage(argv[0]);
+    testGenerations();
+    testIncrementalMark(num_nodes);
+    testParallelMark(num_nodes);
+    return 0;
+}
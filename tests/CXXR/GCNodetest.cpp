@@ -0,0 +1,111 @@
+/*CXXR $Id$
+ *CXXR
+ *CXXR This file is part of CXXR, a project to refactor the R interpreter
+ *CXXR into C++.  It may consist in whole or in part of program code and
+ *CXXR documentation taken from the R project itself, incorporated into
+ *CXXR CXXR (and possibly MODIFIED) under the terms of the GNU General Public
+ *CXXR Licence.
+ *CXXR
+ *CXXR CXXR is Copyright (C) 2008-14 Andrew R. Runnalls, subject to such other
+ *CXXR copyrights and copyright restrictions as may be stated below.
+ *CXXR
+ *CXXR CXXR is not part of the R project, and bugs and other issues should
+ *CXXR not be reported via r-bugs or other R project channels; instead refer
+ *CXXR to the CXXR website.
+ *CXXR */
+
+/** @file GCNodetest.cpp
+ *
+ * Test of the handling by class CXXR::GCNode of constructors that
+ * throw exceptions while the moribund list is long.  The time per
+ * failed construction is written to the standard error stream as a
+ * microbenchmark: it should not depend on the number of nodes on the
+ * moribund list.
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+#include "CXXR/GCManager.hpp"
+#include "CXXR/GCNode.hpp"
+#include "CXXR/GCStackRoot.hpp"
+
+using namespace std;
+using namespace CXXR;
+
+namespace {
+    // Minimal GCNode whose constructor throws on request:
+    class Dummy : public GCNode {
+    public:
+	explicit Dummy(bool fail)
+	{
+	    if (fail)
+		throw runtime_error("Dummy construction failed");
+	}
+    private:
+	~Dummy() {}
+    };
+
+    void usage(const char* cmd)
+    {
+	cerr << "Usage: " << cmd << " num_nodes num_failures\n";
+	exit(1);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+	usage(argv[0]);
+    int num_nodes = atoi(argv[1]);
+    int num_failures = atoi(argv[2]);
+    if (num_nodes < 0 || num_failures < 0)
+	usage(argv[0]);
+    size_t base = GCNode::numNodes();
+    {
+	GCNode::GCInhibitor inhibitor;
+	// Nodes to which no reference is ever made remain on the
+	// moribund list until the next gclite():
+	for (int i = 0; i < num_nodes; ++i)
+	    GCNode::expose(new Dummy(false));
+	cout << "Nodes created: " << GCNode::numNodes() - base << '\n';
+	int caught = 0;
+	clock_t start = clock();
+	for (int i = 0; i < num_failures; ++i) {
+	    try {
+		GCNode::expose(new Dummy(true));
+	    }
+	    catch (runtime_error&) {
+		++caught;
+	    }
+	}
+	double secs = double(clock() - start)/CLOCKS_PER_SEC;
+	cerr << "Failed constructions: " << 1.0e6*secs/num_failures
+	     << " microseconds each with " << num_nodes
+	     << " nodes on moribund list\n";
+	cout << "Failed constructions caught: " << caught << '\n';
+	cout << "Nodes in existence: " << GCNode::numNodes() - base << '\n';
+    }
+    GCNode::gclite();
+    GCNode::check();
+    cout << "Nodes remaining after gclite(): "
+	 << GCNode::numNodes() - base << '\n';
+    // With deferred reference counting, each node released by the
+    // GCStackRoot is reclaimed by the next gclite():
+    GCManager::setDeferredRefCounting(true);
+    {
+	GCNode::GCInhibitor inhibitor;
+	GCStackRoot<Dummy> root;
+	for (int i = 0; i < num_nodes; ++i)
+	    root = GCNode::expose(new Dummy(false));
+	cout << "Nodes in existence with deferral: "
+	     << GCNode::numNodes() - base << '\n';
+    }
+    GCNode::gclite();
+    GCNode::check();
+    GCManager::setDeferredRefCounting(false);
+    cout << "Nodes remaining after deferred gclite(): "
+	 << GCNode::numNodes() - base << '\n';
+    return 0;
+}
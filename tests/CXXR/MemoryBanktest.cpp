@@ -78,6 +78,12 @@ namespace {
     {
 	cout << "Monitored allocation of " << bytes << " bytes\n";
     }
+
+    void sampler(void*, size_t bytes, unsigned int count)
+    {
+	cout << "Sampled allocation of " << bytes << " bytes (size class "
+	     << MemoryBank::sizeClass(bytes) << ", count " << count << ")\n";
+    }
 }
 
 int main(int argc, char* argv[]) {
@@ -104,6 +110,7 @@ int main(int argc, char* argv[]) {
     // Carry out churns:
     {
 	MemoryBank::setMonitor(0);
+	MemoryBank::setSampler(sampler, 300);
 	for (unsigned int i = 0; i < num_churns; ++i) {
 	    long rnd = qrnd();
 	    if (rnd & 2 || trs.empty()) alloc(rnd);
@@ -117,6 +124,7 @@ int main(int argc, char* argv[]) {
 		trs.pop_back();
 	    }
 	}
+	MemoryBank::setSampler(0);
 	MemoryBank::check();
 	cout << "Blocks allocated: " << MemoryBank::blocksAllocated()
 	     << "\nBytes allocated: " << MemoryBank::bytesAllocated() << endl;
@@ -128,6 +136,31 @@ int main(int argc, char* argv[]) {
 	    MemoryBank::deallocate(trs[k].cptr, trs[k].size);
 	}
     }
+    // Resize a large block:
+    {
+	const size_t big = 2*MemoryBank::largeObjectThreshold() < (1 << 22)
+	    ? 2*MemoryBank::largeObjectThreshold() : (1 << 22);
+	char* cptr = reinterpret_cast<char*>(MemoryBank::allocate(big));
+	bool ok = true;
+	if (MemoryBank::zeroFilled(big))
+	    for (size_t i = 0; i < big; ++i)
+		ok = ok && cptr[i] == 0;
+	for (size_t i = 0; i < big; ++i)
+	    cptr[i] = char(i%251);
+	cptr = reinterpret_cast<char*>(MemoryBank::reallocate(cptr, big,
+							      2*big));
+	for (size_t i = 0; i < big; ++i)
+	    ok = ok && cptr[i] == char(i%251);
+	cptr = reinterpret_cast<char*>(MemoryBank::reallocate(cptr, 2*big,
+							      1000));
+	for (size_t i = 0; i < 1000; ++i)
+	    ok = ok && cptr[i] == char(i%251);
+	MemoryBank::deallocate(cptr, 1000);
+	cout << "Large block resized " << (ok ? "correctly" : "INCORRECTLY")
+	     << "\nBytes allocated: " << MemoryBank::bytesAllocated()
+	     << "\nLarge object bytes allocated: "
+	     << MemoryBank::largeBytesAllocated() << endl;
+    }
     return 0;
 }
 
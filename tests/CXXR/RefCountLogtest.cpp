@@ -0,0 +1,135 @@
+/*CXXR $Id$
+ *CXXR
+ *CXXR This file is part of CXXR, a project to refactor the R interpreter
+ *CXXR into C++.  It may consist in whole or in part of program code and
+ *CXXR documentation taken from the R project itself, incorporated into
+ *CXXR CXXR (and possibly MODIFIED) under the terms of the GNU General Public
+ *CXXR Licence.
+ *CXXR
+ *CXXR CXXR is Copyright (C) 2008-14 Andrew R. Runnalls, subject to such other
+ *CXXR copyrights and copyright restrictions as may be stated below.
+ *CXXR
+ *CXXR CXXR is not part of the R project, and bugs and other issues should
+ *CXXR not be reported via r-bugs or other R project channels; instead refer
+ *CXXR to the CXXR website.
+ *CXXR */
+
+/** @file RefCountLogtest.cpp
+ *
+ * Test of deferred reference counting.  An edge is repeatedly
+ * redirected among a few nodes, as when a variable is rebound in a
+ * loop: the increment and decrement made to each node's reference
+ * count are never adjacent in the log, but must still cancel
+ * without the node being touched.  This is detected by starting
+ * each node's reference count one short of its saturation value:
+ * an increment applied to the node would make the count stick
+ * there.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include "CXXR/GCEdge.hpp"
+#include "CXXR/GCManager.hpp"
+#include "CXXR/GCNode.hpp"
+#include "CXXR/GCStackRoot.hpp"
+
+using namespace std;
+using namespace CXXR;
+
+namespace {
+    // GCNode with two outgoing edges:
+    class Holder : public GCNode {
+    public:
+	GCEdge<Holder> m_next;
+	GCEdge<Holder> m_target;
+
+	explicit Holder(Holder* next = 0, Holder* target = 0)
+	    : m_next(next), m_target(target)
+	{}
+
+	// Virtual functions of GCNode:
+	void detachReferents()
+	{
+	    m_next.detach();
+	    m_target.detach();
+	}
+
+	void visitReferents(const_visitor* v) const
+	{
+	    const GCNode* next = m_next;
+	    const GCNode* target = m_target;
+	    if (next)
+		(*v)(next);
+	    if (target)
+		(*v)(target);
+	}
+    private:
+	~Holder() {}
+    };
+
+    const unsigned int num_targets = 3;
+    const unsigned int saturation = 31;
+
+    const char* yesno(bool b)
+    {
+	return b ? "yes" : "no";
+    }
+
+    void usage(const char* cmd)
+    {
+	cerr << "Usage: " << cmd << " num_rebindings\n";
+	exit(1);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+	usage(argv[0]);
+    int num_rebindings = atoi(argv[1]);
+    if (num_rebindings < 1)
+	usage(argv[0]);
+    // The list headed by 'holders' contains all the nodes of the
+    // test.  Each target is referenced by its predecessor in the
+    // list, and by enough further holders to bring its reference
+    // count to one short of saturation:
+    GCStackRoot<Holder> holders;
+    Holder* targets[num_targets];
+    for (unsigned int i = 0; i < num_targets; ++i) {
+	holders = GCNode::expose(new Holder(holders));
+	targets[i] = holders;
+	for (unsigned int j = 1; j < saturation - 1; ++j)
+	    holders = GCNode::expose(new Holder(holders, targets[i]));
+    }
+    Holder* variable = holders = GCNode::expose(new Holder(holders));
+    cout << "Initial reference counts:";
+    for (unsigned int i = 0; i < num_targets; ++i)
+	cout << ' ' << targets[i]->refCount();
+    cout << '\n';
+    GCManager::setDeferredRefCounting(true);
+    for (int k = 0; k < num_rebindings; ++k)
+	variable->m_target = targets[k%num_targets];
+    variable->m_target = 0;
+    GCManager::setDeferredRefCounting(false);
+    cout << "Reference counts after rebinding:";
+    for (unsigned int i = 0; i < num_targets; ++i)
+	cout << ' ' << targets[i]->refCount();
+    cout << '\n';
+    // Rebind through more distinct nodes than the log can hold, so
+    // that it is applied part way through:
+    GCStackRoot<Holder> chain;
+    const unsigned int chain_length = 10000;
+    for (unsigned int i = 0; i < chain_length; ++i)
+	chain = GCNode::expose(new Holder(chain));
+    GCManager::setDeferredRefCounting(true);
+    for (Holder* h = chain; h; h = h->m_next)
+	variable->m_target = h;
+    variable->m_target = 0;
+    GCManager::setDeferredRefCounting(false);
+    bool intact = true;
+    for (Holder* h = chain; h; h = h->m_next)
+	intact = intact && h->refCount() == 1;
+    cout << "Reference counts intact after rebinding through "
+	 << chain_length << " nodes: " << yesno(intact) << '\n';
+    return 0;
+}
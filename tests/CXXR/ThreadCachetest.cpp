@@ -0,0 +1,164 @@
+/*CXXR $Id$
+ *CXXR
+ *CXXR This file is part of CXXR, a project to refactor the R interpreter
+ *CXXR into C++.  It may consist in whole or in part of program code and
+ *CXXR documentation taken from the R project itself, incorporated into
+ *CXXR CXXR (and possibly MODIFIED) under the terms of the GNU General Public
+ *CXXR Licence.
+ *CXXR
+ *CXXR CXXR is Copyright (C) 2008-14 Andrew R. Runnalls, subject to such other
+ *CXXR copyrights and copyright restrictions as may be stated below.
+ *CXXR
+ *CXXR CXXR is not part of the R project, and bugs and other issues should
+ *CXXR not be reported via r-bugs or other R project channels; instead refer
+ *CXXR to the CXXR website.
+ *CXXR */
+
+/** @file ThreadCachetest.cpp
+ *
+ * Test of class CXXR::MemoryBank::ThreadCache.  Several threads
+ * allocate and deallocate blocks concurrently, including blocks
+ * allocated by other threads.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <pthread.h>
+#include "CXXR/MemoryBank.hpp"
+
+using namespace std;
+using namespace CXXR;
+
+namespace {
+    struct Block {
+	size_t size;
+	unsigned char* ptr;
+
+	Block(size_t sz, unsigned char* p)
+	    : size(sz), ptr(p)
+	{}
+    };
+
+    // main_blocks[i] holds blocks allocated by the main thread for
+    // release by worker i; worker_blocks[i] holds blocks allocated by
+    // worker i for release by the main thread.
+    vector<vector<Block> > main_blocks, worker_blocks;
+
+    unsigned int num_allocs;
+
+    unsigned int corrupted = 0;
+
+    pthread_mutex_t corrupted_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+    // Crude congruential generator in range 0 to 1023; repeatability
+    // on different platforms is more important than randomness!
+    size_t qrnd(size_t& r)
+    {
+	size_t ans = r;
+	r = (r*633 + 633)&0x3ff;
+	return ans;
+    }
+
+    Block alloc(size_t bytes, unsigned char fill)
+    {
+	unsigned char* p
+	    = static_cast<unsigned char*>(MemoryBank::allocate(bytes));
+	memset(p, fill, bytes);
+	return Block(bytes, p);
+    }
+
+    void release(const Block& blk, unsigned char fill)
+    {
+	for (size_t i = 0; i < blk.size; ++i)
+	    if (blk.ptr[i] != fill) {
+		pthread_mutex_lock(&corrupted_mutex);
+		++corrupted;
+		pthread_mutex_unlock(&corrupted_mutex);
+		break;
+	    }
+	MemoryBank::deallocate(blk.ptr, blk.size);
+    }
+
+    void* work(void* arg)
+    {
+	size_t id = reinterpret_cast<size_t>(arg);
+	unsigned char fill = static_cast<unsigned char>(id + 1);
+	MemoryBank::ThreadCache cache;
+	size_t r = id;
+	vector<Block> mine;
+	for (unsigned int i = 0; i < num_allocs; ++i) {
+	    size_t rnd = qrnd(r);
+	    if (rnd & 3 || mine.empty())
+		mine.push_back(alloc(rnd/4, fill));
+	    else {
+		size_t k = rnd*mine.size()/1024;
+		release(mine[k], fill);
+		mine[k] = mine.back();
+		mine.pop_back();
+	    }
+	}
+	// Release the blocks donated by the main thread:
+	for (size_t k = 0; k < main_blocks[id].size(); ++k)
+	    release(main_blocks[id][k], 0);
+	// Leave a few blocks for the main thread to release:
+	while (mine.size() > 100) {
+	    release(mine.back(), fill);
+	    mine.pop_back();
+	}
+	worker_blocks[id] = mine;
+	return 0;
+    }
+
+    void report(const char* when)
+    {
+	cout << when << ": blocks allocated " << MemoryBank::blocksAllocated()
+	     << ", bytes allocated " << MemoryBank::bytesAllocated() << endl;
+    }
+
+    void usage(const char* cmd)
+    {
+	cerr << "Usage: " << cmd << " num_threads num_allocs\n";
+	exit(1);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3)
+	usage(argv[0]);
+    unsigned int num_threads;
+    {
+	istringstream is(argv[1]);
+	if (!(is >> num_threads))
+	    usage(argv[0]);
+    }
+    {
+	istringstream is(argv[2]);
+	if (!(is >> num_allocs))
+	    usage(argv[0]);
+    }
+    main_blocks.resize(num_threads);
+    worker_blocks.resize(num_threads);
+    {
+	size_t r = 0;
+	for (unsigned int i = 0; i < num_threads; ++i)
+	    for (unsigned int j = 0; j < 100; ++j)
+		main_blocks[i].push_back(alloc(qrnd(r)/4, 0));
+    }
+    report("Before threads");
+    vector<pthread_t> threads(num_threads);
+    for (unsigned int i = 0; i < num_threads; ++i)
+	pthread_create(&threads[i], 0, work,
+		       reinterpret_cast<void*>(size_t(i)));
+    for (unsigned int i = 0; i < num_threads; ++i)
+	pthread_join(threads[i], 0);
+    report("After threads");
+    for (unsigned int i = 0; i < num_threads; ++i)
+	for (size_t k = 0; k < worker_blocks[i].size(); ++k)
+	    release(worker_blocks[i][k], static_cast<unsigned char>(i + 1));
+    report("At end");
+    cout << "Corrupted blocks: " << corrupted << endl;
+    return 0;
+}